@@ -0,0 +1,201 @@
+// 解码多线程基准：同一文件在各线程数和线程方式下的解码速度和附加延迟
+// 用法：bench_decoderthreads <视频文件> [最多帧数，默认600]
+// 测试文件可用 data/generate_test_video.sh 生成；libx264 默认每帧一个slice，片级多线程不生效，
+// 对比片级多线程时用 -x264-params slices=4 重新编码。
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+}
+
+namespace {
+// 线程数，0 表示由FFmpeg按CPU核数决定
+const int kThreadCounts[] = { 1, 2, 4, 8, 0 };
+
+struct Result {
+    int frames;
+    double fps;
+    int delayFrames;          // 输出第一帧前送入的packet数减一，即解码器滞留的帧数（含B帧重排）
+    double meanLatencyMs;     // 送入packet到取出对应帧的平均耗时（不含结尾排空）
+    int activeType;
+};
+
+double nowMs()
+{
+    using namespace std::chrono;
+    return duration<double, std::milli>(steady_clock::now().time_since_epoch()).count();
+}
+
+const char *typeName(int type)
+{
+    if (type & FF_THREAD_FRAME) {
+        return "frame";
+    }
+    return type & FF_THREAD_SLICE ? "slice" : "none";
+}
+
+// 预先读入视频packet，计时只包含解码；pts 改为解码顺序的序号，用于把输出帧对应回送入时刻
+bool loadPackets(const char *path, int maxFrames, AVCodecParameters *params, AVRational *frameRate,
+                 std::vector<AVPacket *> *packets)
+{
+    AVFormatContext *format = nullptr;
+    if (avformat_open_input(&format, path, nullptr, nullptr) < 0) {
+        std::fprintf(stderr, "cannot open %s\n", path);
+        return false;
+    }
+    if (avformat_find_stream_info(format, nullptr) < 0) {
+        avformat_close_input(&format);
+        std::fprintf(stderr, "cannot read stream info\n");
+        return false;
+    }
+
+    const int streamIndex = av_find_best_stream(format, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+    if (streamIndex < 0) {
+        avformat_close_input(&format);
+        std::fprintf(stderr, "no video stream\n");
+        return false;
+    }
+    AVStream *stream = format->streams[streamIndex];
+    avcodec_parameters_copy(params, stream->codecpar);
+    *frameRate = av_guess_frame_rate(format, stream, nullptr);
+
+    AVPacket *packet = av_packet_alloc();
+    while (static_cast<int>(packets->size()) < maxFrames && av_read_frame(format, packet) >= 0) {
+        if (packet->stream_index == streamIndex) {
+            packet->pts = packet->dts = static_cast<int64_t>(packets->size());
+            packets->push_back(av_packet_clone(packet));
+        }
+        av_packet_unref(packet);
+    }
+    av_packet_free(&packet);
+    avformat_close_input(&format);
+    return !packets->empty();
+}
+
+bool runCase(const AVCodecParameters *params, const std::vector<AVPacket *> &packets,
+             int threadCount, int threadType, Result *result)
+{
+    const AVCodec *codec = avcodec_find_decoder(params->codec_id);
+    AVCodecContext *context = codec ? avcodec_alloc_context3(codec) : nullptr;
+    if (!context || avcodec_parameters_to_context(context, params) < 0) {
+        avcodec_free_context(&context);
+        return false;
+    }
+    context->thread_count = threadCount;
+    context->thread_type = threadType;
+    if (avcodec_open2(context, codec, nullptr) < 0) {
+        avcodec_free_context(&context);
+        return false;
+    }
+
+    AVFrame *frame = av_frame_alloc();
+    std::vector<double> sendTimes(packets.size(), 0.0);
+    int received = 0;
+    int latencySamples = 0;
+    double latencyTotalMs = 0.0;
+    result->delayFrames = -1;
+
+    const double start = nowMs();
+    for (size_t i = 0; i <= packets.size(); ++i) {
+        // 最后送入空packet排空解码器
+        const bool draining = i == packets.size();
+        if (!draining) {
+            sendTimes[i] = nowMs();
+        }
+
+        // 输出已满（EAGAIN）时先取出帧再重新送入
+        int ret;
+        do {
+            ret = avcodec_send_packet(context, draining ? nullptr : packets[i]);
+            while (avcodec_receive_frame(context, frame) >= 0) {
+                if (result->delayFrames < 0) {
+                    result->delayFrames = static_cast<int>(i);
+                }
+                const int64_t index = frame->pts;
+                if (!draining && index >= 0 && index < static_cast<int64_t>(sendTimes.size())) {
+                    latencyTotalMs += nowMs() - sendTimes[index];
+                    latencySamples++;
+                }
+                received++;
+                av_frame_unref(frame);
+            }
+        } while (ret == AVERROR(EAGAIN));
+    }
+    const double elapsedMs = nowMs() - start;
+
+    result->frames = received;
+    result->fps = received * 1000.0 / std::max(elapsedMs, 0.001);
+    result->meanLatencyMs = latencySamples > 0 ? latencyTotalMs / latencySamples : 0.0;
+    result->activeType = context->active_thread_type;
+    if (result->delayFrames < 0) {
+        result->delayFrames = static_cast<int>(packets.size());
+    }
+
+    av_frame_free(&frame);
+    avcodec_free_context(&context);
+    return true;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <video file> [max frames]\n", argv[0]);
+        return 1;
+    }
+    const int maxFrames = argc > 2 ? std::max(1, std::atoi(argv[2])) : 600;
+
+    AVCodecParameters *params = avcodec_parameters_alloc();
+    AVRational frameRate = { 0, 1 };
+    std::vector<AVPacket *> packets;
+    if (!loadPackets(argv[1], maxFrames, params, &frameRate, &packets)) {
+        avcodec_parameters_free(&params);
+        return 1;
+    }
+
+    // 帧级多线程滞留的帧在实时流中按源帧间隔转化为延迟
+    const double frameIntervalMs = frameRate.num > 0 ? 1000.0 * frameRate.den / frameRate.num : 1000.0 / 30.0;
+    std::printf("%s: %s %dx%d, %zu packets, %.2f fps source\n\n",
+                argv[1], avcodec_get_name(params->codec_id), params->width, params->height,
+                packets.size(), 1000.0 / frameIntervalMs);
+    std::printf("%-7s %-6s %-7s %9s %10s %7s %14s %13s\n",
+                "threads", "type", "active", "fps", "ms/frame", "delay", "delay latency", "mean latency");
+
+    const int threadTypes[] = { FF_THREAD_FRAME, FF_THREAD_SLICE };
+    for (int threadCount : kThreadCounts) {
+        for (int threadType : threadTypes) {
+            // 单线程时线程方式无意义，只测一次作为基线
+            if (threadCount == 1 && threadType != FF_THREAD_FRAME) {
+                continue;
+            }
+
+            Result result;
+            if (!runCase(params, packets, threadCount, threadType, &result)) {
+                std::fprintf(stderr, "cannot open decoder\n");
+                avcodec_parameters_free(&params);
+                return 1;
+            }
+
+            char threads[16] = "auto";
+            if (threadCount > 0) {
+                std::snprintf(threads, sizeof(threads), "%d", threadCount);
+            }
+            std::printf("%-7s %-6s %-7s %9.1f %10.3f %7d %11.1f ms %10.2f ms\n",
+                        threads, threadCount == 1 ? "-" : typeName(threadType), typeName(result.activeType),
+                        result.fps, 1000.0 / result.fps, result.delayFrames,
+                        result.delayFrames * frameIntervalMs, result.meanLatencyMs);
+        }
+    }
+
+    for (AVPacket *packet : packets) {
+        av_packet_free(&packet);
+    }
+    avcodec_parameters_free(&params);
+    return 0;
+}
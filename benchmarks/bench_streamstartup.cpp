@@ -0,0 +1,124 @@
+// 启动耗时基准：同一实时流地址使用探测缓存（跳过 avformat_find_stream_info）与完整探测的首帧耗时对比
+// 用法：bench_streamstartup <实时流地址> [每种方式的次数，默认10]
+// 例如先用 mediakit 推流：mediakit -p rtsp -f data/test_testsrc_1280x720_30fps.mp4 -u rtsp://localhost:8554/test
+// 本地文件不使用探测缓存，必须是网络地址。
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QTimer>
+#include <QVector>
+#include <algorithm>
+#include <cstdio>
+#include "videodecoder.h"
+
+namespace {
+// 单次启动的超时（毫秒）
+const int kRunTimeoutMs = 15000;
+
+struct Run {
+    qint64 openMs = -1;          // openStream 到 streamOpened（连接 + 探测或套用缓存 + 打开解码器）
+    qint64 firstFrameMs = -1;    // openStream 到第一帧 frameReady
+    bool rejected = false;       // 缓存与码流不符，回退到了完整探测
+    QVariantMap probedInfo;
+};
+
+Run startOnce(const QString &url, const QVariantMap &cachedInfo)
+{
+    Run run;
+    VideoDecoder decoder;
+    decoder.setCachedStreamInfo(cachedInfo);
+
+    QEventLoop loop;
+    QElapsedTimer timer;
+    QObject::connect(&decoder, &VideoDecoder::streamOpened, &loop, [&]() {
+        run.openMs = timer.elapsed();
+    });
+    QObject::connect(&decoder, &VideoDecoder::frameReady, &loop, [&]() {
+        if (run.firstFrameMs < 0) {
+            run.firstFrameMs = timer.elapsed();
+            loop.quit();
+        }
+    });
+    QObject::connect(&decoder, &VideoDecoder::streamInfoProbed, &loop, [&](const QString &, const QVariantMap &info) {
+        run.probedInfo = info;
+    });
+    QObject::connect(&decoder, &VideoDecoder::streamInfoRejected, &loop, [&]() {
+        run.rejected = true;
+    });
+    QObject::connect(&decoder, &VideoDecoder::errorOccurred, &loop, [&](const QString &error) {
+        std::fprintf(stderr, "error: %s\n", qPrintable(error));
+        loop.quit();
+    });
+    QTimer::singleShot(kRunTimeoutMs, &loop, &QEventLoop::quit);
+
+    timer.start();
+    if (decoder.openStream(url)) {
+        loop.exec();
+    }
+    decoder.closeStream();
+    return run;
+}
+
+void printSummary(const char *name, const QVector<Run> &runs)
+{
+    QVector<qint64> open;
+    QVector<qint64> firstFrame;
+    int rejected = 0;
+    for (const Run &run : runs) {
+        if (run.firstFrameMs >= 0) {
+            open.append(run.openMs);
+            firstFrame.append(run.firstFrameMs);
+        }
+        rejected += run.rejected ? 1 : 0;
+    }
+    if (firstFrame.isEmpty()) {
+        std::printf("%-8s no successful runs\n", name);
+        return;
+    }
+
+    std::sort(open.begin(), open.end());
+    std::sort(firstFrame.begin(), firstFrame.end());
+    const int n = firstFrame.size();
+    std::printf("%-8s runs %2d  open median %5lld ms  first frame median %5lld ms  min %5lld  max %5lld%s\n",
+                name, n, static_cast<long long>(open[n / 2]), static_cast<long long>(firstFrame[n / 2]),
+                static_cast<long long>(firstFrame.first()), static_cast<long long>(firstFrame.last()),
+                rejected ? qPrintable(QString("  (cache rejected %1x)").arg(rejected)) : "");
+}
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+    if (args.size() < 2) {
+        std::fprintf(stderr, "usage: %s <live stream url> [runs per mode]\n", qPrintable(args.value(0)));
+        return 1;
+    }
+    const QString url = args.at(1);
+    const int runsPerMode = args.size() > 2 ? qMax(1, args.at(2).toInt()) : 10;
+
+    // 第一次完整探测得到缓存参数，与 ConfigManager 保存的内容相同
+    const Run warmup = startOnce(url, QVariantMap());
+    if (warmup.probedInfo.isEmpty()) {
+        std::fprintf(stderr, "full probe did not produce stream parameters (not a live source?)\n");
+        return 1;
+    }
+
+    // 两种方式交替进行，服务端和网络状态的变化对两者影响相同
+    QVector<Run> probeRuns;
+    QVector<Run> cachedRuns;
+    for (int i = 0; i < runsPerMode; ++i) {
+        probeRuns.append(startOnce(url, QVariantMap()));
+        cachedRuns.append(startOnce(url, warmup.probedInfo));
+        std::printf("run %2d: probe %5lld ms, cached %5lld ms%s\n", i + 1,
+                    static_cast<long long>(probeRuns.last().firstFrameMs),
+                    static_cast<long long>(cachedRuns.last().firstFrameMs),
+                    cachedRuns.last().rejected ? " (cache rejected)" : "");
+    }
+
+    std::printf("\n");
+    printSummary("probe", probeRuns);
+    printSummary("cached", cachedRuns);
+    return 0;
+}
@@ -0,0 +1,136 @@
+// 颜色转换基准：YuvConvert 各内核（单线程）对比原先的 sws_scale 路径
+// 用法：bench_yuvconvert [每项帧数，默认200]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "yuvconvert.h"
+
+extern "C" {
+#include <libavutil/frame.h>
+#include <libswscale/swscale.h>
+}
+
+namespace {
+struct Case {
+    const char *name;
+    int width;
+    int height;
+    AVPixelFormat format;
+    YuvConvert::Layout layout;
+};
+
+const Case kCases[] = {
+    { "720p  yuv420p", 1280, 720, AV_PIX_FMT_YUV420P, YuvConvert::LayoutI420 },
+    { "1080p yuv420p", 1920, 1080, AV_PIX_FMT_YUV420P, YuvConvert::LayoutI420 },
+    { "1080p nv12", 1920, 1080, AV_PIX_FMT_NV12, YuvConvert::LayoutNV12 },
+    { "1080p yuv422p", 1920, 1080, AV_PIX_FMT_YUV422P, YuvConvert::LayoutI422 },
+    { "4K    yuv420p", 3840, 2160, AV_PIX_FMT_YUV420P, YuvConvert::LayoutI420 },
+};
+
+double nowMs()
+{
+    using namespace std::chrono;
+    return duration<double, std::milli>(steady_clock::now().time_since_epoch()).count();
+}
+
+// 与解码输出相同的对齐方式分配源帧，填充伪随机数据
+AVFrame *makeFrame(const Case &c)
+{
+    AVFrame *frame = av_frame_alloc();
+    frame->width = c.width;
+    frame->height = c.height;
+    frame->format = c.format;
+    if (av_frame_get_buffer(frame, 0) < 0) {
+        av_frame_free(&frame);
+        return nullptr;
+    }
+
+    uint32_t state = 1;
+    for (int i = 0; i < 4 && frame->buf[i]; ++i) {
+        for (size_t j = 0; j < static_cast<size_t>(frame->buf[i]->size); ++j) {
+            state = state * 1664525u + 1013904223u;
+            frame->buf[i]->data[j] = static_cast<uint8_t>(state >> 24);
+        }
+    }
+    return frame;
+}
+
+void printRow(const char *name, const char *backend, double msPerFrame, double baselineMs)
+{
+    std::printf("%-14s %-8s %8.3f ms/frame %8.1f fps   x%.2f\n",
+                name, backend, msPerFrame, 1000.0 / msPerFrame, baselineMs / msPerFrame);
+}
+}
+
+int main(int argc, char *argv[])
+{
+    const int iterations = argc > 1 ? std::max(1, std::atoi(argv[1])) : 200;
+    std::printf("frames per case: %d (single thread)\n\n", iterations);
+
+    for (const Case &c : kCases) {
+        AVFrame *frame = makeFrame(c);
+        if (!frame) {
+            std::fprintf(stderr, "%s: cannot allocate frame\n", c.name);
+            return 1;
+        }
+
+        const int dstLinesize = c.width * 4;
+        std::vector<uint8_t> dst(static_cast<size_t>(dstLinesize) * c.height);
+
+        // 原路径：SWS_BILINEAR 到 RGB32，颜色矩阵与 FrameConverter 一致（BT.709 有限范围）
+        SwsContext *sws = sws_getContext(c.width, c.height, c.format,
+                                         c.width, c.height, AV_PIX_FMT_RGB32,
+                                         SWS_BILINEAR, nullptr, nullptr, nullptr);
+        if (!sws) {
+            std::fprintf(stderr, "%s: cannot create sws context\n", c.name);
+            return 1;
+        }
+        const int *coefficients = sws_getCoefficients(SWS_CS_ITU709);
+        sws_setColorspaceDetails(sws, coefficients, 0, coefficients, 1, 0, 1 << 16, 1 << 16);
+
+        uint8_t *dstData[4] = { dst.data(), nullptr, nullptr, nullptr };
+        int dstLinesizes[4] = { dstLinesize, 0, 0, 0 };
+        sws_scale(sws, frame->data, frame->linesize, 0, c.height, dstData, dstLinesizes);
+        double start = nowMs();
+        for (int i = 0; i < iterations; ++i) {
+            sws_scale(sws, frame->data, frame->linesize, 0, c.height, dstData, dstLinesizes);
+        }
+        const double swsMs = (nowMs() - start) / iterations;
+        sws_freeContext(sws);
+        printRow(c.name, "swscale", swsMs, swsMs);
+
+        YuvConvert::Source source;
+        for (int i = 0; i < 3; ++i) {
+            source.data[i] = frame->data[i];
+            source.linesize[i] = frame->linesize[i];
+        }
+        source.width = c.width;
+        source.height = c.height;
+        source.layout = c.layout;
+        const YuvConvert::Coefficients coeffs = YuvConvert::makeCoefficients(YuvConvert::MatrixBT709, false);
+
+        const YuvConvert::Kernel kernels[] = {
+            YuvConvert::KernelScalar, YuvConvert::KernelSSE2,
+            YuvConvert::KernelAVX2, YuvConvert::KernelNEON
+        };
+        for (YuvConvert::Kernel kernel : kernels) {
+            const YuvConvert::ConvertRowsFn convertRows = YuvConvert::kernel(kernel);
+            if (!convertRows) {
+                continue;
+            }
+            convertRows(source, coeffs, dst.data(), dstLinesize, 0, c.height);
+            start = nowMs();
+            for (int i = 0; i < iterations; ++i) {
+                convertRows(source, coeffs, dst.data(), dstLinesize, 0, c.height);
+            }
+            printRow(c.name, YuvConvert::kernelName(kernel), (nowMs() - start) / iterations, swsMs);
+        }
+        std::printf("\n");
+
+        av_frame_free(&frame);
+    }
+    return 0;
+}
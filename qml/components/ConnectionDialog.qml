@@ -174,6 +174,26 @@ Window {
                 color: "#888"
                 Layout.leftMargin: 90
             }
+
+            // 接入配置（按地址保存）
+            RowLayout {
+                Layout.fillWidth: true
+                spacing: 10
+
+                Label {
+                    text: "接入模式:"
+                    Layout.preferredWidth: 80
+                }
+
+                ComboBox {
+                    id: ingestProfileCombo
+                    Layout.fillWidth: true
+                    model: cfgMgr ? cfgMgr.ingestProfiles : []
+                    textRole: "label"
+                    valueRole: "name"
+                    currentIndex: cfgMgr ? indexOfValue(cfgMgr.ingestProfile(deviceAddressCombo.editText)) : -1
+                }
+            }
         }
 
         // 网络VTX配置区域
@@ -332,6 +352,7 @@ Window {
                         connMgr.connectionType = 0
                         cfgMgr.lastDeviceAddress = address
                         cfgMgr.addNetworkAddress(address)
+                        cfgMgr.setIngestProfile(address, ingestProfileCombo.currentValue)
                         connMgr.connectToDevice()
                     }
                 } else if (connectionTypeCombo.currentIndex === 1) {
@@ -342,6 +342,29 @@ Rectangle {
                             font.pixelSize: 10
                             Layout.alignment: Qt.AlignVCenter
                         }
+
+                        // 分隔符
+                        Label {
+                            text: "|"
+                            color: "#555555"
+                            font.pixelSize: 10
+                            visible: transportLabel.visible
+                        }
+
+                        // RTSP传输方式及丢包/乱序（UDP时统计）
+                        Label {
+                            id: transportLabel
+                            text: videoHandler ? (videoHandler.transport.toUpperCase()
+                                                  + (videoHandler.transport === "udp"
+                                                     ? "  丢包: " + videoHandler.rtpLostPackets
+                                                       + " (" + (videoHandler.rtpLossRate * 100).toFixed(1) + "%)"
+                                                       + "  乱序: " + videoHandler.rtpReorderedPackets
+                                                     : "")) : ""
+                            color: videoHandler && videoHandler.rtpLossRate > 0.01 ? "#FFC107" : "#4CAF50"
+                            font.pixelSize: 10
+                            visible: videoHandler && videoHandler.isPlaying && videoHandler.transport !== ""
+                            Layout.alignment: Qt.AlignVCenter
+                        }
                     }
 
                     // 定时器更新连接时长
@@ -71,6 +71,28 @@ Rectangle {
         visible: !root.isPlaying
     }
 
+    // 连接状态（流在后台线程打开期间显示）
+    Column {
+        anchors.centerIn: parent
+        spacing: 10
+        z: 2
+        // 1: 连接中  2: 探测流信息
+        visible: root.isPlaying && videoHandler
+                 && (videoHandler.streamState === 1 || videoHandler.streamState === 2)
+
+        BusyIndicator {
+            anchors.horizontalCenter: parent.horizontalCenter
+            running: parent.visible
+        }
+
+        Label {
+            anchors.horizontalCenter: parent.horizontalCenter
+            text: videoHandler && videoHandler.streamState === 2 ? "正在获取流信息..." : "正在连接..."
+            font.pixelSize: 14
+            color: "#cccccc"
+        }
+    }
+
     // 视频信息叠加层（左上角）
     Rectangle {
         anchors.left: parent.left
@@ -93,11 +115,94 @@ Rectangle {
                 font.pixelSize: 12
             }
 
+            Label {
+                text: videoHandler ? ("首帧耗时: " + videoHandler.timeToFirstFrameMs + "ms") : ""
+                color: "#ffffff"
+                font.pixelSize: 12
+                visible: videoHandler && videoHandler.timeToFirstFrameMs >= 0
+            }
+
             Label {
                 text: "比例: " + (root.aspectRatio === 16/9 ? "16:9" : "4:3")
                 color: "#ffffff"
                 font.pixelSize: 12
             }
+
+            Label {
+                text: videoHandler ? ("队列: " + videoHandler.packetQueueDepth + "/" + videoHandler.packetQueueCapacity
+                                      + "  丢包: " + videoHandler.droppedPackets
+                                      + "  丢帧: " + videoHandler.droppedFrames
+                                      + "  解码延迟: " + videoHandler.decoderDelayFrames + "帧") : ""
+                color: "#ffffff"
+                font.pixelSize: 12
+            }
+
+            // 流水线指标（最近一个统计周期的分布）
+            Label {
+                property var histograms: videoHandler && videoHandler.metrics.histograms
+                                         ? videoHandler.metrics.histograms : null
+                text: histograms ? ("抖动 p95: " + histograms.arrivalJitter.p95.toFixed(1) + "ms"
+                                    + "  解码 p95: " + histograms.decodeTime.p95.toFixed(1) + "ms"
+                                    + "  转换 p95: " + histograms.convertTime.p95.toFixed(1) + "ms"
+                                    + "  渲染间隔 p50/p95: " + histograms.renderInterval.p50.toFixed(1)
+                                    + "/" + histograms.renderInterval.p95.toFixed(1) + "ms") : ""
+                color: "#ffffff"
+                font.pixelSize: 12
+                visible: histograms !== null
+            }
+
+            Label {
+                text: videoHandler ? ("● 录像: " + Math.floor(videoHandler.recordingDurationMs / 60000) + ":"
+                                      + ("0" + Math.floor(videoHandler.recordingDurationMs / 1000) % 60).slice(-2)
+                                      + "  " + (videoHandler.recordingBytes / 1048576).toFixed(1) + "MB") : ""
+                color: "#ff5252"
+                font.pixelSize: 12
+                visible: videoHandler && videoHandler.isRecording
+            }
+
+            Label {
+                text: videoHandler ? ("回放缓冲: " + (videoHandler.replayBufferDurationMs / 1000).toFixed(1) + "s"
+                                      + "  " + (videoHandler.replayBufferBytes / 1048576).toFixed(1) + "MB"
+                                      + " / " + (videoHandler.replayBufferMemory / 1048576).toFixed(1) + "MB") : ""
+                color: "#ffffff"
+                font.pixelSize: 12
+                visible: videoHandler && videoHandler.replayBufferDurationMs > 0
+            }
+
+            Label {
+                text: videoHandler ? ("重连: " + videoHandler.reconnectCount + "次"
+                                      + (videoHandler.reconnectTimeMs >= 0
+                                         ? "  恢复耗时: " + videoHandler.reconnectTimeMs + "ms" : "")) : ""
+                color: "#ffffff"
+                font.pixelSize: 12
+                visible: videoHandler && videoHandler.reconnectCount > 0
+            }
+
+            // 端到端延迟（发送端嵌入时间戳SEI时显示），各阶段 p50/p95/p99
+            Column {
+                spacing: 2
+                visible: videoHandler && videoHandler.latency.total !== undefined
+
+                Repeater {
+                    model: [
+                        { key: "total", label: "端到端" },
+                        { key: "network", label: "网络" },
+                        { key: "queue", label: "队列" },
+                        { key: "decode", label: "解码" },
+                        { key: "convert", label: "转换" },
+                        { key: "present", label: "呈现" }
+                    ]
+
+                    Label {
+                        property var stage: videoHandler ? videoHandler.latency[modelData.key] : undefined
+                        text: stage ? (modelData.label + " p50/p95/p99: "
+                                       + stage.p50.toFixed(1) + " / " + stage.p95.toFixed(1)
+                                       + " / " + stage.p99.toFixed(1) + " ms") : ""
+                        color: modelData.key === "total" ? "#ffd54f" : "#ffffff"
+                        font.pixelSize: 12
+                    }
+                }
+            }
         }
     }
 
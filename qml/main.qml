@@ -18,6 +18,7 @@ ApplicationWindow {
     property real videoAspectRatio: 16/9
     property bool isConnected: connectionManager.isConnected
     property bool isRecording: videoHandler.isRecording
+    property int burstSeconds: 5
 
     // 菜单栏
     menuBar: MenuBar {
@@ -55,11 +56,51 @@ ApplicationWindow {
                 enabled: isConnected && !isRecording
                 onTriggered: recordDialog.open()
             }
+            MenuItem {
+                text: "保存最近 " + videoHandler.replayBufferSeconds + " 秒"
+                enabled: isConnected && !isRecording && videoHandler.replayBufferDurationMs > 0
+                onTriggered: {
+                    var timestamp = Qt.formatDateTime(new Date(), "yyyyMMdd_HHmmss")
+                    var filePath = "replay_" + timestamp + ".mp4"
+                    videoHandler.saveReplay(filePath)
+                    messageLogger.addInfoMessage("保存回放并继续录像: " + filePath)
+                }
+            }
             MenuItem {
                 text: "截图"
                 enabled: isConnected
                 onTriggered: screenshotDialog.open()
             }
+            MenuItem {
+                text: "连拍 " + burstSeconds + " 秒"
+                enabled: isConnected && !videoHandler.isBursting
+                onTriggered: {
+                    var timestamp = Qt.formatDateTime(new Date(), "yyyyMMdd_HHmmss")
+                    videoHandler.startBurst(burstSeconds, "burst_" + timestamp + ".png")
+                    messageLogger.addInfoMessage("开始连拍 " + burstSeconds + " 秒")
+                }
+            }
+            MenuItem {
+                text: clipExporter.running ? "导出片段（" + Math.round(clipExporter.progress * 100) + "%）" : "导出片段..."
+                onTriggered: clipDialog.open()
+            }
+            MenuItem {
+                text: "导出性能跟踪"
+                onTriggered: {
+                    var timestamp = Qt.formatDateTime(new Date(), "yyyyMMdd_HHmmss")
+                    var filePath = "trace_" + timestamp + ".json"
+                    if (videoHandler.saveTrace(filePath)) {
+                        messageLogger.addInfoMessage("性能跟踪已导出: " + filePath)
+                    }
+                }
+            }
+            MenuSeparator {}
+            MenuItem {
+                text: "平滑播放（按时间戳调度）"
+                checkable: true
+                checked: videoHandler.presentationMode === 1
+                onTriggered: videoHandler.presentationMode = checked ? 1 : 0
+            }
         }
 
         Menu {
@@ -192,17 +233,145 @@ ApplicationWindow {
             Label {
                 text: "截图将保存到图片目录"
             }
+            ComboBox {
+                id: screenshotFormat
+                Layout.fillWidth: true
+                // YUV 为解码输出的原始平面，不做颜色转换
+                model: [
+                    { text: "PNG（无损）", suffix: ".png" },
+                    { text: "JPEG", suffix: ".jpg" },
+                    { text: "WebP", suffix: ".webp" },
+                    { text: "原始 YUV", suffix: ".yuv" }
+                ]
+                textRole: "text"
+            }
         }
 
         standardButtons: Dialog.Ok | Dialog.Cancel
 
         onAccepted: {
             var timestamp = Qt.formatDateTime(new Date(), "yyyyMMdd_HHmmss")
-            var filePath = "screenshot_" + timestamp + ".png"
+            var filePath = "screenshot_" + timestamp + screenshotFormat.model[screenshotFormat.currentIndex].suffix
             videoHandler.takeScreenshot(filePath)
         }
     }
 
+    // 片段导出对话框
+    Dialog {
+        id: clipDialog
+        title: "导出片段"
+        modal: true
+        anchors.centerIn: parent
+        width: 420
+
+        ColumnLayout {
+            anchors.fill: parent
+            spacing: 10
+
+            Label {
+                text: "源文件:"
+            }
+
+            RowLayout {
+                Layout.fillWidth: true
+
+                TextField {
+                    id: clipSourceField
+                    Layout.fillWidth: true
+                    enabled: !clipExporter.running
+                    placeholderText: "录像文件路径"
+                }
+
+                Button {
+                    text: "浏览"
+                    enabled: !clipExporter.running
+                    onClicked: clipFileDialog.open()
+                }
+            }
+
+            RowLayout {
+                Layout.fillWidth: true
+                enabled: !clipExporter.running
+
+                Label {
+                    text: "开始(秒):"
+                }
+
+                TextField {
+                    id: clipStartField
+                    Layout.fillWidth: true
+                    text: "0"
+                    validator: DoubleValidator { bottom: 0 }
+                }
+
+                Label {
+                    text: "结束(秒):"
+                }
+
+                TextField {
+                    id: clipEndField
+                    Layout.fillWidth: true
+                    text: "60"
+                    validator: DoubleValidator { bottom: 0 }
+                }
+            }
+
+            // 默认开始和结束都对齐到关键帧；精确模式重新编码首尾GOP（仅 H.264/HEVC）
+            CheckBox {
+                id: clipPreciseCheck
+                text: "精确剪切（重新编码首尾 GOP）"
+                enabled: !clipExporter.running
+            }
+
+            ProgressBar {
+                Layout.fillWidth: true
+                visible: clipExporter.running
+                value: clipExporter.progress
+            }
+        }
+
+        footer: DialogButtonBox {
+            Button {
+                text: clipExporter.running ? "取消导出" : "导出"
+                DialogButtonBox.buttonRole: DialogButtonBox.ActionRole
+                enabled: clipExporter.running || clipSourceField.text.length > 0
+                onClicked: {
+                    if (clipExporter.running) {
+                        clipExporter.cancel()
+                        return
+                    }
+                    var startMs = Math.round(parseFloat(clipStartField.text) * 1000)
+                    var endMs = Math.round(parseFloat(clipEndField.text) * 1000)
+                    if (clipExporter.start(clipSourceField.text, "", startMs, endMs, clipPreciseCheck.checked)) {
+                        messageLogger.addInfoMessage("开始导出片段: " + clipSourceField.text
+                                                     + " " + clipStartField.text + "-" + clipEndField.text + " 秒")
+                    }
+                }
+            }
+            Button {
+                text: "关闭"
+                DialogButtonBox.buttonRole: DialogButtonBox.RejectRole
+            }
+        }
+    }
+
+    // 片段导出源文件选择对话框
+    FileDialog {
+        id: clipFileDialog
+        title: "选择要导出片段的视频文件"
+        nameFilters: ["视频文件 (*.mp4 *.avi *.mkv *.mov *.flv *.ts)", "所有文件 (*)"]
+        fileMode: FileDialog.OpenFile
+
+        onAccepted: {
+            var filePath = clipFileDialog.selectedFile.toString()
+            // 移除 "file://" 前缀 (Qt 6)
+            if (filePath.startsWith("file://")) {
+                filePath = filePath.substring(7)
+            }
+            clipSourceField.text = filePath
+        }
+    }
+
     // 配置对话框
     Dialog {
         id: configDialog
@@ -0,0 +1,30 @@
+#version 440
+
+layout(location = 0) in vec2 texCoord;
+
+layout(location = 0) out vec4 fragColor;
+
+layout(std140, binding = 0) uniform buf {
+    mat4 qt_Matrix;
+    mat4 colorMatrix;       // (Y, U, V, 1) -> RGB，包含范围偏移
+    float qt_Opacity;
+    int interleavedChroma;  // NV12：U/V 交错存放在 uTexture 的 R/G 通道
+};
+
+layout(binding = 1) uniform sampler2D yTexture;
+layout(binding = 2) uniform sampler2D uTexture;
+layout(binding = 3) uniform sampler2D vTexture;
+
+void main()
+{
+    float y = texture(yTexture, texCoord).r;
+    vec2 uv;
+    if (interleavedChroma != 0) {
+        uv = texture(uTexture, texCoord).rg;
+    } else {
+        uv = vec2(texture(uTexture, texCoord).r, texture(vTexture, texCoord).r);
+    }
+
+    vec4 rgb = colorMatrix * vec4(y, uv, 1.0);
+    fragColor = vec4(clamp(rgb.rgb, 0.0, 1.0), 1.0) * qt_Opacity;
+}
@@ -0,0 +1,291 @@
+#include "asyncfilewriter.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <limits>
+
+#if defined(Q_OS_LINUX)
+#include <fcntl.h>
+#include <unistd.h>
+#elif defined(Q_OS_WIN)
+#include <windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+// 积压上限：磁盘跟不上时封装线程在 write 中等待
+const qint64 kMaxBacklogBytes = 64LL * 1024 * 1024;
+
+// 预分配步长：文件空间按此粒度提前占用（不改变文件长度，崩溃后文件末尾没有空洞）
+const qint64 kPreallocStep = 64LL * 1024 * 1024;
+
+void updateMax(std::atomic<qint64> &target, qint64 value)
+{
+    qint64 current = target.load(std::memory_order_relaxed);
+    while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+}
+
+AsyncFileWriter::AsyncFileWriter()
+    : m_backlogBytes(0)
+    , m_finishing(false)
+    , m_failed(false)
+    , m_ioThread(nullptr)
+    , m_policy(SyncEveryFragment)
+    , m_allocatedBytes(0)
+    , m_bytesWritten(0)
+    , m_maxBacklogBytes(0)
+    , m_writeTimeUs(0)
+    , m_maxWriteUs(0)
+    , m_syncCount(0)
+    , m_maxSyncUs(0)
+{
+}
+
+AsyncFileWriter::~AsyncFileWriter()
+{
+    finish();
+}
+
+void AsyncFileWriter::start(SyncPolicy policy)
+{
+    finish();
+
+    m_policy = policy;
+    m_backlogBytes = 0;
+    m_finishing = false;
+    m_error.clear();
+    m_failed = false;
+    m_bytesWritten = 0;
+    m_maxBacklogBytes = 0;
+    m_writeTimeUs = 0;
+    m_maxWriteUs = 0;
+    m_syncCount = 0;
+    m_maxSyncUs = 0;
+
+    m_ioThread = QThread::create([this]() { ioLoop(); });
+    m_ioThread->setObjectName("VideoRecordIO");
+    m_ioThread->start();
+}
+
+void AsyncFileWriter::open(const QString &filePath)
+{
+    push({ Command::Open, filePath, 0, QByteArray() }, 0);
+}
+
+bool AsyncFileWriter::write(qint64 offset, const uint8_t *data, int size)
+{
+    if (m_failed) {
+        return false;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    while (m_backlogBytes + size > kMaxBacklogBytes && m_backlogBytes > 0 && !m_failed) {
+        m_spaceAvailable.wait(&m_mutex);
+    }
+    if (m_failed) {
+        return false;
+    }
+
+    m_commands.push_back({ Command::Write, QString(), offset,
+                           QByteArray(reinterpret_cast<const char *>(data), size) });
+    m_backlogBytes += size;
+    updateMax(m_maxBacklogBytes, m_backlogBytes);
+    m_commandAvailable.wakeOne();
+    return true;
+}
+
+void AsyncFileWriter::close()
+{
+    push({ Command::Close, QString(), 0, QByteArray() }, 0);
+}
+
+void AsyncFileWriter::finish()
+{
+    if (!m_ioThread) {
+        return;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_finishing = true;
+        m_commandAvailable.wakeOne();
+    }
+    m_ioThread->wait();
+    delete m_ioThread;
+    m_ioThread = nullptr;
+}
+
+QString AsyncFileWriter::errorString() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_error;
+}
+
+void AsyncFileWriter::push(Command &&command, qint64 bytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_commands.push_back(std::move(command));
+    m_backlogBytes += bytes;
+    m_commandAvailable.wakeOne();
+}
+
+void AsyncFileWriter::ioLoop()
+{
+    std::deque<Command> batch;
+    QString error;
+
+    forever {
+        {
+            QMutexLocker locker(&m_mutex);
+            while (m_commands.empty() && !m_finishing) {
+                m_commandAvailable.wait(&m_mutex);
+            }
+            if (m_commands.empty()) {
+                break;
+            }
+            batch.swap(m_commands);
+        }
+
+        // 一次处理积压的全部命令，失败后只丢弃数据，不再写入
+        qint64 batchBytes = 0;
+        bool wrote = false;
+        for (Command &command : batch) {
+            batchBytes += command.data.size();
+            if (!m_failed && !execute(command, &error)) {
+                QMutexLocker locker(&m_mutex);
+                m_error = error;
+                m_failed = true;
+            }
+            wrote = wrote || command.type == Command::Write;
+        }
+        batch.clear();
+
+        if (wrote && !m_failed && m_policy == SyncEveryFragment && m_file.isOpen() && !syncFile(&error)) {
+            QMutexLocker locker(&m_mutex);
+            m_error = error;
+            m_failed = true;
+        }
+
+        QMutexLocker locker(&m_mutex);
+        m_backlogBytes -= batchBytes;
+        m_spaceAvailable.wakeAll();
+    }
+
+    if (m_file.isOpen() && !closeFile(&error) && !m_failed) {
+        QMutexLocker locker(&m_mutex);
+        m_error = error;
+        m_failed = true;
+    }
+}
+
+bool AsyncFileWriter::execute(Command &command, QString *error)
+{
+    switch (command.type) {
+    case Command::Open:
+        if (m_file.isOpen() && !closeFile(error)) {
+            return false;
+        }
+        m_file.setFileName(command.path);
+        if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Unbuffered)) {
+            *error = QString("cannot open %1: %2").arg(command.path, m_file.errorString());
+            return false;
+        }
+        m_allocatedBytes = 0;
+        preallocate(kPreallocStep);
+        return true;
+
+    case Command::Write: {
+        if (!m_file.isOpen()) {
+            *error = "write error: file not open";
+            return false;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+
+        const qint64 end = command.offset + command.data.size();
+        if (end > m_allocatedBytes) {
+            preallocate(end + kPreallocStep);
+        }
+
+        // 封装器写尾部时会回到前面修改文件头
+        if (m_file.pos() != command.offset && !m_file.seek(command.offset)) {
+            *error = QString("seek error: %1").arg(m_file.errorString());
+            return false;
+        }
+        if (m_file.write(command.data) != command.data.size()) {
+            *error = QString("write error: %1").arg(m_file.errorString());
+            return false;
+        }
+
+        const qint64 elapsedUs = timer.nsecsElapsed() / 1000;
+        m_writeTimeUs += elapsedUs;
+        updateMax(m_maxWriteUs, elapsedUs);
+        m_bytesWritten += command.data.size();
+        return true;
+    }
+
+    case Command::Close:
+        return !m_file.isOpen() || closeFile(error);
+    }
+    return true;
+}
+
+bool AsyncFileWriter::closeFile(QString *error)
+{
+    bool ok = true;
+    if (m_policy != SyncNone) {
+        ok = syncFile(error);
+    }
+
+    // 释放预分配但没有用到的空间
+    m_file.resize(m_file.size());
+    m_file.close();
+    m_allocatedBytes = 0;
+    return ok;
+}
+
+bool AsyncFileWriter::syncFile(QString *error)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+#if defined(Q_OS_WIN)
+    const bool ok = _commit(m_file.handle()) == 0;
+#else
+    const bool ok = ::fsync(m_file.handle()) == 0;
+#endif
+    if (!ok) {
+        *error = QString("sync error: %1").arg(m_file.fileName());
+        return false;
+    }
+
+    const qint64 elapsedUs = timer.nsecsElapsed() / 1000;
+    m_syncCount++;
+    updateMax(m_maxSyncUs, elapsedUs);
+    return true;
+}
+
+void AsyncFileWriter::preallocate(qint64 end)
+{
+    // 只占用磁盘空间，不改变文件长度；文件系统不支持时忽略
+#if defined(Q_OS_LINUX)
+    if (fallocate(m_file.handle(), FALLOC_FL_KEEP_SIZE, 0, end) == 0) {
+        m_allocatedBytes = end;
+        return;
+    }
+#elif defined(Q_OS_WIN)
+    FILE_ALLOCATION_INFO info;
+    info.AllocationSize.QuadPart = end;
+    HANDLE handle = reinterpret_cast<HANDLE>(_get_osfhandle(m_file.handle()));
+    if (SetFileInformationByHandle(handle, FileAllocationInfo, &info, sizeof(info))) {
+        m_allocatedBytes = end;
+        return;
+    }
+#endif
+    // 不再尝试，避免每次写入都调用
+    m_allocatedBytes = std::numeric_limits<qint64>::max();
+}
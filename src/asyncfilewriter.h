@@ -0,0 +1,93 @@
+#ifndef ASYNCFILEWRITER_H
+#define ASYNCFILEWRITER_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QMutex>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+
+/**
+ * @brief 后台文件写入（录像的磁盘I/O线程）
+ * 封装线程只把数据块放入队列，打开、预分配、写入、fsync 和关闭都在I/O线程中完成，磁盘抖动不会阻塞封装。
+ * I/O线程每次唤醒写出积压的全部数据（批量写入），按同步策略在每批之后或关闭文件时 fsync。
+ * 积压超过上限时 write 等待，录像队列随之丢弃到关键帧，内存占用有界。
+ */
+class AsyncFileWriter
+{
+public:
+    // 同步策略：不主动同步 / 关闭文件时同步 / 每批写入后同步（分片封装时约为每个分片一次）
+    enum SyncPolicy {
+        SyncNone = 0,
+        SyncOnClose = 1,
+        SyncEveryFragment = 2
+    };
+
+    AsyncFileWriter();
+    ~AsyncFileWriter();
+
+    // 以下由同一个线程（封装线程）调用，命令按调用顺序执行
+    void start(SyncPolicy policy);
+    void open(const QString &filePath);
+    bool write(qint64 offset, const uint8_t *data, int size);
+    void close();
+
+    // 写完所有积压的数据、关闭文件并结束I/O线程
+    void finish();
+
+    // 写入失败后之后的数据全部丢弃，封装线程据此结束录制
+    bool hasError() const { return m_failed; }
+    QString errorString() const;
+
+    // 统计：写入磁盘的数据量、最大积压、写入/同步耗时
+    qint64 bytesWritten() const { return m_bytesWritten; }
+    qint64 maxBacklogBytes() const { return m_maxBacklogBytes; }
+    qint64 writeTimeMs() const { return m_writeTimeUs / 1000; }
+    qint64 maxWriteMs() const { return m_maxWriteUs / 1000; }
+    int syncCount() const { return m_syncCount; }
+    qint64 maxSyncMs() const { return m_maxSyncUs / 1000; }
+
+private:
+    struct Command {
+        enum Type { Open, Write, Close };
+        Type type;
+        QString path;
+        qint64 offset;
+        QByteArray data;
+    };
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_commandAvailable;
+    QWaitCondition m_spaceAvailable;
+    std::deque<Command> m_commands;
+    qint64 m_backlogBytes;
+    bool m_finishing;
+    QString m_error;
+    std::atomic<bool> m_failed;
+    QThread *m_ioThread;
+    SyncPolicy m_policy;
+
+    // 以下仅I/O线程访问
+    QFile m_file;
+    qint64 m_allocatedBytes;
+
+    std::atomic<qint64> m_bytesWritten;
+    std::atomic<qint64> m_maxBacklogBytes;
+    std::atomic<qint64> m_writeTimeUs;
+    std::atomic<qint64> m_maxWriteUs;
+    std::atomic<int> m_syncCount;
+    std::atomic<qint64> m_maxSyncUs;
+
+    void push(Command &&command, qint64 bytes);
+    void ioLoop();
+    bool execute(Command &command, QString *error);
+    bool closeFile(QString *error);
+    bool syncFile(QString *error);
+    void preallocate(qint64 end);
+};
+
+#endif // ASYNCFILEWRITER_H
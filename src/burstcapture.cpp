@@ -0,0 +1,147 @@
+#include "burstcapture.h"
+#include <QDebug>
+#include <cstring>
+
+extern "C" {
+#include <libavutil/imgutils.h>
+#include <libavutil/time.h>
+}
+
+BurstCapture::BurstCapture(int64_t durationUs)
+    : m_count(0)
+    , m_durationUs(durationUs)
+    , m_startUs(0)
+    , m_ready(false)
+    , m_finished(false)
+{
+}
+
+BurstCapture::~BurstCapture()
+{
+    for (AVFrame *frame : m_frames) {
+        av_frame_free(&frame);
+    }
+}
+
+void BurstCapture::setFinishedCallback(std::function<void()> callback)
+{
+    QMutexLocker locker(&m_mutex);
+    m_finishedCallback = std::move(callback);
+}
+
+bool BurstCapture::allocate(const AVFrame *format, int capacity)
+{
+    // 分配和首次写入（缺页）都在这里完成，采集时解码线程只做复制
+    QVector<AVFrame *> frames;
+    frames.reserve(capacity);
+    for (int i = 0; i < capacity; ++i) {
+        AVFrame *frame = av_frame_alloc();
+        if (!frame) {
+            break;
+        }
+        frame->format = format->format;
+        frame->width = format->width;
+        frame->height = format->height;
+        if (av_frame_get_buffer(frame, 0) < 0) {
+            av_frame_free(&frame);
+            break;
+        }
+        for (int plane = 0; plane < AV_NUM_DATA_POINTERS && frame->buf[plane]; ++plane) {
+            memset(frame->buf[plane]->data, 0, frame->buf[plane]->size);
+        }
+        frames.append(frame);
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_frames = frames;
+    if (m_frames.isEmpty() || m_finished) {
+        finishLocked();
+        return !m_frames.isEmpty();
+    }
+    m_startUs = av_gettime_relative();
+    m_ready = true;
+    qDebug() << "Burst capture ready:" << m_frames.size() << "frames," << m_durationUs / 1000 << "ms";
+    return true;
+}
+
+bool BurstCapture::append(const AVFrame *frame)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_finished) {
+        return false;
+    }
+    if (!m_ready) {
+        return true;
+    }
+
+    if (av_gettime_relative() - m_startUs >= m_durationUs) {
+        finishLocked();
+        return false;
+    }
+
+    // 分辨率或像素格式变化：已采集的帧保留，采集提前结束
+    AVFrame *target = m_frames[m_count];
+    if (frame->format != target->format || frame->width != target->width || frame->height != target->height) {
+        qDebug() << "Burst capture: frame format changed, stopping after" << m_count << "frames";
+        finishLocked();
+        return false;
+    }
+
+    if (av_frame_copy(target, frame) < 0) {
+        finishLocked();
+        return false;
+    }
+    av_frame_copy_props(target, frame);
+    m_count++;
+
+    if (m_count == m_frames.size()) {
+        finishLocked();
+        return false;
+    }
+    return true;
+}
+
+void BurstCapture::finish()
+{
+    QMutexLocker locker(&m_mutex);
+    finishLocked();
+}
+
+void BurstCapture::cancel()
+{
+    QMutexLocker locker(&m_mutex);
+    m_finishedCallback = nullptr;
+    finishLocked();
+}
+
+int BurstCapture::frameCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_count;
+}
+
+const AVFrame *BurstCapture::frame(int index) const
+{
+    QMutexLocker locker(&m_mutex);
+    return index >= 0 && index < m_count ? m_frames[index] : nullptr;
+}
+
+qint64 BurstCapture::frameBytes(const AVFrame *format)
+{
+    const int size = av_image_get_buffer_size(static_cast<AVPixelFormat>(format->format),
+                                              format->width, format->height, 1);
+    return qMax(size, 0);
+}
+
+void BurstCapture::finishLocked()
+{
+    if (m_finished) {
+        return;
+    }
+    m_finished = true;
+
+    if (m_finishedCallback) {
+        m_finishedCallback();
+        m_finishedCallback = nullptr;
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef BURSTCAPTURE_H
+#define BURSTCAPTURE_H
+
+#include <QMutex>
+#include <QVector>
+#include <QtGlobal>
+#include <functional>
+
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+/**
+ * @brief 连拍缓冲（在一段时间内保存每一帧解码输出，结束后再编码）
+ * 缓冲在工作线程中按当前帧的格式和尺寸一次性分配并预先写入，采集期间解码线程只做内存复制，
+ * 不分配内存也不编码。容量已满、时长已到或帧格式变化时采集结束，之后调用完成回调。
+ */
+class BurstCapture
+{
+public:
+    explicit BurstCapture(int64_t durationUs);
+    ~BurstCapture();
+
+    // 采集结束时调用（在结束采集的线程中、持锁调用，回调不能阻塞）
+    void setFinishedCallback(std::function<void()> callback);
+
+    // 工作线程：按模板帧分配 capacity 帧，完成后开始计时采集
+    bool allocate(const AVFrame *format, int capacity);
+
+    // 解码线程：复制一帧，返回 false 表示采集已结束，不再需要后续的帧
+    bool append(const AVFrame *frame);
+
+    // 任意线程：结束采集（多次调用只生效一次）
+    void finish();
+
+    // 任意线程：丢弃完成回调（回调的接收者即将销毁）并结束采集
+    void cancel();
+
+    // 采集结束后读取
+    int frameCount() const;
+    const AVFrame *frame(int index) const;
+
+    // 单帧所需内存（字节）
+    static qint64 frameBytes(const AVFrame *format);
+
+private:
+    mutable QMutex m_mutex;
+    QVector<AVFrame *> m_frames;
+    std::function<void()> m_finishedCallback;
+    int m_count;
+    int64_t m_durationUs;
+    int64_t m_startUs;
+    bool m_ready;
+    bool m_finished;
+
+    void finishLocked();
+};
+
+#endif // BURSTCAPTURE_H
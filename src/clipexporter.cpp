@@ -0,0 +1,800 @@
+#include "clipexporter.h"
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <cstring>
+#include "ffmpegerror.h"
+#include "seitimestamp.h"
+
+extern "C" {
+#include <libavutil/opt.h>
+}
+
+namespace {
+// 进度通知的最小变化（千分比）
+const int kProgressStep = 10;
+
+// 视频结束后继续读取其他流的最大距离，交织很差的文件不会一直读到结尾
+const int64_t kStreamEndMarginUs = 5000000;
+
+int64_t packetPts(const AVPacket *packet)
+{
+    return packet->pts != AV_NOPTS_VALUE ? packet->pts : packet->dts;
+}
+
+// Annex B（起始码分隔）转换为长度前缀的NAL单元，没有起始码时视为已是长度前缀形式
+bool annexbToLengthPrefixed(AVPacket *packet, int lengthSize)
+{
+    const uint8_t *data = packet->data;
+    const int size = packet->size;
+
+    QVector<QPair<int, int>> nals;
+    int nalStart = -1;
+    int i = 0;
+    while (i + 2 < size) {
+        if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1) {
+            if (nalStart >= 0) {
+                // 四字节起始码的第一个0和尾随的0不属于NAL
+                int end = i;
+                while (end > nalStart && data[end - 1] == 0) {
+                    end--;
+                }
+                nals.append(qMakePair(nalStart, end - nalStart));
+            }
+            i += 3;
+            nalStart = i;
+            continue;
+        }
+        i++;
+    }
+    if (nalStart < 0) {
+        return true;
+    }
+    nals.append(qMakePair(nalStart, size - nalStart));
+
+    int total = 0;
+    for (const QPair<int, int> &nal : nals) {
+        if (lengthSize < 4 && nal.second >= (1 << (8 * lengthSize))) {
+            return false;
+        }
+        total += lengthSize + nal.second;
+    }
+
+    AVBufferRef *buffer = av_buffer_alloc(static_cast<size_t>(total) + AV_INPUT_BUFFER_PADDING_SIZE);
+    if (!buffer) {
+        return false;
+    }
+    uint8_t *out = buffer->data;
+    for (const QPair<int, int> &nal : nals) {
+        for (int byte = lengthSize - 1; byte >= 0; --byte) {
+            *out++ = static_cast<uint8_t>(nal.second >> (8 * byte));
+        }
+        memcpy(out, data + nal.first, static_cast<size_t>(nal.second));
+        out += nal.second;
+    }
+    memset(out, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+
+    av_buffer_unref(&packet->buf);
+    packet->buf = buffer;
+    packet->data = buffer->data;
+    packet->size = total;
+    return true;
+}
+}
+
+ClipExporter::ClipExporter(QObject *parent)
+    : QObject(parent)
+    , m_thread(nullptr)
+    , m_running(false)
+    , m_cancelled(false)
+    , m_progressPermille(0)
+    , m_startUs(0)
+    , m_endUs(0)
+    , m_precise(false)
+    , m_input(nullptr)
+    , m_output(nullptr)
+    , m_headerWritten(false)
+    , m_videoIndex(-1)
+    , m_packet(nullptr)
+    , m_startPts(0)
+    , m_endPts(0)
+    , m_clipStartPts(AV_NOPTS_VALUE)
+    , m_lastVideoDts(AV_NOPTS_VALUE)
+    , m_videoDone(false)
+    , m_decoder(nullptr)
+    , m_encoder(nullptr)
+    , m_encoderCodec(nullptr)
+    , m_bsf(nullptr)
+    , m_frame(nullptr)
+    , m_encodedPacket(nullptr)
+    , m_nalLengthSize(0)
+    , m_encodeFromPts(0)
+    , m_encodeToPts(0)
+    , m_dtsDelay(0)
+{
+}
+
+ClipExporter::~ClipExporter()
+{
+    cancel();
+    if (m_thread) {
+        m_thread->wait();
+        delete m_thread;
+    }
+}
+
+bool ClipExporter::start(const QString &inputPath, const QString &outputPath,
+                         qint64 startMs, qint64 endMs, bool precise)
+{
+    if (m_running) {
+        emit errorOccurred("Clip export already in progress");
+        return false;
+    }
+
+    if (startMs < 0 || endMs <= startMs) {
+        emit errorOccurred(QString("Invalid clip range: %1 - %2 ms").arg(startMs).arg(endMs));
+        return false;
+    }
+
+    // 上一次导出的线程已发出 finished，这里只回收
+    if (m_thread) {
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+
+    m_inputPath = inputPath;
+    m_outputPath = outputPath;
+    if (m_outputPath.isEmpty()) {
+        const QFileInfo info(inputPath);
+        m_outputPath = info.dir().filePath(QString("%1_clip_%2-%3.%4")
+                                               .arg(info.completeBaseName())
+                                               .arg(startMs / 1000)
+                                               .arg((endMs + 999) / 1000)
+                                               .arg(info.suffix()));
+    }
+    m_startUs = startMs * 1000;
+    m_endUs = endMs * 1000;
+    m_precise = precise;
+    m_cancelled = false;
+    m_progressPermille = 0;
+    m_running = true;
+    emit runningChanged();
+    emit progressChanged();
+
+    m_thread = QThread::create([this]() { exportLoop(); });
+    m_thread->setObjectName("ClipExport");
+    m_thread->start();
+    return true;
+}
+
+void ClipExporter::cancel()
+{
+    if (m_running) {
+        m_cancelled = true;
+    }
+}
+
+void ClipExporter::exportLoop()
+{
+    QElapsedTimer timer;
+    timer.start();
+    qDebug() << "Clip export:" << m_inputPath << m_startUs / 1000 << "-" << m_endUs / 1000 << "ms"
+             << (m_precise ? "(precise)" : "(keyframe)") << "->" << m_outputPath;
+
+    QString error;
+    bool ok = openInput(&error) && (!m_precise || setupPrecise(&error)) && openOutput(&error)
+              && readPackets(&error);
+
+    if (ok && m_cancelled) {
+        ok = false;
+        error = "cancelled";
+    }
+
+    if (ok) {
+        const int ret = av_write_trailer(m_output);
+        if (ret < 0) {
+            ok = false;
+            error = QString("cannot write trailer: %1").arg(ffmpegError(ret));
+        }
+    }
+
+    const bool outputCreated = m_output && m_output->pb;
+    closeAll();
+
+    if (ok) {
+        m_progressPermille = 1000;
+        emit progressChanged();
+        qDebug() << "Clip exported:" << m_outputPath << "in" << timer.elapsed() << "ms";
+    } else {
+        if (outputCreated) {
+            QFile::remove(m_outputPath);
+        }
+        if (!m_cancelled) {
+            qWarning() << "Clip export failed:" << error;
+            emit errorOccurred(QString("Clip export failed: %1").arg(error));
+        } else {
+            qDebug() << "Clip export cancelled";
+        }
+    }
+
+    m_running = false;
+    emit runningChanged();
+    emit finished(m_outputPath, ok);
+}
+
+bool ClipExporter::openInput(QString *error)
+{
+    const QByteArray path = m_inputPath.toUtf8();
+    int ret = avformat_open_input(&m_input, path.constData(), nullptr, nullptr);
+    if (ret < 0) {
+        *error = QString("cannot open %1: %2").arg(m_inputPath, ffmpegError(ret));
+        return false;
+    }
+
+    ret = avformat_find_stream_info(m_input, nullptr);
+    if (ret < 0) {
+        *error = QString("cannot read stream info: %1").arg(ffmpegError(ret));
+        return false;
+    }
+
+    m_videoIndex = av_find_best_stream(m_input, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+    if (m_videoIndex < 0) {
+        *error = "no video stream";
+        return false;
+    }
+
+    // 用户给出的时间相对文件开头
+    const AVStream *video = m_input->streams[m_videoIndex];
+    const int64_t fileStartUs = m_input->start_time != AV_NOPTS_VALUE ? m_input->start_time : 0;
+    m_startPts = av_rescale_q(fileStartUs + m_startUs, AV_TIME_BASE_Q, video->time_base);
+    m_endPts = av_rescale_q(fileStartUs + m_endUs, AV_TIME_BASE_Q, video->time_base);
+    m_startUs += fileStartUs;
+    m_endUs += fileStartUs;
+
+    // 按索引定位到开始点之前的关键帧；没有索引的文件从头读取（范围外的GOP被丢弃）
+    ret = av_seek_frame(m_input, m_videoIndex, m_startPts, AVSEEK_FLAG_BACKWARD);
+    if (ret < 0) {
+        qWarning() << "Clip export: seek failed, reading from start:" << ffmpegError(ret);
+    }
+
+    m_packet = av_packet_alloc();
+    if (!m_packet) {
+        *error = "out of memory";
+        return false;
+    }
+    return true;
+}
+
+bool ClipExporter::openOutput(QString *error)
+{
+    const QByteArray path = m_outputPath.toUtf8();
+    int ret = avformat_alloc_output_context2(&m_output, nullptr, nullptr, path.constData());
+    if (ret < 0 || !m_output) {
+        *error = QString("unsupported container for %1").arg(m_outputPath);
+        return false;
+    }
+
+    // 导出视频、音频和字幕流，其余（数据、附件）忽略
+    m_streamMap.fill(-1, static_cast<int>(m_input->nb_streams));
+    for (unsigned int i = 0; i < m_input->nb_streams; ++i) {
+        const AVStream *in = m_input->streams[i];
+        const AVMediaType type = in->codecpar->codec_type;
+        if (static_cast<int>(i) != m_videoIndex && type != AVMEDIA_TYPE_AUDIO && type != AVMEDIA_TYPE_SUBTITLE) {
+            continue;
+        }
+
+        AVStream *out = avformat_new_stream(m_output, nullptr);
+        if (!out || avcodec_parameters_copy(out->codecpar, in->codecpar) < 0) {
+            *error = "failed to create output stream";
+            return false;
+        }
+        out->codecpar->codec_tag = 0;
+
+        // 精确模式重新编码的GOP带有编码器自己的参数集（在码流中），avc1/hvc1 要求所有参数集都在样本描述中，
+        // 信任 avcC/hvcC 的播放器会用原始参数集解码这些GOP；MP4/MOV 改用允许码流内参数集的 avc3/hev1
+        if (m_precise && static_cast<int>(i) == m_videoIndex && m_output->oformat->codec_tag) {
+            const AVCodecID codecId = in->codecpar->codec_id;
+            const unsigned int inbandTag = codecId == AV_CODEC_ID_H264 ? MKTAG('a', 'v', 'c', '3')
+                                                                       : MKTAG('h', 'e', 'v', '1');
+            if (av_codec_get_id(m_output->oformat->codec_tag, inbandTag) == codecId) {
+                out->codecpar->codec_tag = inbandTag;
+            }
+        }
+        out->time_base = in->time_base;
+        m_streamMap[static_cast<int>(i)] = out->index;
+    }
+
+    if (!(m_output->oformat->flags & AVFMT_NOFILE)) {
+        ret = avio_open(&m_output->pb, path.constData(), AVIO_FLAG_WRITE);
+        if (ret < 0) {
+            *error = QString("cannot open %1: %2").arg(m_outputPath, ffmpegError(ret));
+            return false;
+        }
+    }
+
+    ret = avformat_write_header(m_output, nullptr);
+    if (ret < 0) {
+        *error = QString("cannot write header: %1").arg(ffmpegError(ret));
+        return false;
+    }
+    m_headerWritten = true;
+    return true;
+}
+
+bool ClipExporter::setupPrecise(QString *error)
+{
+    const AVStream *video = m_input->streams[m_videoIndex];
+    const AVCodecParameters *par = video->codecpar;
+
+    // 重新编码的GOP与复制的数据写入同一条轨道，只支持能在码流中携带参数集的编码
+    m_encoderCodec = par->codec_id == AV_CODEC_ID_H264 || par->codec_id == AV_CODEC_ID_HEVC
+                         ? avcodec_find_encoder(par->codec_id)
+                         : nullptr;
+    const AVCodec *decoderCodec = avcodec_find_decoder(par->codec_id);
+    if (!m_encoderCodec || !decoderCodec) {
+        qWarning() << "Clip export: no encoder for" << avcodec_get_name(par->codec_id)
+                   << ", falling back to keyframe cut";
+        m_precise = false;
+        return true;
+    }
+
+    m_decoder = avcodec_alloc_context3(decoderCodec);
+    m_frame = av_frame_alloc();
+    m_encodedPacket = av_packet_alloc();
+    if (!m_decoder || !m_frame || !m_encodedPacket || avcodec_parameters_to_context(m_decoder, par) < 0) {
+        *error = "out of memory";
+        return false;
+    }
+    m_decoder->pkt_timebase = video->time_base;
+    m_decoder->thread_count = 0;
+    int ret = avcodec_open2(m_decoder, decoderCodec, nullptr);
+    if (ret < 0) {
+        *error = QString("cannot open decoder: %1").arg(ffmpegError(ret));
+        return false;
+    }
+
+    // 复制部分转为 Annex B 时在关键帧前插入原始参数集，重新编码的GOP之后解码器能恢复原来的参数
+    m_nalLengthSize = SeiTimestamp::nalLengthSize(par);
+    if (m_nalLengthSize > 0) {
+        const char *name = par->codec_id == AV_CODEC_ID_H264 ? "h264_mp4toannexb" : "hevc_mp4toannexb";
+        const AVBitStreamFilter *filter = av_bsf_get_by_name(name);
+        if (!filter || av_bsf_alloc(filter, &m_bsf) < 0 || avcodec_parameters_copy(m_bsf->par_in, par) < 0) {
+            *error = QString("bitstream filter %1 unavailable").arg(name);
+            return false;
+        }
+        m_bsf->time_base_in = video->time_base;
+        ret = av_bsf_init(m_bsf);
+        if (ret < 0) {
+            *error = QString("cannot init %1: %2").arg(name, ffmpegError(ret));
+            return false;
+        }
+    }
+
+    // 输出的0点就是请求的开始时间
+    m_clipStartPts = m_startPts;
+    return true;
+}
+
+bool ClipExporter::readPackets(QString *error)
+{
+    int64_t lastOtherUs = AV_NOPTS_VALUE;
+    int otherStreams = 0;
+    for (int i = 0; i < m_streamMap.size(); ++i) {
+        if (m_streamMap[i] >= 0 && i != m_videoIndex) {
+            otherStreams++;
+        }
+    }
+
+    while (!m_cancelled) {
+        // 视频已结束：其他流也都越过结束点（或离结束点足够远）后停止读取
+        if (m_videoDone && (m_finishedStreams.size() >= otherStreams
+                            || (lastOtherUs != AV_NOPTS_VALUE && lastOtherUs > m_endUs + kStreamEndMarginUs))) {
+            break;
+        }
+
+        const int ret = av_read_frame(m_input, m_packet);
+        if (ret == AVERROR_EOF) {
+            break;
+        }
+        if (ret < 0) {
+            *error = QString("read error: %1").arg(ffmpegError(ret));
+            return false;
+        }
+
+        bool ok = true;
+        if (m_packet->stream_index == m_videoIndex) {
+            const bool keyframe = m_packet->flags & AV_PKT_FLAG_KEY;
+            if (keyframe && !m_gop.isEmpty() && !m_videoDone) {
+                ok = processGop(packetPts(m_packet), m_packet->dts, error);
+            }
+            // 从定位后的第一个关键帧开始
+            if (ok && !m_videoDone && (keyframe || !m_gop.isEmpty())) {
+                AVPacket *clone = av_packet_clone(m_packet);
+                if (clone) {
+                    m_gop.append(clone);
+                }
+            }
+        } else if (m_packet->stream_index < m_streamMap.size() && m_streamMap[m_packet->stream_index] >= 0) {
+            const AVStream *stream = m_input->streams[m_packet->stream_index];
+            const int64_t pts = packetPts(m_packet);
+            if (pts != AV_NOPTS_VALUE) {
+                lastOtherUs = av_rescale_q(pts, stream->time_base, AV_TIME_BASE_Q);
+            }
+            ok = handleOtherPacket(m_packet, error);
+        }
+        av_packet_unref(m_packet);
+        if (!ok) {
+            return false;
+        }
+    }
+
+    // 文件结束：最后一个GOP包含结束点
+    if (!m_cancelled && !m_videoDone && !m_gop.isEmpty() && !processGop(AV_NOPTS_VALUE, AV_NOPTS_VALUE, error)) {
+        return false;
+    }
+    freeGop();
+
+    if (m_lastVideoDts == AV_NOPTS_VALUE && !m_cancelled) {
+        *error = "no video in the requested range";
+        return false;
+    }
+    return true;
+}
+
+bool ClipExporter::processGop(int64_t nextKeyPts, int64_t nextKeyDts, QString *error)
+{
+    const AVPacket *key = m_gop.first();
+    const int64_t keyPts = packetPts(key);
+
+    // 下一个关键帧越过结束点（或文件结束）时，本GOP包含结束点
+    const bool last = nextKeyPts == AV_NOPTS_VALUE || nextKeyPts > m_endPts;
+    bool ok = true;
+
+    if (nextKeyPts != AV_NOPTS_VALUE && nextKeyPts <= m_startPts) {
+        // 开始点之前的GOP（定位不准或没有索引时）
+    } else if (keyPts != AV_NOPTS_VALUE && keyPts >= m_endPts) {
+        m_videoDone = true;
+    } else {
+        // 关键帧对齐：输出从包含开始点的GOP的关键帧开始
+        if (m_clipStartPts == AV_NOPTS_VALUE) {
+            m_clipStartPts = keyPts != AV_NOPTS_VALUE ? keyPts : m_startPts;
+        }
+        ok = flushPendingPackets(error);
+
+        const bool head = m_precise && keyPts < m_startPts;
+        if (ok && head) {
+            // 开始点所在的GOP：之后复制的数据从下一个关键帧开始，DTS按其解码延迟排在它之前
+            const int64_t delay = !last && nextKeyDts != AV_NOPTS_VALUE ? nextKeyPts - nextKeyDts : 0;
+            ok = reencodeGop(m_startPts, m_endPts, delay, error);
+        } else if (ok && m_precise && last) {
+            // 结束点所在的GOP：接在已复制的数据之后
+            const int64_t delay = key->dts != AV_NOPTS_VALUE ? keyPts - key->dts : 0;
+            ok = reencodeGop(keyPts, m_endPts, delay, error);
+        } else {
+            for (AVPacket *packet : m_gop) {
+                if (ok) {
+                    ok = writeCopiedVideo(packet, error);
+                }
+            }
+        }
+
+        if (last) {
+            m_videoDone = true;
+        }
+    }
+
+    freeGop();
+    if (nextKeyPts != AV_NOPTS_VALUE) {
+        updateProgress(nextKeyPts);
+    }
+    return ok;
+}
+
+bool ClipExporter::handleOtherPacket(AVPacket *packet, QString *error)
+{
+    const AVStream *stream = m_input->streams[packet->stream_index];
+    const int64_t pts = packetPts(packet);
+    const int64_t ptsUs = pts != AV_NOPTS_VALUE ? av_rescale_q(pts, stream->time_base, AV_TIME_BASE_Q) : AV_NOPTS_VALUE;
+
+    if (ptsUs != AV_NOPTS_VALUE && ptsUs >= m_endUs) {
+        m_finishedStreams.insert(packet->stream_index);
+        return true;
+    }
+
+    // 0点还没确定（关键帧对齐时由第一个GOP决定），先保留
+    if (m_clipStartPts == AV_NOPTS_VALUE) {
+        AVPacket *clone = av_packet_clone(packet);
+        if (clone) {
+            m_pendingPackets.append(clone);
+        }
+        return true;
+    }
+
+    const AVRational videoTimeBase = m_input->streams[m_videoIndex]->time_base;
+    const int64_t clipStartUs = av_rescale_q(m_clipStartPts, videoTimeBase, AV_TIME_BASE_Q);
+    if (ptsUs == AV_NOPTS_VALUE || ptsUs < clipStartUs) {
+        return true;
+    }
+    return writeOutput(packet, packet->stream_index, av_rescale_q(clipStartUs, AV_TIME_BASE_Q, stream->time_base),
+                       error);
+}
+
+bool ClipExporter::flushPendingPackets(QString *error)
+{
+    bool ok = true;
+    QVector<AVPacket *> pending;
+    pending.swap(m_pendingPackets);
+    for (AVPacket *packet : pending) {
+        if (ok) {
+            ok = handleOtherPacket(packet, error);
+        }
+        av_packet_free(&packet);
+    }
+    return ok;
+}
+
+bool ClipExporter::writeCopiedVideo(AVPacket *packet, QString *error)
+{
+    if (!m_bsf) {
+        return writeVideoPacket(packet, error);
+    }
+
+    // 转为 Annex B（关键帧前带参数集），再转回输出容器要求的长度前缀形式
+    int ret = av_bsf_send_packet(m_bsf, packet);
+    if (ret < 0) {
+        *error = QString("bitstream filter error: %1").arg(ffmpegError(ret));
+        return false;
+    }
+    while ((ret = av_bsf_receive_packet(m_bsf, packet)) >= 0) {
+        if (!annexbToLengthPrefixed(packet, m_nalLengthSize)) {
+            *error = "cannot convert NAL units";
+            return false;
+        }
+        if (!writeVideoPacket(packet, error)) {
+            return false;
+        }
+    }
+    if (ret != AVERROR(EAGAIN) && ret != AVERROR_EOF) {
+        *error = QString("bitstream filter error: %1").arg(ffmpegError(ret));
+        return false;
+    }
+    return true;
+}
+
+bool ClipExporter::writeVideoPacket(AVPacket *packet, QString *error)
+{
+    // 封装器要求DTS严格递增（复制与重新编码的衔接处）
+    int64_t dts = packet->dts != AV_NOPTS_VALUE ? packet->dts : packet->pts;
+    if (dts != AV_NOPTS_VALUE) {
+        if (m_lastVideoDts != AV_NOPTS_VALUE && dts <= m_lastVideoDts) {
+            dts = m_lastVideoDts + 1;
+        }
+        if (packet->pts != AV_NOPTS_VALUE && packet->pts < dts) {
+            packet->pts = dts;
+        }
+        packet->dts = dts;
+        m_lastVideoDts = dts;
+    }
+    return writeOutput(packet, m_videoIndex, m_clipStartPts, error);
+}
+
+bool ClipExporter::writeOutput(AVPacket *packet, int inputIndex, int64_t offset, QString *error)
+{
+    const AVStream *in = m_input->streams[inputIndex];
+    const AVStream *out = m_output->streams[m_streamMap[inputIndex]];
+
+    if (packet->pts != AV_NOPTS_VALUE) {
+        packet->pts -= offset;
+    }
+    if (packet->dts != AV_NOPTS_VALUE) {
+        packet->dts -= offset;
+    }
+    packet->stream_index = out->index;
+    packet->pos = -1;
+    av_packet_rescale_ts(packet, in->time_base, out->time_base);
+
+    // 写入后packet被清空（封装器接管引用）
+    const int ret = av_interleaved_write_frame(m_output, packet);
+    if (ret < 0) {
+        *error = QString("write error: %1").arg(ffmpegError(ret));
+        return false;
+    }
+    return true;
+}
+
+bool ClipExporter::reencodeGop(int64_t fromPts, int64_t toPts, int64_t dtsDelay, QString *error)
+{
+    m_encodeFromPts = fromPts;
+    m_encodeToPts = toPts;
+    m_dtsDelay = dtsDelay;
+
+    // 解码整个GOP（之前的参考帧也需要），只编码范围内的帧
+    avcodec_flush_buffers(m_decoder);
+    for (AVPacket *packet : m_gop) {
+        int ret;
+        while ((ret = avcodec_send_packet(m_decoder, packet)) == AVERROR(EAGAIN)) {
+            if (!decodeFrames(error)) {
+                return false;
+            }
+        }
+        if (ret < 0) {
+            qWarning() << "Clip export: decode error:" << ffmpegError(ret);
+        }
+        if (!decodeFrames(error)) {
+            return false;
+        }
+    }
+    avcodec_send_packet(m_decoder, nullptr);
+    if (!decodeFrames(error)) {
+        return false;
+    }
+    avcodec_flush_buffers(m_decoder);
+
+    // 排空并释放编码器，下一个边界GOP重新创建（保证从IDR帧开始）
+    if (!m_encoder) {
+        return true;
+    }
+    avcodec_send_frame(m_encoder, nullptr);
+    const bool ok = receiveEncodedPackets(error);
+    avcodec_free_context(&m_encoder);
+    return ok;
+}
+
+bool ClipExporter::decodeFrames(QString *error)
+{
+    forever {
+        int ret = avcodec_receive_frame(m_decoder, m_frame);
+        if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
+            return true;
+        }
+        if (ret < 0) {
+            *error = QString("decode error: %1").arg(ffmpegError(ret));
+            return false;
+        }
+
+        const int64_t pts = m_frame->best_effort_timestamp;
+        if (pts != AV_NOPTS_VALUE && pts >= m_encodeFromPts && pts < m_encodeToPts) {
+            if (!m_encoder && !openEncoder(m_frame, error)) {
+                av_frame_unref(m_frame);
+                return false;
+            }
+            m_frame->pts = pts;
+            m_frame->pict_type = AV_PICTURE_TYPE_NONE;
+            ret = avcodec_send_frame(m_encoder, m_frame);
+            if (ret < 0) {
+                av_frame_unref(m_frame);
+                *error = QString("encode error: %1").arg(ffmpegError(ret));
+                return false;
+            }
+            if (!receiveEncodedPackets(error)) {
+                av_frame_unref(m_frame);
+                return false;
+            }
+        }
+        av_frame_unref(m_frame);
+    }
+}
+
+bool ClipExporter::openEncoder(const AVFrame *frame, QString *error)
+{
+    const AVStream *video = m_input->streams[m_videoIndex];
+
+    m_encoder = avcodec_alloc_context3(m_encoderCodec);
+    if (!m_encoder) {
+        *error = "out of memory";
+        return false;
+    }
+
+    // 与原视频一致的尺寸、像素格式和色彩信息；不使用B帧，输出顺序即显示顺序
+    m_encoder->width = frame->width;
+    m_encoder->height = frame->height;
+    m_encoder->pix_fmt = static_cast<AVPixelFormat>(frame->format);
+    m_encoder->sample_aspect_ratio = frame->sample_aspect_ratio;
+    m_encoder->color_range = frame->color_range;
+    m_encoder->color_primaries = frame->color_primaries;
+    m_encoder->color_trc = frame->color_trc;
+    m_encoder->colorspace = frame->colorspace;
+    m_encoder->time_base = video->time_base;
+    m_encoder->framerate = video->avg_frame_rate;
+    m_encoder->max_b_frames = 0;
+    m_encoder->gop_size = 0x7fffffff;
+    m_encoder->bit_rate = video->codecpar->bit_rate;
+    m_encoder->thread_count = 0;
+
+    // 边界GOP很短，用接近原画质的质量优先设置（不支持的选项被忽略）
+    av_opt_set(m_encoder->priv_data, "preset", "fast", 0);
+    av_opt_set(m_encoder->priv_data, "crf", "18", 0);
+
+    const int ret = avcodec_open2(m_encoder, m_encoderCodec, nullptr);
+    if (ret < 0) {
+        avcodec_free_context(&m_encoder);
+        *error = QString("cannot open %1 encoder: %2").arg(m_encoderCodec->name, ffmpegError(ret));
+        return false;
+    }
+    return true;
+}
+
+bool ClipExporter::receiveEncodedPackets(QString *error)
+{
+    forever {
+        int ret = avcodec_receive_packet(m_encoder, m_encodedPacket);
+        if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
+            return true;
+        }
+        if (ret < 0) {
+            *error = QString("encode error: %1").arg(ffmpegError(ret));
+            return false;
+        }
+
+        // 编码器时基即输入视频流时基；参数集随IDR帧在码流中输出
+        m_encodedPacket->dts = m_encodedPacket->pts - m_dtsDelay;
+        if (m_nalLengthSize > 0 && !annexbToLengthPrefixed(m_encodedPacket, m_nalLengthSize)) {
+            av_packet_unref(m_encodedPacket);
+            *error = "cannot convert NAL units";
+            return false;
+        }
+        const bool ok = writeVideoPacket(m_encodedPacket, error);
+        av_packet_unref(m_encodedPacket);
+        if (!ok) {
+            return false;
+        }
+    }
+}
+
+void ClipExporter::freeGop()
+{
+    for (AVPacket *packet : m_gop) {
+        av_packet_free(&packet);
+    }
+    m_gop.clear();
+}
+
+void ClipExporter::updateProgress(int64_t pts)
+{
+    if (m_endPts <= m_startPts) {
+        return;
+    }
+    const int permille = static_cast<int>(qBound<int64_t>(0, (pts - m_startPts) * 1000 / (m_endPts - m_startPts), 999));
+    if (permille - m_progressPermille >= kProgressStep) {
+        m_progressPermille = permille;
+        emit progressChanged();
+    }
+}
+
+void ClipExporter::closeAll()
+{
+    freeGop();
+    for (AVPacket *packet : m_pendingPackets) {
+        av_packet_free(&packet);
+    }
+    m_pendingPackets.clear();
+    m_finishedStreams.clear();
+
+    avcodec_free_context(&m_encoder);
+    avcodec_free_context(&m_decoder);
+    av_bsf_free(&m_bsf);
+    av_frame_free(&m_frame);
+    av_packet_free(&m_encodedPacket);
+    av_packet_free(&m_packet);
+    m_encoderCodec = nullptr;
+    m_nalLengthSize = 0;
+
+    if (m_output) {
+        if (!(m_output->oformat->flags & AVFMT_NOFILE)) {
+            avio_closep(&m_output->pb);
+        }
+        avformat_free_context(m_output);
+        m_output = nullptr;
+    }
+    m_headerWritten = false;
+
+    avformat_close_input(&m_input);
+    m_streamMap.clear();
+    m_videoIndex = -1;
+    m_clipStartPts = AV_NOPTS_VALUE;
+    m_lastVideoDts = AV_NOPTS_VALUE;
+    m_videoDone = false;
+}
@@ -0,0 +1,118 @@
+#ifndef CLIPEXPORTER_H
+#define CLIPEXPORTER_H
+
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QThread>
+#include <QVector>
+#include <atomic>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavcodec/bsf.h>
+#include <libavformat/avformat.h>
+}
+
+/**
+ * @brief 片段导出（从录像中截取两个时间点之间的内容，不重新编码）
+ * 在后台线程中按索引定位到开始点之前的关键帧，只读取片段范围内的数据并直接复制压缩数据，
+ * 导出时间取决于片段长度而不是文件长度。默认开始和结束都对齐到关键帧（开始向前、结束向后）；
+ * 精确模式下只重新编码首尾两个GOP（H.264/HEVC），中间部分仍直接复制。
+ * 音频等其他流按时间精确截取，时间戳整体平移到从0开始。
+ */
+class ClipExporter : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool running READ isRunning NOTIFY runningChanged)
+    Q_PROPERTY(double progress READ progress NOTIFY progressChanged)
+
+public:
+    explicit ClipExporter(QObject *parent = nullptr);
+    ~ClipExporter() override;
+
+    // 开始导出 [startMs, endMs)（相对文件开头），outputPath 为空时在输入文件旁生成 name_clip_<开始>-<结束>.ext
+    // 已有导出进行中时返回 false
+    Q_INVOKABLE bool start(const QString &inputPath, const QString &outputPath,
+                           qint64 startMs, qint64 endMs, bool precise);
+
+    // 取消导出，不完整的输出文件被删除
+    Q_INVOKABLE void cancel();
+
+    bool isRunning() const { return m_running; }
+    double progress() const { return m_progressPermille / 1000.0; }
+
+signals:
+    void runningChanged();
+    void progressChanged();
+    void finished(const QString &outputPath, bool success);
+    void errorOccurred(const QString &error);
+
+private:
+    // 控制状态
+    QThread *m_thread;
+    std::atomic<bool> m_running;
+    std::atomic<bool> m_cancelled;
+    std::atomic<int> m_progressPermille;
+
+    // 以下仅导出线程访问（start 时设置）
+    QString m_inputPath;
+    QString m_outputPath;
+    int64_t m_startUs;
+    int64_t m_endUs;
+    bool m_precise;
+
+    AVFormatContext *m_input;
+    AVFormatContext *m_output;
+    bool m_headerWritten;
+    QVector<int> m_streamMap;          // 输入流序号 -> 输出流序号（-1表示不导出）
+    int m_videoIndex;
+    AVPacket *m_packet;
+
+    // 视频时间（输入视频流时基）
+    int64_t m_startPts;
+    int64_t m_endPts;
+    int64_t m_clipStartPts;            // 输出的0点，确定之前为 AV_NOPTS_VALUE
+    int64_t m_lastVideoDts;
+    bool m_videoDone;
+
+    // 当前GOP（从关键帧开始），下一个关键帧到达时整体复制或重新编码
+    QVector<AVPacket *> m_gop;
+
+    // 0点确定之前收到的其他流数据，以及已越过结束点的其他流
+    QVector<AVPacket *> m_pendingPackets;
+    QSet<int> m_finishedStreams;
+
+    // 精确模式：解码/编码首尾GOP；参数集为长度前缀形式时复制的数据先转为 Annex B（插入参数集）再转回
+    AVCodecContext *m_decoder;
+    AVCodecContext *m_encoder;
+    const AVCodec *m_encoderCodec;
+    AVBSFContext *m_bsf;
+    AVFrame *m_frame;
+    AVPacket *m_encodedPacket;         // 编码输出（m_packet 在读取循环中仍持有触发本次处理的关键帧）
+    int m_nalLengthSize;
+    int64_t m_encodeFromPts;
+    int64_t m_encodeToPts;
+    int64_t m_dtsDelay;
+
+    void exportLoop();
+    bool openInput(QString *error);
+    bool openOutput(QString *error);
+    bool setupPrecise(QString *error);
+    bool readPackets(QString *error);
+    bool processGop(int64_t nextKeyPts, int64_t nextKeyDts, QString *error);
+    bool handleOtherPacket(AVPacket *packet, QString *error);
+    bool flushPendingPackets(QString *error);
+    bool writeCopiedVideo(AVPacket *packet, QString *error);
+    bool writeVideoPacket(AVPacket *packet, QString *error);
+    bool writeOutput(AVPacket *packet, int inputIndex, int64_t offset, QString *error);
+    bool reencodeGop(int64_t fromPts, int64_t toPts, int64_t dtsDelay, QString *error);
+    bool decodeFrames(QString *error);
+    bool openEncoder(const AVFrame *frame, QString *error);
+    bool receiveEncodedPackets(QString *error);
+    void freeGop();
+    void updateProgress(int64_t pts);
+    void closeAll();
+};
+
+#endif // CLIPEXPORTER_H
@@ -1,4 +1,5 @@
 #include "configmanager.h"
+#include "ingestprofile.h"
 #include <QSettings>
 #include <QStandardPaths>
 #include <QDir>
@@ -8,6 +9,9 @@ ConfigManager::ConfigManager(QObject *parent)
     : QObject(parent)
     , m_maxLogLines(1000)
     , m_videoAspectRatio(Ratio_16_9)
+    , m_metricsPort(0)
+    , m_recordSegmentSeconds(300)
+    , m_recordSyncPolicy(2)
 {
     qDebug() << "ConfigManager initialized";
     loadConfig();
@@ -46,6 +50,61 @@ void ConfigManager::setVideoAspectRatio(int ratio)
     }
 }
 
+int ConfigManager::metricsPort() const
+{
+    // 无人值守的长时间测试通常由脚本启动，允许用环境变量临时开启导出
+    bool ok = false;
+    const int port = qEnvironmentVariableIntValue("ARDKIT_METRICS_PORT", &ok);
+    if (ok && port >= 0 && port <= 65535) {
+        return port;
+    }
+    return m_metricsPort;
+}
+
+QString ConfigManager::metricsFile() const
+{
+    if (qEnvironmentVariableIsSet("ARDKIT_METRICS_FILE")) {
+        return qEnvironmentVariable("ARDKIT_METRICS_FILE");
+    }
+    return m_metricsFile;
+}
+
+void ConfigManager::setMetricsPort(int port)
+{
+    if (m_metricsPort != port && port >= 0 && port <= 65535) {
+        m_metricsPort = port;
+        emit metricsExportChanged();
+        qDebug() << "Metrics port set to:" << port;
+    }
+}
+
+void ConfigManager::setMetricsFile(const QString &path)
+{
+    if (m_metricsFile != path) {
+        m_metricsFile = path;
+        emit metricsExportChanged();
+        qDebug() << "Metrics file set to:" << path;
+    }
+}
+
+void ConfigManager::setRecordSegmentSeconds(int seconds)
+{
+    if (m_recordSegmentSeconds != seconds && seconds >= 0) {
+        m_recordSegmentSeconds = seconds;
+        emit recordingOptionsChanged();
+        qDebug() << "Recording segment duration set to:" << seconds << "s";
+    }
+}
+
+void ConfigManager::setRecordSyncPolicy(int policy)
+{
+    if (m_recordSyncPolicy != policy && policy >= 0 && policy <= 2) {
+        m_recordSyncPolicy = policy;
+        emit recordingOptionsChanged();
+        qDebug() << "Recording sync policy set to:" << policy;
+    }
+}
+
 void ConfigManager::loadConfig()
 {
     QSettings settings("ArdKit", "ArdKit-GUI");
@@ -54,11 +113,19 @@ void ConfigManager::loadConfig()
     m_lastDeviceAddress = settings.value("lastDeviceAddress", "").toString();
     m_videoAspectRatio = settings.value("videoAspectRatio", Ratio_16_9).toInt();
     m_networkAddressHistory = settings.value("networkAddressHistory", QStringList()).toStringList();
+    m_ingestProfiles = settings.value("ingestProfiles", QVariantMap()).toMap();
+    m_streamInfoCache = settings.value("streamInfoCache", QVariantMap()).toMap();
+    m_metricsPort = settings.value("metricsPort", 0).toInt();
+    m_metricsFile = settings.value("metricsFile", "").toString();
+    m_recordSegmentSeconds = qMax(0, settings.value("recordSegmentSeconds", 300).toInt());
+    m_recordSyncPolicy = qBound(0, settings.value("recordSyncPolicy", 2).toInt(), 2);
 
     emit maxLogLinesChanged();
     emit lastDeviceAddressChanged();
     emit videoAspectRatioChanged();
     emit networkAddressHistoryChanged();
+    emit metricsExportChanged();
+    emit recordingOptionsChanged();
     emit configLoaded();
 
     qDebug() << "Configuration loaded";
@@ -72,6 +139,12 @@ void ConfigManager::saveConfig()
     settings.setValue("lastDeviceAddress", m_lastDeviceAddress);
     settings.setValue("videoAspectRatio", m_videoAspectRatio);
     settings.setValue("networkAddressHistory", m_networkAddressHistory);
+    settings.setValue("ingestProfiles", m_ingestProfiles);
+    settings.setValue("streamInfoCache", m_streamInfoCache);
+    settings.setValue("metricsPort", m_metricsPort);
+    settings.setValue("metricsFile", m_metricsFile);
+    settings.setValue("recordSegmentSeconds", m_recordSegmentSeconds);
+    settings.setValue("recordSyncPolicy", m_recordSyncPolicy);
 
     settings.sync();
     emit configSaved();
@@ -123,8 +196,52 @@ void ConfigManager::addNetworkAddress(const QString &address)
 void ConfigManager::removeNetworkAddress(const QString &address)
 {
     if (m_networkAddressHistory.removeAll(address) > 0) {
+        m_ingestProfiles.remove(address);
+        m_streamInfoCache.remove(address);
         emit networkAddressHistoryChanged();
         saveConfig();
         qDebug() << "Network address removed from history:" << address;
     }
 }
+
+QVariantList ConfigManager::ingestProfiles() const
+{
+    return IngestProfile::descriptions();
+}
+
+QString ConfigManager::ingestProfile(const QString &address) const
+{
+    const QString profile = m_ingestProfiles.value(address).toString();
+    return IngestProfile::names().contains(profile) ? profile : IngestProfile::defaultName();
+}
+
+void ConfigManager::setIngestProfile(const QString &address, const QString &profile)
+{
+    if (address.isEmpty() || !IngestProfile::names().contains(profile) || ingestProfile(address) == profile) {
+        return;
+    }
+
+    m_ingestProfiles.insert(address, profile);
+    emit ingestProfileChanged(address);
+    saveConfig();
+    qDebug() << "Ingest profile for" << address << "set to:" << profile;
+}
+
+void ConfigManager::setStreamInfoCache(const QString &address, const QVariantMap &info)
+{
+    if (address.isEmpty() || m_streamInfoCache.value(address).toMap() == info) {
+        return;
+    }
+
+    m_streamInfoCache.insert(address, info);
+    saveConfig();
+    qDebug() << "Stream info cached for:" << address;
+}
+
+void ConfigManager::removeStreamInfoCache(const QString &address)
+{
+    if (m_streamInfoCache.remove(address) > 0) {
+        saveConfig();
+        qDebug() << "Stream info cache removed for:" << address;
+    }
+}
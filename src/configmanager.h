@@ -4,6 +4,7 @@
 #include <QObject>
 #include <QString>
 #include <QVariant>
+#include <QVariantMap>
 
 /**
  * @brief 配置管理类
@@ -16,6 +17,11 @@ class ConfigManager : public QObject
     Q_PROPERTY(QString lastDeviceAddress READ lastDeviceAddress WRITE setLastDeviceAddress NOTIFY lastDeviceAddressChanged)
     Q_PROPERTY(int videoAspectRatio READ videoAspectRatio WRITE setVideoAspectRatio NOTIFY videoAspectRatioChanged)
     Q_PROPERTY(QStringList networkAddressHistory READ networkAddressHistory NOTIFY networkAddressHistoryChanged)
+    Q_PROPERTY(QVariantList ingestProfiles READ ingestProfiles CONSTANT)
+    Q_PROPERTY(int metricsPort READ metricsPort WRITE setMetricsPort NOTIFY metricsExportChanged)
+    Q_PROPERTY(QString metricsFile READ metricsFile WRITE setMetricsFile NOTIFY metricsExportChanged)
+    Q_PROPERTY(int recordSegmentSeconds READ recordSegmentSeconds WRITE setRecordSegmentSeconds NOTIFY recordingOptionsChanged)
+    Q_PROPERTY(int recordSyncPolicy READ recordSyncPolicy WRITE setRecordSyncPolicy NOTIFY recordingOptionsChanged)
 
 public:
     enum AspectRatio {
@@ -32,9 +38,29 @@ public:
     int videoAspectRatio() const { return m_videoAspectRatio; }
     QStringList networkAddressHistory() const { return m_networkAddressHistory; }
 
+    // 可选的接入配置（[{ name, label }, ...]）及各地址选用的配置
+    QVariantList ingestProfiles() const;
+    Q_INVOKABLE QString ingestProfile(const QString &address) const;
+
+    // 按地址缓存的视频流参数（编码格式、参数集、尺寸、时基），用于跳过连接时的流探测
+    QVariantMap streamInfoCache(const QString &address) const { return m_streamInfoCache.value(address).toMap(); }
+
+    // 指标导出：本机HTTP端口（0表示关闭）和每秒追加一行的指标文件（空表示关闭）
+    // 环境变量 ARDKIT_METRICS_PORT / ARDKIT_METRICS_FILE 优先于保存的配置（不会被保存）
+    int metricsPort() const;
+    QString metricsFile() const;
+
+    // 录像：分段时长（秒，0表示不分段）和同步策略（见 AsyncFileWriter::SyncPolicy）
+    int recordSegmentSeconds() const { return m_recordSegmentSeconds; }
+    int recordSyncPolicy() const { return m_recordSyncPolicy; }
+
     void setMaxLogLines(int lines);
     void setLastDeviceAddress(const QString &address);
     void setVideoAspectRatio(int ratio);
+    void setMetricsPort(int port);
+    void setMetricsFile(const QString &path);
+    void setRecordSegmentSeconds(int seconds);
+    void setRecordSyncPolicy(int policy);
 
 public slots:
     void loadConfig();
@@ -43,12 +69,18 @@ public slots:
     void setValue(const QString &key, const QVariant &value);
     void addNetworkAddress(const QString &address);
     void removeNetworkAddress(const QString &address);
+    void setIngestProfile(const QString &address, const QString &profile);
+    void setStreamInfoCache(const QString &address, const QVariantMap &info);
+    void removeStreamInfoCache(const QString &address);
 
 signals:
     void maxLogLinesChanged();
     void lastDeviceAddressChanged();
     void videoAspectRatioChanged();
     void networkAddressHistoryChanged();
+    void ingestProfileChanged(const QString &address);
+    void metricsExportChanged();
+    void recordingOptionsChanged();
     void configLoaded();
     void configSaved();
 
@@ -57,6 +89,12 @@ private:
     QString m_lastDeviceAddress;
     int m_videoAspectRatio;
     QStringList m_networkAddressHistory;
+    QVariantMap m_ingestProfiles;     // 地址 -> 接入配置名称
+    QVariantMap m_streamInfoCache;
+    int m_metricsPort;                // 保存的配置，不含环境变量覆盖
+    QString m_metricsFile;
+    int m_recordSegmentSeconds;
+    int m_recordSyncPolicy;
 
     QString getConfigFilePath() const;
 };
@@ -0,0 +1,12 @@
+#include "ffmpegerror.h"
+
+extern "C" {
+#include <libavutil/error.h>
+}
+
+QString ffmpegError(int errnum)
+{
+    char errbuf[AV_ERROR_MAX_STRING_SIZE];
+    av_strerror(errnum, errbuf, AV_ERROR_MAX_STRING_SIZE);
+    return QString::fromUtf8(errbuf);
+}
@@ -0,0 +1,9 @@
+#ifndef FFMPEGERROR_H
+#define FFMPEGERROR_H
+
+#include <QString>
+
+// FFmpeg 错误码对应的错误描述
+QString ffmpegError(int errnum);
+
+#endif // FFMPEGERROR_H
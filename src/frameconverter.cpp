@@ -0,0 +1,397 @@
+#include "frameconverter.h"
+#include "videoframe.h"
+#include <QDebug>
+#include <QThread>
+
+extern "C" {
+#include <libavutil/cpu.h>
+#include <libavutil/pixdesc.h>
+#include <libavutil/pixfmt.h>
+}
+
+namespace {
+// 小于该像素数的帧分片调度开销大于收益，在调用线程上直接转换
+const int kMinPixelsForSlicing = 1280 * 720;
+
+// 最多分片数，解码线程同样需要CPU
+const int kMaxSlices = 4;
+
+// 目标图像的内存归 QImage 所有，包装成 AVBufferRef 时不释放
+void noopFree(void *, uint8_t *)
+{
+}
+}
+
+// sws_receive_slice 可以从完整的输入帧中只输出任意一段目标行（libswscale 6.1 起）
+#if LIBSWSCALE_VERSION_INT >= AV_VERSION_INT(6, 1, 100)
+#define ARDKIT_SWS_SLICES
+#endif
+
+void FrameConverter::SliceTask::run()
+{
+    if (m_converter->m_swsSlicing) {
+        m_ok = m_converter->scaleRows(m_swsContext, m_rowStart, m_rowEnd);
+    } else {
+        m_converter->m_convertRows(m_converter->m_source, m_converter->m_coefficients,
+                                   m_converter->m_dst, m_converter->m_dstLinesize,
+                                   m_rowStart, m_rowEnd);
+    }
+    m_converter->m_slicesDone.release();
+}
+
+FrameConverter::FrameConverter()
+    : m_kernel(YuvConvert::KernelScalar)
+    , m_convertRows(nullptr)
+    , m_forceSwscale(false)
+    , m_source()
+    , m_coefficients()
+    , m_dst(nullptr)
+    , m_dstLinesize(0)
+    , m_maxSlices(1)
+    , m_lastSlices(1)
+    , m_swsContext(nullptr)
+    , m_swsSrcWidth(0)
+    , m_swsSrcHeight(0)
+    , m_swsSrcFormat(AV_PIX_FMT_NONE)
+    , m_swsDstWidth(0)
+    , m_swsDstHeight(0)
+    , m_usingSwscale(false)
+    , m_swsSlicing(false)
+    , m_swsSrc(nullptr)
+    , m_swsDst(av_frame_alloc())
+{
+    selectKernel();
+
+    m_maxSlices = qBound(1, QThread::idealThreadCount() / 2, kMaxSlices);
+
+    // 调用线程负责第一个分片，线程池只需要其余分片的线程；线程常驻避免反复创建
+    if (m_maxSlices > 1) {
+        m_threadPool.setMaxThreadCount(m_maxSlices - 1);
+        m_threadPool.setExpiryTimeout(-1);
+        for (int i = 1; i < m_maxSlices; ++i) {
+            m_tasks.append(new SliceTask(this));
+        }
+    }
+
+    qDebug() << "Frame converter:" << YuvConvert::kernelName(m_kernel)
+             << "max slices:" << m_maxSlices
+             << (m_forceSwscale ? "(swscale forced)" : "");
+}
+
+FrameConverter::~FrameConverter()
+{
+    m_threadPool.waitForDone();
+    reset();
+    qDeleteAll(m_tasks);
+    m_tasks.clear();
+    av_frame_free(&m_swsDst);
+}
+
+void FrameConverter::selectKernel()
+{
+    const int cpuFlags = av_get_cpu_flags();
+
+    YuvConvert::Kernel best = YuvConvert::KernelScalar;
+    if ((cpuFlags & AV_CPU_FLAG_AVX2) && YuvConvert::kernel(YuvConvert::KernelAVX2)) {
+        best = YuvConvert::KernelAVX2;
+    } else if ((cpuFlags & AV_CPU_FLAG_SSE2) && YuvConvert::kernel(YuvConvert::KernelSSE2)) {
+        best = YuvConvert::KernelSSE2;
+    } else if ((cpuFlags & AV_CPU_FLAG_NEON) && YuvConvert::kernel(YuvConvert::KernelNEON)) {
+        best = YuvConvert::KernelNEON;
+    }
+
+    // 环境变量覆盖，便于对比各实现
+    const QByteArray forced = qgetenv("ARDKIT_CONVERTER").trimmed().toLower();
+    if (forced == "swscale") {
+        m_forceSwscale = true;
+    } else if (!forced.isEmpty()) {
+        const YuvConvert::Kernel candidates[] = {
+            YuvConvert::KernelScalar, YuvConvert::KernelSSE2,
+            YuvConvert::KernelAVX2, YuvConvert::KernelNEON
+        };
+        bool found = false;
+        for (YuvConvert::Kernel candidate : candidates) {
+            if (forced == YuvConvert::kernelName(candidate) && YuvConvert::kernel(candidate)) {
+                best = candidate;
+                found = true;
+                break;
+            }
+        }
+        if (!found) {
+            qWarning() << "Unsupported ARDKIT_CONVERTER value:" << forced;
+        }
+    }
+
+    m_kernel = best;
+    m_convertRows = YuvConvert::kernel(best);
+}
+
+bool FrameConverter::convert(const AVFrame *frame, QImage &image)
+{
+    if (!frame || image.isNull() || image.format() != QImage::Format_RGB32) {
+        return false;
+    }
+
+    // 缩放直接由swscale在转换时完成，不再生成全分辨率中间图像
+    const bool scaling = image.width() != frame->width || image.height() != frame->height;
+    if (m_forceSwscale || scaling || !setupSource(frame)) {
+        return convertWithSwscale(frame, image);
+    }
+
+    m_usingSwscale = false;
+    m_dst = image.bits();
+    m_dstLinesize = static_cast<int>(image.bytesPerLine());
+    convertSlices();
+    return true;
+}
+
+bool FrameConverter::setupSource(const AVFrame *frame)
+{
+    switch (frame->format) {
+    case AV_PIX_FMT_YUVJ420P:
+    case AV_PIX_FMT_YUV420P:
+        m_source.layout = YuvConvert::LayoutI420;
+        break;
+    case AV_PIX_FMT_YUVJ422P:
+    case AV_PIX_FMT_YUV422P:
+        m_source.layout = YuvConvert::LayoutI422;
+        break;
+    case AV_PIX_FMT_NV12:
+        m_source.layout = YuvConvert::LayoutNV12;
+        break;
+    default:
+        return false;
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        m_source.data[i] = frame->data[i];
+        m_source.linesize[i] = frame->linesize[i];
+    }
+    m_source.width = frame->width;
+    m_source.height = frame->height;
+
+    m_coefficients = YuvConvert::makeCoefficients(VideoFrame::colorMatrix(frame),
+                                                  VideoFrame::isFullRange(frame));
+    return true;
+}
+
+void FrameConverter::convertSlices()
+{
+    const int height = m_source.height;
+    int slices = 1;
+    if (!m_tasks.isEmpty() && m_source.width * height >= kMinPixelsForSlicing) {
+        slices = m_maxSlices;
+    }
+    m_lastSlices = slices;
+
+    if (slices == 1) {
+        m_convertRows(m_source, m_coefficients, m_dst, m_dstLinesize, 0, height);
+        return;
+    }
+
+    // 分片起始行保持偶数，4:2:0的色度行不会被两个分片拆开
+    const int rowsPerSlice = ((height + slices - 1) / slices + 1) & ~1;
+    int firstEnd = qMin(rowsPerSlice, height);
+    int submitted = 0;
+    for (int i = 1; i < slices; ++i) {
+        int rowStart = i * rowsPerSlice;
+        if (rowStart >= height) {
+            break;
+        }
+        SliceTask *task = m_tasks[i - 1];
+        task->m_rowStart = rowStart;
+        task->m_rowEnd = qMin(rowStart + rowsPerSlice, height);
+        m_threadPool.start(task);
+        submitted++;
+    }
+
+    // 第一个分片在当前线程上转换，然后等待其余分片完成
+    m_convertRows(m_source, m_coefficients, m_dst, m_dstLinesize, 0, firstEnd);
+    m_slicesDone.acquire(submitted);
+}
+
+bool FrameConverter::convertWithSwscale(const AVFrame *frame, QImage &image)
+{
+    // 只在源/目标尺寸或像素格式变化时重建缩放器
+    if (!m_swsContext
+        || m_swsSrcWidth != frame->width || m_swsSrcHeight != frame->height
+        || m_swsSrcFormat != frame->format
+        || m_swsDstWidth != image.width() || m_swsDstHeight != image.height()) {
+        freeSwsContexts();
+
+        m_swsContext = createSwsContext(frame, image);
+        if (!m_swsContext) {
+            qCritical() << "Failed to create sws context";
+            m_swsSrcWidth = 0;
+            return false;
+        }
+
+        m_swsSrcWidth = frame->width;
+        m_swsSrcHeight = frame->height;
+        m_swsSrcFormat = frame->format;
+        m_swsDstWidth = image.width();
+        m_swsDstHeight = image.height();
+
+        qDebug() << "Frame converter swscale:"
+                 << av_get_pix_fmt_name(static_cast<AVPixelFormat>(frame->format))
+                 << frame->width << "x" << frame->height << "->"
+                 << image.width() << "x" << image.height();
+    }
+    m_usingSwscale = true;
+
+    if (scaleSlices(frame, image)) {
+        return true;
+    }
+
+    m_lastSlices = 1;
+    uint8_t *dstData[4] = { image.bits(), nullptr, nullptr, nullptr };
+    int dstLinesize[4] = { static_cast<int>(image.bytesPerLine()), 0, 0, 0 };
+    sws_scale(m_swsContext,
+              frame->data, frame->linesize,
+              0, frame->height,
+              dstData, dstLinesize);
+    return true;
+}
+
+SwsContext *FrameConverter::createSwsContext(const AVFrame *frame, const QImage &image) const
+{
+    SwsContext *context = sws_getContext(
+        frame->width, frame->height, static_cast<AVPixelFormat>(frame->format),
+        image.width(), image.height(), AV_PIX_FMT_RGB32,
+        SWS_BILINEAR, nullptr, nullptr, nullptr
+    );
+    if (!context) {
+        return nullptr;
+    }
+
+    // 与SIMD内核使用相同的颜色矩阵和范围判断
+    const bool bt709 = VideoFrame::colorMatrix(frame) == YuvConvert::MatrixBT709;
+    const int *coefficients = sws_getCoefficients(bt709 ? SWS_CS_ITU709 : SWS_CS_DEFAULT);
+    sws_setColorspaceDetails(context, coefficients, VideoFrame::isFullRange(frame) ? 1 : 0,
+                             coefficients, 1, 0, 1 << 16, 1 << 16);
+    return context;
+}
+
+bool FrameConverter::scaleSlices(const AVFrame *frame, QImage &image)
+{
+#ifdef ARDKIT_SWS_SLICES
+    // 源帧需是引用计数帧（解码输出总是如此），否则 sws_frame_start 会拷贝整帧
+    if (m_tasks.isEmpty() || !m_swsDst || !frame->buf[0] || frame->width * frame->height < kMinPixelsForSlicing) {
+        return false;
+    }
+
+    // 分片边界按缩放器要求对齐（目标色度垂直采样），对齐后只剩一片时不值得分片
+    const int height = image.height();
+    const int align = qMax(1, static_cast<int>(sws_receive_slice_alignment(m_swsContext)));
+    const int rowsPerSlice = ((height + m_maxSlices - 1) / m_maxSlices + align - 1) / align * align;
+    if (rowsPerSlice >= height) {
+        return false;
+    }
+
+    // 分片任务的缩放器在第一次分片时创建，参数与 m_swsContext 相同
+    for (SliceTask *task : m_tasks) {
+        if (!task->m_swsContext) {
+            task->m_swsContext = createSwsContext(frame, image);
+            if (!task->m_swsContext) {
+                return false;
+            }
+        }
+    }
+
+    m_swsDst->buf[0] = av_buffer_create(image.bits(), static_cast<int>(image.sizeInBytes()), noopFree, nullptr, 0);
+    if (!m_swsDst->buf[0]) {
+        return false;
+    }
+    m_swsDst->data[0] = image.bits();
+    m_swsDst->linesize[0] = static_cast<int>(image.bytesPerLine());
+    m_swsDst->width = image.width();
+    m_swsDst->height = height;
+    m_swsDst->format = AV_PIX_FMT_RGB32;
+    m_swsSrc = frame;
+    m_swsSlicing = true;
+
+    int submitted = 0;
+    for (int i = 1; i < m_maxSlices; ++i) {
+        int rowStart = i * rowsPerSlice;
+        if (rowStart >= height) {
+            break;
+        }
+        SliceTask *task = m_tasks[i - 1];
+        task->m_rowStart = rowStart;
+        task->m_rowEnd = qMin(rowStart + rowsPerSlice, height);
+        task->m_ok = true;
+        m_threadPool.start(task);
+        submitted++;
+    }
+
+    bool ok = scaleRows(m_swsContext, 0, rowsPerSlice);
+    m_slicesDone.acquire(submitted);
+    for (int i = 0; i < submitted; ++i) {
+        ok = ok && m_tasks[i]->m_ok;
+    }
+
+    m_swsSlicing = false;
+    m_swsSrc = nullptr;
+    av_frame_unref(m_swsDst);
+
+    if (!ok) {
+        qWarning() << "Sliced swscale failed, falling back to single-threaded scaling";
+        return false;
+    }
+    m_lastSlices = submitted + 1;
+    return true;
+#else
+    Q_UNUSED(frame);
+    Q_UNUSED(image);
+    return false;
+#endif
+}
+
+bool FrameConverter::scaleRows(SwsContext *context, int rowStart, int rowEnd)
+{
+#ifdef ARDKIT_SWS_SLICES
+    // 每个分片的缩放器都拿到完整输入，只输出自己的目标行
+    int ret = sws_frame_start(context, m_swsDst, m_swsSrc);
+    if (ret >= 0) {
+        ret = sws_send_slice(context, 0, m_swsSrc->height);
+    }
+    if (ret >= 0) {
+        ret = sws_receive_slice(context, rowStart, rowEnd - rowStart);
+    }
+    sws_frame_end(context);
+    return ret >= 0;
+#else
+    Q_UNUSED(context);
+    Q_UNUSED(rowStart);
+    Q_UNUSED(rowEnd);
+    return false;
+#endif
+}
+
+void FrameConverter::freeSwsContexts()
+{
+    if (m_swsContext) {
+        sws_freeContext(m_swsContext);
+        m_swsContext = nullptr;
+    }
+    for (SliceTask *task : m_tasks) {
+        if (task->m_swsContext) {
+            sws_freeContext(task->m_swsContext);
+            task->m_swsContext = nullptr;
+        }
+    }
+}
+
+void FrameConverter::reset()
+{
+    freeSwsContexts();
+    m_usingSwscale = false;
+}
+
+QString FrameConverter::backendName() const
+{
+    if (m_usingSwscale) {
+        return m_lastSlices > 1 ? QStringLiteral("swscale x%1").arg(m_lastSlices) : QStringLiteral("swscale");
+    }
+    return QStringLiteral("%1 x%2").arg(YuvConvert::kernelName(m_kernel)).arg(m_lastSlices);
+}
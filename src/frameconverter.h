@@ -0,0 +1,94 @@
+#ifndef FRAMECONVERTER_H
+#define FRAMECONVERTER_H
+
+#include <QImage>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QString>
+#include <QThreadPool>
+#include <QVector>
+#include "yuvconvert.h"
+
+extern "C" {
+#include <libavutil/frame.h>
+#include <libswscale/swscale.h>
+}
+
+/**
+ * @brief 解码帧到 RGB32 的颜色转换器
+ * 常见YUV格式使用按CPU能力选择的SIMD内核，大分辨率时按行分片并行转换；
+ * 需要缩放或其他像素格式时使用 swscale，缩放器只在尺寸或格式变化时重建；
+ * 大分辨率时每个分片使用各自的缩放器输出一段目标行（需要 libswscale 6.1 及以上）。
+ * 设置环境变量 ARDKIT_CONVERTER=c|sse2|avx2|neon|swscale 可强制使用指定实现，便于对比性能。
+ */
+class FrameConverter
+{
+public:
+    FrameConverter();
+    ~FrameConverter();
+
+    // 将frame转换到 Format_RGB32 图像中，图像尺寸小于帧时同时缩放
+    bool convert(const AVFrame *frame, QImage &image);
+
+    // 释放swscale上下文（关闭流时调用）
+    void reset();
+
+    // 当前使用的实现名称，例如 "avx2 x4" 或 "swscale"
+    QString backendName() const;
+
+private:
+    // 单个分片任务，预先创建并重复使用
+    class SliceTask : public QRunnable
+    {
+    public:
+        explicit SliceTask(FrameConverter *converter)
+            : m_converter(converter), m_rowStart(0), m_rowEnd(0), m_swsContext(nullptr), m_ok(true) { setAutoDelete(false); }
+        void run() override;
+
+        FrameConverter *m_converter;
+        int m_rowStart;
+        int m_rowEnd;
+        SwsContext *m_swsContext;   // 该分片的缩放器，与 m_swsContext 参数相同
+        bool m_ok;
+    };
+
+    YuvConvert::Kernel m_kernel;
+    YuvConvert::ConvertRowsFn m_convertRows;
+    bool m_forceSwscale;
+
+    // 当前帧的转换参数，分片任务共享
+    YuvConvert::Source m_source;
+    YuvConvert::Coefficients m_coefficients;
+    uint8_t *m_dst;
+    int m_dstLinesize;
+
+    // 分片并行
+    int m_maxSlices;
+    int m_lastSlices;
+    QThreadPool m_threadPool;
+    QVector<SliceTask *> m_tasks;
+    QSemaphore m_slicesDone;
+
+    // swscale回退
+    SwsContext *m_swsContext;
+    int m_swsSrcWidth;
+    int m_swsSrcHeight;
+    int m_swsSrcFormat;
+    int m_swsDstWidth;
+    int m_swsDstHeight;
+    bool m_usingSwscale;
+    bool m_swsSlicing;          // 当前分片任务执行缩放而不是SIMD转换
+    const AVFrame *m_swsSrc;    // 分片缩放的源帧和目标帧，分片任务共享
+    AVFrame *m_swsDst;
+
+    void selectKernel();
+    bool setupSource(const AVFrame *frame);
+    void convertSlices();
+    bool convertWithSwscale(const AVFrame *frame, QImage &image);
+    bool scaleSlices(const AVFrame *frame, QImage &image);
+    bool scaleRows(SwsContext *context, int rowStart, int rowEnd);
+    SwsContext *createSwsContext(const AVFrame *frame, const QImage &image) const;
+    void freeSwsContexts();
+};
+
+#endif // FRAMECONVERTER_H
@@ -0,0 +1,161 @@
+#include "framepool.h"
+#include <QDebug>
+
+extern "C" {
+#include <libavutil/common.h>
+#include <libavutil/mem.h>
+}
+
+namespace {
+// 行对齐到64字节，满足SIMD写入和QImage的对齐要求
+const int kLineAlignment = 64;
+}
+
+FramePool::FramePool(int poolSize)
+    : m_state(std::make_shared<State>())
+    , m_exhaustedCount(0)
+{
+    m_state->poolSize = qMax(2, poolSize);
+}
+
+FramePool::~FramePool()
+{
+    QMutexLocker locker(&m_state->mutex);
+    m_state->alive = false;
+    clearFreeBuffers();
+}
+
+void FramePool::configure(int width, int height, QImage::Format format)
+{
+    QMutexLocker locker(&m_state->mutex);
+
+    if (m_state->width == width && m_state->height == height && m_state->format == format) {
+        return;
+    }
+
+    m_state->width = width;
+    m_state->height = height;
+    m_state->format = format;
+
+    const int bytesPerPixel = QImage::toPixelFormat(format).bitsPerPixel() / 8;
+    m_state->bytesPerLine = FFALIGN(width * bytesPerPixel, kLineAlignment);
+
+    allocateBuffers();
+}
+
+void FramePool::reset()
+{
+    QMutexLocker locker(&m_state->mutex);
+    clearFreeBuffers();
+    m_state->generation++;
+    m_state->allocated = 0;
+    m_state->width = 0;
+    m_state->height = 0;
+    m_state->format = QImage::Format_Invalid;
+}
+
+QImage FramePool::acquire()
+{
+    Buffer *buffer = nullptr;
+    int width, height, bytesPerLine;
+    QImage::Format format;
+
+    {
+        QMutexLocker locker(&m_state->mutex);
+        if (m_state->freeBuffers.isEmpty()) {
+            m_exhaustedCount++;
+            return QImage();
+        }
+        buffer = m_state->freeBuffers.takeLast();
+        width = m_state->width;
+        height = m_state->height;
+        bytesPerLine = m_state->bytesPerLine;
+        format = m_state->format;
+    }
+
+    // 最后一个QImage副本析构时调用releaseBuffer归还缓冲
+    return QImage(buffer->data, width, height, bytesPerLine, format,
+                  &FramePool::releaseBuffer, buffer);
+}
+
+void FramePool::setPoolSize(int size)
+{
+    QMutexLocker locker(&m_state->mutex);
+    size = qMax(2, size);
+    if (m_state->poolSize == size) {
+        return;
+    }
+
+    m_state->poolSize = size;
+    qDebug() << "Frame pool size set to:" << size;
+
+    // 已配置时立即按新大小重新分配
+    if (m_state->width > 0 && m_state->height > 0) {
+        allocateBuffers();
+    }
+}
+
+int FramePool::poolSize() const
+{
+    QMutexLocker locker(&m_state->mutex);
+    return m_state->poolSize;
+}
+
+int FramePool::availableBuffers() const
+{
+    QMutexLocker locker(&m_state->mutex);
+    return m_state->freeBuffers.size();
+}
+
+void FramePool::releaseBuffer(void *info)
+{
+    Buffer *buffer = static_cast<Buffer *>(info);
+    std::shared_ptr<State> state = buffer->state;
+
+    QMutexLocker locker(&state->mutex);
+    if (state->alive && buffer->generation == state->generation) {
+        state->freeBuffers.append(buffer);
+        return;
+    }
+
+    // 池已销毁或已重新配置，直接释放
+    freeBuffer(buffer);
+}
+
+void FramePool::freeBuffer(Buffer *buffer)
+{
+    av_free(buffer->data);
+    delete buffer;
+}
+
+void FramePool::allocateBuffers()
+{
+    // 丢弃旧缓冲，使用中的旧缓冲归还时直接释放
+    clearFreeBuffers();
+    m_state->generation++;
+    m_state->allocated = 0;
+
+    // 预先分配全部缓冲，解码过程中不再分配
+    const size_t bufferSize = static_cast<size_t>(m_state->bytesPerLine) * m_state->height;
+    for (int i = 0; i < m_state->poolSize; ++i) {
+        uchar *data = static_cast<uchar *>(av_malloc(bufferSize));
+        if (!data) {
+            qWarning() << "Failed to allocate frame pool buffer";
+            break;
+        }
+        m_state->freeBuffers.append(new Buffer{data, m_state->generation, m_state});
+        m_state->allocated++;
+    }
+
+    qDebug() << "Frame pool configured:" << m_state->width << "x" << m_state->height
+             << "buffers:" << m_state->allocated
+             << "bytes each:" << bufferSize;
+}
+
+void FramePool::clearFreeBuffers()
+{
+    for (Buffer *buffer : m_state->freeBuffers) {
+        freeBuffer(buffer);
+    }
+    m_state->freeBuffers.clear();
+}
@@ -0,0 +1,72 @@
+#ifndef FRAMEPOOL_H
+#define FRAMEPOOL_H
+
+#include <QImage>
+#include <QMutex>
+#include <QVector>
+#include <atomic>
+#include <memory>
+
+/**
+ * @brief 预分配的帧缓冲池
+ * 颜色转换直接写入池中的缓冲，缓冲以 QImage 形式交给渲染和截图使用。
+ * 最后一个引用该缓冲的 QImage 析构时，缓冲自动归还到池中，稳态下每帧零分配。
+ */
+class FramePool
+{
+public:
+    explicit FramePool(int poolSize = 4);
+    ~FramePool();
+
+    // 按尺寸和格式准备缓冲；参数不变时直接返回
+    void configure(int width, int height, QImage::Format format);
+
+    // 释放空闲缓冲，仍在使用中的缓冲归还时再释放
+    void reset();
+
+    // 取出一个空闲缓冲，池耗尽时返回空 QImage
+    QImage acquire();
+
+    // 池大小（缓冲数量），已配置时立即重新分配
+    void setPoolSize(int size);
+    int poolSize() const;
+
+    // 统计信息
+    int availableBuffers() const;
+    quint64 exhaustedCount() const { return m_exhaustedCount; }
+    void resetStatistics() { m_exhaustedCount = 0; }
+
+private:
+    struct State;
+
+    // 单个缓冲：数据和所属的池状态一起分配，归还时无需额外分配
+    struct Buffer {
+        uchar *data;
+        int generation;
+        std::shared_ptr<State> state;
+    };
+
+    // 池状态与 FramePool 解耦，池销毁后仍在使用的缓冲可以安全归还
+    struct State {
+        QMutex mutex;
+        QVector<Buffer *> freeBuffers;
+        int width = 0;
+        int height = 0;
+        int bytesPerLine = 0;
+        QImage::Format format = QImage::Format_Invalid;
+        int poolSize = 0;
+        int allocated = 0;
+        int generation = 0;
+        bool alive = true;
+    };
+
+    std::shared_ptr<State> m_state;
+    std::atomic<quint64> m_exhaustedCount;
+
+    static void releaseBuffer(void *info);
+    static void freeBuffer(Buffer *buffer);
+    void allocateBuffers();
+    void clearFreeBuffers();
+};
+
+#endif // FRAMEPOOL_H
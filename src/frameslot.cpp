@@ -0,0 +1,67 @@
+#include "frameslot.h"
+
+FrameSlot::FrameSlot()
+    : m_middle(1)
+    , m_writeIndex(0)
+    , m_readIndex(2)
+    , m_wakePending(false)
+    , m_publishedFrames(0)
+    , m_droppedFrames(0)
+{
+}
+
+bool FrameSlot::publish(const VideoFrame &frame)
+{
+    m_buffers[m_writeIndex] = frame;
+
+    // 写缓冲与中间缓冲交换，换回的缓冲成为下一次的写缓冲
+    const int previous = m_middle.exchange(m_writeIndex | kFreshBit, std::memory_order_acq_rel);
+    m_writeIndex = previous & kIndexMask;
+    m_publishedFrames++;
+
+    // 换回的是未被读取的帧，说明渲染端来不及显示
+    if (previous & kFreshBit) {
+        m_droppedFrames++;
+    }
+
+    // 立即释放换回缓冲中的引用，帧池缓冲尽快归还
+    m_buffers[m_writeIndex] = VideoFrame();
+
+    return !m_wakePending.exchange(true, std::memory_order_acq_rel);
+}
+
+void FrameSlot::clearWakePending()
+{
+    m_wakePending.store(false, std::memory_order_release);
+}
+
+bool FrameSlot::acquire(VideoFrame &frame)
+{
+    if (!(m_middle.load(std::memory_order_acquire) & kFreshBit)) {
+        return false;
+    }
+
+    // 读缓冲与中间缓冲交换，取出新帧后读缓冲不再持有引用
+    const int previous = m_middle.exchange(m_readIndex, std::memory_order_acq_rel);
+    m_readIndex = previous & kIndexMask;
+    frame = std::move(m_buffers[m_readIndex]);
+    m_buffers[m_readIndex] = VideoFrame();
+    return true;
+}
+
+void FrameSlot::clear()
+{
+    for (VideoFrame &buffer : m_buffers) {
+        buffer = VideoFrame();
+    }
+    m_writeIndex = 0;
+    m_middle.store(1, std::memory_order_release);
+    m_readIndex = 2;
+    m_wakePending.store(false, std::memory_order_release);
+}
+
+void FrameSlot::resetStatistics()
+{
+    m_publishedFrames = 0;
+    m_droppedFrames = 0;
+}
@@ -0,0 +1,51 @@
+#ifndef FRAMESLOT_H
+#define FRAMESLOT_H
+
+#include <QtGlobal>
+#include <atomic>
+#include "videoframe.h"
+
+/**
+ * @brief 解码线程到渲染线程的最新帧交接（无锁三缓冲）
+ * 解码线程写入后与中间缓冲交换，渲染线程在 updatePaintNode 中取走中间缓冲。
+ * 渲染来不及取走的帧被新帧覆盖并计入丢帧；唤醒通知合并，任何时刻最多只有一个待处理。
+ * 只允许一个写线程和一个读线程。
+ */
+class FrameSlot
+{
+public:
+    FrameSlot();
+
+    // 解码线程：发布新帧，返回true表示需要发送唤醒通知（此前没有待处理的通知）
+    bool publish(const VideoFrame &frame);
+
+    // 处理唤醒通知时调用，此后发布的帧会再次请求唤醒
+    void clearWakePending();
+
+    // 渲染线程：取走最新帧，没有新帧时返回false
+    bool acquire(VideoFrame &frame);
+
+    // 清空所有缓冲，只能在读写双方都停止时调用
+    void clear();
+
+    // 统计信息
+    quint64 publishedFrames() const { return m_publishedFrames; }
+    quint64 droppedFrames() const { return m_droppedFrames; }
+    void resetStatistics();
+
+private:
+    // 中间缓冲索引的低两位为缓冲编号，该位表示中间缓冲中是未读的新帧
+    static const int kFreshBit = 4;
+    static const int kIndexMask = 3;
+
+    VideoFrame m_buffers[3];
+    std::atomic<int> m_middle;
+    int m_writeIndex;        // 仅写线程访问
+    int m_readIndex;         // 仅读线程访问
+    std::atomic<bool> m_wakePending;
+
+    std::atomic<quint64> m_publishedFrames;
+    std::atomic<quint64> m_droppedFrames;
+};
+
+#endif // FRAMESLOT_H
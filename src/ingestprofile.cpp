@@ -0,0 +1,96 @@
+#include "ingestprofile.h"
+#include <QVariantMap>
+
+namespace {
+IngestProfile makeUltraLowLatency()
+{
+    IngestProfile profile;
+    profile.name = QStringLiteral("ultra-low-latency");
+    profile.label = QStringLiteral("超低延迟");
+    profile.transport = QStringLiteral("auto");
+    profile.noBuffer = true;
+    profile.flushPackets = true;
+    profile.lowDelay = true;
+    profile.probeSize = 32 * 1024;
+    profile.analyzeDurationUs = 200000;
+    profile.reorderQueueSize = 16;       // UDP时只容忍很短的乱序
+    profile.bufferSize = 256 * 1024;
+    profile.maxDelayUs = 50000;
+    profile.timeoutUs = 3000000;
+    profile.udpLossThreshold = 0.01;
+    return profile;
+}
+
+IngestProfile makeBalanced()
+{
+    // 与引入接入配置之前的固定参数一致（TCP），已保存的地址升级后行为不变；自动传输仅在超低延迟配置中启用
+    IngestProfile profile;
+    profile.name = QStringLiteral("balanced");
+    profile.label = QStringLiteral("均衡");
+    profile.transport = QStringLiteral("tcp");
+    profile.noBuffer = false;
+    profile.flushPackets = false;
+    profile.lowDelay = false;
+    profile.probeSize = 5000000;
+    profile.analyzeDurationUs = 5000000;
+    profile.reorderQueueSize = -1;
+    profile.bufferSize = 0;
+    profile.maxDelayUs = 500000;
+    profile.timeoutUs = 5000000;
+    profile.udpLossThreshold = 0.02;
+    return profile;
+}
+
+IngestProfile makeRobust()
+{
+    IngestProfile profile;
+    profile.name = QStringLiteral("robust");
+    profile.label = QStringLiteral("稳定");
+    profile.transport = QStringLiteral("tcp");
+    profile.noBuffer = false;
+    profile.flushPackets = false;
+    profile.lowDelay = false;
+    profile.probeSize = 10000000;
+    profile.analyzeDurationUs = 10000000;
+    profile.reorderQueueSize = 500;
+    profile.bufferSize = 4 * 1024 * 1024;
+    profile.maxDelayUs = 1000000;
+    profile.timeoutUs = 8000000;
+    profile.udpLossThreshold = 0.05;
+    return profile;
+}
+}
+
+QString IngestProfile::defaultName()
+{
+    return QStringLiteral("balanced");
+}
+
+QStringList IngestProfile::names()
+{
+    return { QStringLiteral("ultra-low-latency"), QStringLiteral("balanced"), QStringLiteral("robust") };
+}
+
+IngestProfile IngestProfile::byName(const QString &name)
+{
+    if (name == QLatin1String("ultra-low-latency")) {
+        return makeUltraLowLatency();
+    }
+    if (name == QLatin1String("robust")) {
+        return makeRobust();
+    }
+    return makeBalanced();
+}
+
+QVariantList IngestProfile::descriptions()
+{
+    QVariantList list;
+    for (const QString &name : names()) {
+        const IngestProfile profile = byName(name);
+        QVariantMap entry;
+        entry.insert("name", profile.name);
+        entry.insert("label", profile.label);
+        list.append(entry);
+    }
+    return list;
+}
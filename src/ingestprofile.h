@@ -0,0 +1,41 @@
+#ifndef INGESTPROFILE_H
+#define INGESTPROFILE_H
+
+#include <QString>
+#include <QStringList>
+#include <QVariantList>
+#include <cstdint>
+
+/**
+ * @brief 接入配置
+ * 决定打开流时解复用器和解码器在延迟与抗抖动之间的取舍，按设备地址保存和选择。
+ * ultra-low-latency：不缓冲、最小探测、解码器低延迟模式，适合稳定的有线链路；
+ * balanced：默认；robust：更大的缓冲和重排队列，适合丢包和抖动明显的无线链路。
+ */
+struct IngestProfile
+{
+    QString name;
+    QString label;               // 界面显示名称
+    QString transport;           // RTSP传输方式（tcp / udp / auto：先用UDP，丢包严重或不通时切换到TCP）
+    bool noBuffer;               // AVFMT_FLAG_NOBUFFER：探测阶段读到的数据包不缓存
+    bool flushPackets;           // AVFMT_FLAG_FLUSH_PACKETS：每个数据包立即刷新IO
+    bool lowDelay;               // AV_CODEC_FLAG_LOW_DELAY：解码器不为重排等待
+    int64_t probeSize;           // 探测数据量（字节）
+    int64_t analyzeDurationUs;   // 探测时长
+    int reorderQueueSize;        // RTP重排队列（包数），-1表示FFmpeg默认
+    int bufferSize;              // 套接字接收缓冲（字节），0表示系统默认
+    int64_t maxDelayUs;          // 解复用最大延迟
+    int64_t timeoutUs;           // 套接字超时
+    double udpLossThreshold;     // auto 传输：UDP丢包率超过该值时切换到TCP
+
+    static QString defaultName();
+    static QStringList names();
+
+    // 未知名称返回默认配置
+    static IngestProfile byName(const QString &name);
+
+    // 供界面使用：[{ name, label }, ...]
+    static QVariantList descriptions();
+};
+
+#endif // INGESTPROFILE_H
@@ -0,0 +1,78 @@
+#include "iowaker.h"
+#include <QDebug>
+#include <QMutexLocker>
+
+#if defined(Q_OS_UNIX)
+#include <csignal>
+#include <cstring>
+#include <mutex>
+#endif
+
+namespace {
+#if defined(Q_OS_UNIX)
+// 唤醒用的信号：默认动作为忽略，其他来源的该信号不会影响进程
+const int kWakeSignal = SIGURG;
+
+void wakeHandler(int)
+{
+}
+
+// 只在该信号没有被其他代码接管时安装处理函数，返回能否使用
+bool installWakeHandler()
+{
+    static bool installed = false;
+    static std::once_flag once;
+    std::call_once(once, []() {
+        struct sigaction current;
+        if (sigaction(kWakeSignal, nullptr, &current) != 0) {
+            return;
+        }
+        if (!(current.sa_flags & SA_SIGINFO) && current.sa_handler != SIG_DFL && current.sa_handler != SIG_IGN) {
+            qWarning() << "IoWaker: SIGURG already handled, blocked network waits will not be woken early";
+            return;
+        }
+
+        // 不设置 SA_RESTART：被打断的系统调用返回 EINTR
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_handler = wakeHandler;
+        sigemptyset(&action.sa_mask);
+        installed = sigaction(kWakeSignal, &action, nullptr) == 0;
+    });
+    return installed;
+}
+#endif
+}
+
+IoWaker::IoWaker()
+    : m_attached(false)
+{
+}
+
+IoWaker::ThreadScope::ThreadScope(IoWaker *waker)
+    : m_waker(waker)
+{
+    QMutexLocker locker(&m_waker->m_mutex);
+#if defined(Q_OS_UNIX)
+    if (installWakeHandler()) {
+        m_waker->m_thread = pthread_self();
+        m_waker->m_attached = true;
+    }
+#endif
+}
+
+IoWaker::ThreadScope::~ThreadScope()
+{
+    QMutexLocker locker(&m_waker->m_mutex);
+    m_waker->m_attached = false;
+}
+
+void IoWaker::wake()
+{
+    QMutexLocker locker(&m_mutex);
+#if defined(Q_OS_UNIX)
+    if (m_attached) {
+        pthread_kill(m_thread, kWakeSignal);
+    }
+#endif
+}
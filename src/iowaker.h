@@ -0,0 +1,45 @@
+#ifndef IOWAKER_H
+#define IOWAKER_H
+
+#include <QMutex>
+#include <QtGlobal>
+
+#if defined(Q_OS_UNIX)
+#include <pthread.h>
+#endif
+
+/**
+ * @brief 唤醒阻塞在网络等待中的线程
+ * FFmpeg 的网络等待（poll）每100ms才检查一次中断回调，停止请求最多因此延迟一个周期。
+ * POSIX 下向登记的线程发送一个空处理函数的信号，poll 以 EINTR 提前返回，FFmpeg 随即检查中断回调；
+ * 其他平台 wake() 为空操作，停止仍依赖中断回调的轮询。
+ */
+class IoWaker
+{
+public:
+    IoWaker();
+
+    // 在需要被唤醒的线程中构造，析构前 wake() 对该线程有效
+    class ThreadScope
+    {
+    public:
+        explicit ThreadScope(IoWaker *waker);
+        ~ThreadScope();
+
+    private:
+        IoWaker *m_waker;
+    };
+
+    // 唤醒登记的线程（没有线程登记时忽略），应在设置停止标志之后调用
+    void wake();
+
+private:
+    // 登记和唤醒在锁内进行，线程退出 ThreadScope 之后不会再收到信号
+    QMutex m_mutex;
+    bool m_attached;
+#if defined(Q_OS_UNIX)
+    pthread_t m_thread;
+#endif
+};
+
+#endif // IOWAKER_H
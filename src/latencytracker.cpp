@@ -0,0 +1,149 @@
+#include "latencytracker.h"
+#include <QMutexLocker>
+#include <algorithm>
+#include <cmath>
+
+LatencyTracker::LatencyTracker()
+    : m_pendingHead(0)
+    , m_sampleHead(0)
+    , m_sampleCount(0)
+{
+    for (int i = 0; i < StageCount; ++i) {
+        m_samples[i].resize(kWindowSize);
+    }
+    reset();
+}
+
+void LatencyTracker::reset()
+{
+    QMutexLocker locker(&m_mutex);
+    for (int i = 0; i < kPendingSize; ++i) {
+        m_pending[i].pts = INT64_MIN;
+    }
+    m_pendingHead = 0;
+    m_sampleHead = 0;
+    m_sampleCount = 0;
+}
+
+LatencyTracker::Pending *LatencyTracker::findPending(int64_t pts)
+{
+    // 从最近登记的开始查找，通常只需几步
+    for (int i = 1; i <= kPendingSize; ++i) {
+        Pending &entry = m_pending[(m_pendingHead - i + kPendingSize) % kPendingSize];
+        if (entry.pts == pts) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+void LatencyTracker::packetReceived(int64_t pts, int64_t captureUs, int64_t receiveUs)
+{
+    QMutexLocker locker(&m_mutex);
+    Pending &entry = m_pending[m_pendingHead];
+    entry.pts = pts;
+    entry.captureUs = captureUs;
+    entry.receiveUs = receiveUs;
+    entry.dequeueUs = 0;
+    m_pendingHead = (m_pendingHead + 1) % kPendingSize;
+}
+
+void LatencyTracker::packetDequeued(int64_t pts, int64_t dequeueUs)
+{
+    QMutexLocker locker(&m_mutex);
+    Pending *entry = findPending(pts);
+    if (entry && entry->dequeueUs == 0) {
+        entry->dequeueUs = dequeueUs;
+    }
+}
+
+bool LatencyTracker::takeFrame(int64_t pts, FrameTimes *times)
+{
+    QMutexLocker locker(&m_mutex);
+    Pending *entry = findPending(pts);
+    if (!entry || entry->dequeueUs == 0) {
+        return false;
+    }
+
+    times->captureUs = entry->captureUs;
+    times->receiveUs = entry->receiveUs;
+    times->dequeueUs = entry->dequeueUs;
+    times->decodedUs = 0;
+    times->convertedUs = 0;
+    times->presentedUs = 0;
+    entry->pts = INT64_MIN;
+    return true;
+}
+
+void LatencyTracker::addFrame(const FrameTimes &times)
+{
+    QMutexLocker locker(&m_mutex);
+    m_samples[StageNetwork][m_sampleHead] = times.receiveUs - times.captureUs;
+    m_samples[StageQueue][m_sampleHead] = times.dequeueUs - times.receiveUs;
+    m_samples[StageDecode][m_sampleHead] = times.decodedUs - times.dequeueUs;
+    m_samples[StageConvert][m_sampleHead] = times.convertedUs - times.decodedUs;
+    m_samples[StagePresent][m_sampleHead] = times.presentedUs - times.convertedUs;
+    m_samples[StageTotal][m_sampleHead] = times.presentedUs - times.captureUs;
+    m_sampleHead = (m_sampleHead + 1) % kWindowSize;
+    m_sampleCount = qMin(m_sampleCount + 1, kWindowSize);
+}
+
+double LatencyTracker::percentile(QVector<int64_t> &values, double fraction)
+{
+    // 最近秩法：第 ceil(p*n) 个样本
+    const int n = values.size();
+    int index = static_cast<int>(std::ceil(fraction * n)) - 1;
+    index = qBound(0, index, n - 1);
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index] / 1000.0;
+}
+
+QVariantMap LatencyTracker::snapshot() const
+{
+    QVariantMap result;
+    QMutexLocker locker(&m_mutex);
+    if (m_sampleCount == 0) {
+        return result;
+    }
+
+    for (int stage = 0; stage < StageCount; ++stage) {
+        QVector<int64_t> values = m_samples[stage].mid(0, m_sampleCount);
+        QVariantMap entry;
+        entry.insert("p50", percentile(values, 0.50));
+        entry.insert("p95", percentile(values, 0.95));
+        entry.insert("p99", percentile(values, 0.99));
+        result.insert(stageName(static_cast<Stage>(stage)), entry);
+    }
+    result.insert("samples", m_sampleCount);
+    return result;
+}
+
+double LatencyTracker::totalPercentile(double fraction) const
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_sampleCount == 0) {
+        return -1.0;
+    }
+    QVector<int64_t> values = m_samples[StageTotal].mid(0, m_sampleCount);
+    return percentile(values, fraction);
+}
+
+const char *LatencyTracker::stageName(Stage stage)
+{
+    switch (stage) {
+    case StageNetwork:
+        return "network";
+    case StageQueue:
+        return "queue";
+    case StageDecode:
+        return "decode";
+    case StageConvert:
+        return "convert";
+    case StagePresent:
+        return "present";
+    case StageTotal:
+        return "total";
+    default:
+        return "unknown";
+    }
+}
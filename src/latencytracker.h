@@ -0,0 +1,85 @@
+#ifndef LATENCYTRACKER_H
+#define LATENCYTRACKER_H
+
+#include <QMutex>
+#include <QVariantMap>
+#include <QVector>
+#include <cstdint>
+
+/**
+ * @brief 端到端延迟统计
+ * 发送端在每帧中嵌入墙上时钟（见 SeiTimestamp），解复用线程登记接收时刻，
+ * 解码线程在出队、解码、转换、交给渲染端时依次打点，按阶段保存最近若干帧的延迟，
+ * 由GUI线程取分位数。所有时刻均为 av_gettime（墙上时钟，微秒），网络阶段和总延迟要求两端时钟同步。
+ */
+class LatencyTracker
+{
+public:
+    enum Stage {
+        StageNetwork = 0,    // 发送 -> 解复用收到
+        StageQueue = 1,      // 收到 -> 解码线程取出
+        StageDecode = 2,     // 取出 -> 解码器输出帧（含B帧重排和帧级多线程延迟）
+        StageConvert = 3,    // 输出帧 -> 颜色转换完成
+        StagePresent = 4,    // 转换完成 -> 交给渲染端（含呈现时钟等待）
+        StageTotal = 5,      // 发送 -> 交给渲染端
+        StageCount = 6
+    };
+
+    // 单帧在各阶段的时刻
+    struct FrameTimes {
+        int64_t captureUs;
+        int64_t receiveUs;
+        int64_t dequeueUs;
+        int64_t decodedUs;
+        int64_t convertedUs;
+        int64_t presentedUs;
+    };
+
+    LatencyTracker();
+
+    void reset();
+
+    // 解复用线程：带时间戳SEI的packet入队前调用
+    void packetReceived(int64_t pts, int64_t captureUs, int64_t receiveUs);
+
+    // 解码线程：packet出队时调用
+    void packetDequeued(int64_t pts, int64_t dequeueUs);
+
+    // 解码线程：解码器输出该PTS的帧时取出之前的时刻，没有记录时返回 false
+    bool takeFrame(int64_t pts, FrameTimes *times);
+
+    // 解码线程：帧已交给渲染端，记录一个样本
+    void addFrame(const FrameTimes &times);
+
+    // 各阶段最近样本的分位数（毫秒），键为阶段名，值为 {p50, p95, p99}；没有样本时为空
+    QVariantMap snapshot() const;
+
+    // 总延迟分位数（毫秒），没有样本时为 -1
+    double totalPercentile(double fraction) const;
+
+    static const char *stageName(Stage stage);
+
+private:
+    static const int kPendingSize = 512;    // 在途packet（覆盖最大的队列深度）
+    static const int kWindowSize = 600;     // 每阶段保留的样本数（30fps下约20秒）
+
+    struct Pending {
+        int64_t pts;
+        int64_t captureUs;
+        int64_t receiveUs;
+        int64_t dequeueUs;
+    };
+
+    mutable QMutex m_mutex;
+    Pending m_pending[kPendingSize];
+    int m_pendingHead;
+
+    QVector<int64_t> m_samples[StageCount];
+    int m_sampleHead;
+    int m_sampleCount;
+
+    Pending *findPending(int64_t pts);
+    static double percentile(QVector<int64_t> &values, double fraction);
+};
+
+#endif // LATENCYTRACKER_H
@@ -10,6 +10,8 @@
 #include "connectionmanager.h"
 #include "configmanager.h"
 #include "messagelogger.h"
+#include "metricsexporter.h"
+#include "clipexporter.h"
 
 int main(int argc, char *argv[])
 {
@@ -40,6 +42,8 @@ int main(int argc, char *argv[])
     ConnectionManager connectionManager;
     ConfigManager configManager;
     MessageLogger messageLogger;
+    MetricsExporter metricsExporter(&videoHandler);
+    ClipExporter clipExporter;
 
     // 设置日志的最大行数从配置读取
     messageLogger.setMaxLines(configManager.maxLogLines());
@@ -56,11 +60,46 @@ int main(int argc, char *argv[])
     QObject::connect(&videoHandler, &VideoHandler::errorOccurred,
                      &messageLogger, &MessageLogger::addErrorMessage);
 
+    // 连接信号：截图和连拍在后台编码完成后记录日志
+    QObject::connect(&videoHandler, &VideoHandler::screenshotSaved, [&](const QString &filePath) {
+        messageLogger.addInfoMessage(QString("截图已保存: %1").arg(filePath));
+    });
+    QObject::connect(&videoHandler, &VideoHandler::burstSaved, [&](const QString &filePath, int frames) {
+        messageLogger.addInfoMessage(QString("连拍已保存: %1 帧 (%2)").arg(frames).arg(filePath));
+    });
+
+    // 连接信号：片段导出完成或失败时记录日志
+    QObject::connect(&clipExporter, &ClipExporter::finished, [&](const QString &filePath, bool success) {
+        if (success) {
+            messageLogger.addInfoMessage(QString("片段已导出: %1").arg(filePath));
+        }
+    });
+    QObject::connect(&clipExporter, &ClipExporter::errorOccurred,
+                     &messageLogger, &MessageLogger::addErrorMessage);
+
     // 连接信号：连接管理器错误时记录日志
     QObject::connect(&connectionManager, &ConnectionManager::errorOccurred,
                      &messageLogger, &MessageLogger::addErrorMessage);
 
+    // 指标导出（端口/文件来自配置，可用环境变量 ARDKIT_METRICS_PORT / ARDKIT_METRICS_FILE 覆盖）
+    auto applyMetricsExport = [&]() {
+        metricsExporter.setHttpPort(configManager.metricsPort());
+        metricsExporter.setLogFile(configManager.metricsFile());
+    };
+    QObject::connect(&metricsExporter, &MetricsExporter::errorOccurred,
+                     &messageLogger, &MessageLogger::addErrorMessage);
+    QObject::connect(&configManager, &ConfigManager::metricsExportChanged, applyMetricsExport);
+    applyMetricsExport();
+
+    // 录像分段和同步策略（下一次录像时生效）
+    auto applyRecordingOptions = [&]() {
+        videoHandler.setRecordingOptions(configManager.recordSegmentSeconds(), configManager.recordSyncPolicy());
+    };
+    QObject::connect(&configManager, &ConfigManager::recordingOptionsChanged, applyRecordingOptions);
+    applyRecordingOptions();
+
     // 连接信号：视频流错误时自动断开连接
+    // 短暂断线由解码器内部重连，只有重连失败后才会收到这些错误
     QObject::connect(&videoHandler, &VideoHandler::errorOccurred, [&](const QString &error) {
         // 如果是流相关的严重错误，自动断开连接
         if (error.contains("Failed to open video stream") ||
@@ -74,12 +113,20 @@ int main(int argc, char *argv[])
         }
     });
 
+    // 连接信号：完整探测得到的流参数写入配置缓存，缓存与实际码流不符时删除
+    QObject::connect(&videoHandler, &VideoHandler::streamInfoProbed,
+                     &configManager, &ConfigManager::setStreamInfoCache);
+    QObject::connect(&videoHandler, &VideoHandler::streamInfoRejected,
+                     &configManager, &ConfigManager::removeStreamInfoCache);
+
     // 连接信号：当连接到设备时启动视频流
     QObject::connect(&connectionManager, &ConnectionManager::isConnectedChanged, [&]() {
         if (connectionManager.isConnected()) {
             QString address = connectionManager.deviceAddress();
             qDebug() << "Device connected, starting video from:" << address;
             videoHandler.setVideoSource(address);
+            videoHandler.setIngestProfile(configManager.ingestProfile(address));
+            videoHandler.setCachedStreamInfo(configManager.streamInfoCache(address));
             videoHandler.startVideo();
 
             // 如果视频流未能启动，断开连接
@@ -108,6 +155,7 @@ int main(int argc, char *argv[])
     engine.rootContext()->setContextProperty("connectionManager", &connectionManager);
     engine.rootContext()->setContextProperty("configManager", &configManager);
     engine.rootContext()->setContextProperty("messageLogger", &messageLogger);
+    engine.rootContext()->setContextProperty("clipExporter", &clipExporter);
 
     // 加载 QML 主文件
     const QUrl url(QStringLiteral("qrc:/qml/main.qml"));
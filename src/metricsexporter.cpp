@@ -0,0 +1,334 @@
+#include "metricsexporter.h"
+#include "processstats.h"
+#include "videohandler.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDebug>
+#include <QFileInfo>
+#include <QHostAddress>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+
+namespace {
+const int kCollectIntervalMs = 1000;
+
+// 指标文件轮转：单个文件上限和保留的历史文件数（file.1 ... file.N）
+const qint64 kMaxLogFileBytes = 32 * 1024 * 1024;
+const int kMaxLogFiles = 5;
+
+// HTTP请求头上限，超过后直接断开
+const int kMaxRequestBytes = 8192;
+
+QByteArray escapeLabel(const QString &value)
+{
+    QByteArray escaped = value.toUtf8();
+    escaped.replace('\\', "\\\\");
+    escaped.replace('"', "\\\"");
+    escaped.replace('\n', "\\n");
+    return escaped;
+}
+
+void appendMetric(QByteArray &out, const char *name, const char *type, double value)
+{
+    out += QByteArray("# TYPE ") + name + ' ' + type + '\n';
+    out += QByteArray(name) + ' ' + QByteArray::number(value, 'g', 10) + '\n';
+}
+
+// 分位数序列：name{<labelName>="<key>",quantile="0.5"} value
+void appendQuantiles(QByteArray &out, const char *name, const char *labelName, const QVariantMap &entries)
+{
+    if (entries.isEmpty()) {
+        return;
+    }
+    out += QByteArray("# TYPE ") + name + " gauge\n";
+    for (auto it = entries.constBegin(); it != entries.constEnd(); ++it) {
+        const QVariantMap entry = it.value().toMap();
+        if (entry.isEmpty()) {
+            continue;
+        }
+        static const char *const quantiles[][2] = { { "p50", "0.5" }, { "p95", "0.95" }, { "p99", "0.99" } };
+        for (const auto &quantile : quantiles) {
+            out += QByteArray(name) + '{' + labelName + "=\"" + escapeLabel(it.key())
+                   + "\",quantile=\"" + quantile[1] + "\"} "
+                   + QByteArray::number(entry.value(quantile[0]).toDouble(), 'g', 10) + '\n';
+        }
+    }
+}
+}
+
+MetricsExporter::MetricsExporter(VideoHandler *videoHandler, QObject *parent)
+    : QObject(parent)
+    , m_videoHandler(videoHandler)
+    , m_server(nullptr)
+{
+    m_timer.setInterval(kCollectIntervalMs);
+    connect(&m_timer, &QTimer::timeout, this, &MetricsExporter::collect);
+}
+
+MetricsExporter::~MetricsExporter()
+{
+    setHttpPort(0);
+    setLogFile(QString());
+}
+
+bool MetricsExporter::setHttpPort(int port)
+{
+    if (m_server && m_server->serverPort() == port) {
+        return true;
+    }
+
+    if (m_server) {
+        m_server->close();
+        delete m_server;
+        m_server = nullptr;
+        qDebug() << "Metrics endpoint stopped";
+    }
+
+    bool ok = true;
+    if (port > 0) {
+        // 只监听本机，不对外暴露
+        m_server = new QTcpServer(this);
+        connect(m_server, &QTcpServer::newConnection, this, &MetricsExporter::onNewConnection);
+        if (m_server->listen(QHostAddress::LocalHost, static_cast<quint16>(port))) {
+            qDebug() << "Metrics endpoint listening on http://127.0.0.1:" << port << "/metrics";
+        } else {
+            const QString error = QString("Metrics endpoint failed to listen on port %1: %2")
+                                      .arg(port).arg(m_server->errorString());
+            qWarning() << error;
+            emit errorOccurred(error);
+            delete m_server;
+            m_server = nullptr;
+            ok = false;
+        }
+    }
+
+    updateTimer();
+    return ok;
+}
+
+int MetricsExporter::httpPort() const
+{
+    return m_server ? m_server->serverPort() : 0;
+}
+
+bool MetricsExporter::setLogFile(const QString &path)
+{
+    if (path == m_logFilePath && (path.isEmpty() || m_logFile.isOpen())) {
+        return true;
+    }
+
+    if (m_logFile.isOpen()) {
+        m_logFile.close();
+        qDebug() << "Metrics file closed:" << m_logFilePath;
+    }
+    m_logFilePath = path;
+
+    bool ok = true;
+    if (!path.isEmpty()) {
+        m_logFile.setFileName(path);
+        if (m_logFile.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+            qDebug() << "Writing metrics to:" << path;
+        } else {
+            const QString error = QString("Failed to open metrics file %1: %2").arg(path, m_logFile.errorString());
+            qWarning() << error;
+            emit errorOccurred(error);
+            ok = false;
+        }
+    }
+
+    updateTimer();
+    return ok;
+}
+
+void MetricsExporter::updateTimer()
+{
+    // 两种导出都关闭时停止采集
+    if (m_server || m_logFile.isOpen()) {
+        if (!m_timer.isActive()) {
+            collect();
+            m_timer.start();
+        }
+    } else {
+        m_timer.stop();
+        m_latestSample.clear();
+    }
+}
+
+void MetricsExporter::collect()
+{
+    m_latestSample = collectSample();
+    if (m_logFile.isOpen()) {
+        writeLogLine(m_latestSample);
+    }
+}
+
+QVariantMap MetricsExporter::collectSample() const
+{
+    QVariantMap sample;
+    sample.insert("time", QDateTime::currentDateTimeUtc().toString(Qt::ISODateWithMs));
+    sample.insert("version", QCoreApplication::applicationVersion());
+
+    // 视频流水线（VideoHandler 每秒采样的快照）
+    const bool playing = m_videoHandler->isPlaying();
+    const QVariantMap metrics = playing ? m_videoHandler->metrics() : QVariantMap();
+    const QVariantMap counters = metrics.value("counters").toMap();
+    sample.insert("playing", playing);
+    sample.insert("streamState", m_videoHandler->streamState());
+    sample.insert("transport", m_videoHandler->transport());
+    sample.insert("fps", counters.value("framesRendered").toMap().value("rate").toDouble());
+    sample.insert("decodeFps", counters.value("framesDecoded").toMap().value("rate").toDouble());
+    sample.insert("bitrate", playing ? m_videoHandler->bitrate() : 0);
+    sample.insert("queueDepth", m_videoHandler->packetQueueDepth());
+    sample.insert("framesDropped", m_videoHandler->droppedFrames());
+    sample.insert("packetsDropped", m_videoHandler->droppedPackets());
+    sample.insert("reconnects", m_videoHandler->reconnectCount());
+    sample.insert("rtpLossRate", m_videoHandler->rtpLossRate());
+    sample.insert("replayBufferBytes", m_videoHandler->replayBufferBytes());
+    sample.insert("replayBufferMemory", m_videoHandler->replayBufferMemory());
+    sample.insert("replayBufferMs", m_videoHandler->replayBufferDurationMs());
+    sample.insert("latency", playing ? m_videoHandler->latency() : QVariantMap());
+    sample.insert("pipeline", metrics.value("histograms").toMap());
+
+    // 进程资源；同名线程（如解码器的工作线程）合并
+    sample.insert("rssBytes", ProcessStats::residentBytes());
+    QVariantMap threads;
+    double processCpu = 0.0;
+    for (const ProcessStats::ThreadCpu &thread : ProcessStats::threadCpuTimes()) {
+        const QString name = thread.name.isEmpty() ? QString("tid-%1").arg(thread.id) : thread.name;
+        threads.insert(name, threads.value(name).toDouble() + thread.cpuSeconds);
+        processCpu += thread.cpuSeconds;
+    }
+    sample.insert("threadCpuSeconds", threads);
+    sample.insert("cpuSeconds", processCpu);
+    return sample;
+}
+
+QByteArray MetricsExporter::prometheusText() const
+{
+    const QVariantMap &sample = m_latestSample;
+    QByteArray out;
+
+    appendMetric(out, "ardkit_playing", "gauge", sample.value("playing").toBool() ? 1 : 0);
+    appendMetric(out, "ardkit_stream_state", "gauge", sample.value("streamState").toDouble());
+    appendMetric(out, "ardkit_fps", "gauge", sample.value("fps").toDouble());
+    appendMetric(out, "ardkit_decode_fps", "gauge", sample.value("decodeFps").toDouble());
+    appendMetric(out, "ardkit_bitrate_bps", "gauge", sample.value("bitrate").toDouble());
+    appendMetric(out, "ardkit_packet_queue_depth", "gauge", sample.value("queueDepth").toDouble());
+    appendMetric(out, "ardkit_frames_dropped_total", "counter", sample.value("framesDropped").toDouble());
+    appendMetric(out, "ardkit_packets_dropped_total", "counter", sample.value("packetsDropped").toDouble());
+    appendMetric(out, "ardkit_reconnects_total", "counter", sample.value("reconnects").toDouble());
+    appendMetric(out, "ardkit_rtp_loss_ratio", "gauge", sample.value("rtpLossRate").toDouble());
+    appendMetric(out, "ardkit_replay_buffer_bytes", "gauge", sample.value("replayBufferBytes").toDouble());
+    appendMetric(out, "ardkit_replay_buffer_memory_bytes", "gauge", sample.value("replayBufferMemory").toDouble());
+    appendMetric(out, "ardkit_replay_buffer_seconds", "gauge", sample.value("replayBufferMs").toDouble() / 1000.0);
+    appendMetric(out, "ardkit_resident_memory_bytes", "gauge", sample.value("rssBytes").toDouble());
+    appendMetric(out, "ardkit_cpu_seconds_total", "counter", sample.value("cpuSeconds").toDouble());
+
+    appendQuantiles(out, "ardkit_latency_ms", "stage", sample.value("latency").toMap());
+    appendQuantiles(out, "ardkit_pipeline", "metric", sample.value("pipeline").toMap());
+
+    const QVariantMap threads = sample.value("threadCpuSeconds").toMap();
+    if (!threads.isEmpty()) {
+        out += "# TYPE ardkit_thread_cpu_seconds_total counter\n";
+        for (auto it = threads.constBegin(); it != threads.constEnd(); ++it) {
+            out += "ardkit_thread_cpu_seconds_total{thread=\"" + escapeLabel(it.key()) + "\"} "
+                   + QByteArray::number(it.value().toDouble(), 'g', 10) + '\n';
+        }
+    }
+    return out;
+}
+
+void MetricsExporter::writeLogLine(const QVariantMap &sample)
+{
+    if (m_logFile.size() >= kMaxLogFileBytes) {
+        rotateLogFile();
+        if (!m_logFile.isOpen()) {
+            return;
+        }
+    }
+
+    // 每行一个紧凑JSON，立即刷新，异常退出也只丢最后一行
+    m_logFile.write(QJsonDocument(QJsonObject::fromVariantMap(sample)).toJson(QJsonDocument::Compact));
+    m_logFile.write("\n");
+    m_logFile.flush();
+}
+
+void MetricsExporter::rotateLogFile()
+{
+    m_logFile.close();
+
+    // file.N-1 -> file.N ... file -> file.1，最旧的文件被删除
+    QFile::remove(QString("%1.%2").arg(m_logFilePath).arg(kMaxLogFiles));
+    for (int i = kMaxLogFiles - 1; i >= 1; --i) {
+        const QString from = QString("%1.%2").arg(m_logFilePath).arg(i);
+        if (QFileInfo::exists(from)) {
+            QFile::rename(from, QString("%1.%2").arg(m_logFilePath).arg(i + 1));
+        }
+    }
+    QFile::rename(m_logFilePath, m_logFilePath + ".1");
+
+    if (!m_logFile.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+        const QString error = QString("Failed to reopen metrics file %1: %2").arg(m_logFilePath, m_logFile.errorString());
+        qWarning() << error;
+        emit errorOccurred(error);
+        return;
+    }
+    qDebug() << "Metrics file rotated:" << m_logFilePath;
+}
+
+void MetricsExporter::onNewConnection()
+{
+    while (QTcpSocket *socket = m_server->nextPendingConnection()) {
+        connect(socket, &QTcpSocket::readyRead, this, &MetricsExporter::onReadyRead);
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+    }
+}
+
+void MetricsExporter::onReadyRead()
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket *>(sender());
+    if (!socket) {
+        return;
+    }
+
+    // 等待完整的请求头；只处理请求行，忽略请求体
+    QByteArray request = socket->property("request").toByteArray() + socket->readAll();
+    if (!request.contains("\r\n\r\n")) {
+        if (request.size() > kMaxRequestBytes) {
+            socket->abort();
+            return;
+        }
+        socket->setProperty("request", request);
+        return;
+    }
+
+    const QList<QByteArray> requestLine = request.left(request.indexOf("\r\n")).split(' ');
+    const QByteArray method = requestLine.value(0);
+    QByteArray path = requestLine.value(1);
+    path = path.left(path.indexOf('?') >= 0 ? path.indexOf('?') : path.size());
+
+    if (method != "GET") {
+        sendResponse(socket, "405 Method Not Allowed", "text/plain", "Method Not Allowed\n");
+    } else if (path == "/metrics") {
+        sendResponse(socket, "200 OK", "text/plain; version=0.0.4; charset=utf-8", prometheusText());
+    } else if (path == "/metrics.json") {
+        sendResponse(socket, "200 OK", "application/json",
+                     QJsonDocument(QJsonObject::fromVariantMap(m_latestSample)).toJson(QJsonDocument::Indented));
+    } else {
+        sendResponse(socket, "404 Not Found", "text/plain", "Not Found\n");
+    }
+}
+
+void MetricsExporter::sendResponse(QTcpSocket *socket, const QByteArray &status,
+                                   const QByteArray &contentType, const QByteArray &body)
+{
+    QByteArray response = "HTTP/1.1 " + status + "\r\n"
+                          "Content-Type: " + contentType + "\r\n"
+                          "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+                          "Connection: close\r\n\r\n";
+    response += body;
+    socket->write(response);
+    socket->disconnectFromHost();
+}
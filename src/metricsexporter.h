@@ -0,0 +1,68 @@
+#ifndef METRICSEXPORTER_H
+#define METRICSEXPORTER_H
+
+#include <QFile>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <QVariantMap>
+
+class QTcpServer;
+class QTcpSocket;
+class VideoHandler;
+
+/**
+ * @brief 指标导出（长时间无人值守测试用）
+ * 每秒汇总一次视频流水线统计（帧率、码率、延迟分位数、丢帧、重连）和进程资源（内存、各线程CPU时间），
+ * 可通过本机HTTP端点读取（/metrics 为 Prometheus 文本格式，/metrics.json 为JSON），
+ * 也可每秒向文件追加一行JSON，文件超过上限后轮转。两者都关闭时不做任何采集。
+ * 流水线统计直接读取 VideoHandler 已采样的快照，不会重复采样。
+ */
+class MetricsExporter : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MetricsExporter(VideoHandler *videoHandler, QObject *parent = nullptr);
+    ~MetricsExporter() override;
+
+    // 本机HTTP端口，0表示关闭；监听失败时返回 false
+    bool setHttpPort(int port);
+    int httpPort() const;
+
+    // 指标文件路径，空表示关闭；打开失败时返回 false
+    bool setLogFile(const QString &path);
+    QString logFile() const { return m_logFilePath; }
+
+    // 最近一次采集的样本
+    QVariantMap latestSample() const { return m_latestSample; }
+
+signals:
+    void errorOccurred(const QString &error);
+
+private slots:
+    void collect();
+    void onNewConnection();
+    void onReadyRead();
+
+private:
+    VideoHandler *m_videoHandler;
+    QTimer m_timer;
+
+    QTcpServer *m_server;
+
+    QString m_logFilePath;
+    QFile m_logFile;
+
+    QVariantMap m_latestSample;
+
+    void updateTimer();
+    QVariantMap collectSample() const;
+    QByteArray prometheusText() const;
+    void writeLogLine(const QVariantMap &sample);
+    void rotateLogFile();
+    void sendResponse(QTcpSocket *socket, const QByteArray &status,
+                      const QByteArray &contentType, const QByteArray &body);
+};
+
+#endif // METRICSEXPORTER_H
@@ -0,0 +1,243 @@
+#include "packetqueue.h"
+#include <QDebug>
+
+PacketQueue::PacketQueue(int capacity)
+    : m_capacity(qMax(1, capacity))
+    , m_dropOnOverflow(true)
+    , m_aborted(false)
+    , m_waitForKeyframe(false)
+    , m_highWaterMark(0)
+    , m_droppedPackets(0)
+{
+}
+
+PacketQueue::~PacketQueue()
+{
+    clear();
+
+    QMutexLocker locker(&m_mutex);
+    for (AVPacket *packet : m_freePackets) {
+        av_packet_free(&packet);
+    }
+    m_freePackets.clear();
+}
+
+void PacketQueue::setCapacity(int capacity)
+{
+    QMutexLocker locker(&m_mutex);
+    m_capacity = qMax(1, capacity);
+    m_notFull.wakeAll();
+    qDebug() << "Packet queue capacity set to:" << m_capacity;
+}
+
+int PacketQueue::capacity() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_capacity;
+}
+
+void PacketQueue::setDropOnOverflow(bool drop)
+{
+    QMutexLocker locker(&m_mutex);
+    m_dropOnOverflow = drop;
+    m_notFull.wakeAll();
+}
+
+bool PacketQueue::push(AVPacket *packet)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (m_aborted) {
+        av_packet_unref(packet);
+        return false;
+    }
+
+    // 空packet是排空标记，不能被丢弃
+    const bool isKeyframe = (packet->flags & AV_PKT_FLAG_KEY) || (!packet->data && !packet->size);
+
+    if (m_queue.size() >= m_capacity) {
+        if (m_dropOnOverflow) {
+            dropToKeyframe();
+        } else {
+            while (m_queue.size() >= m_capacity && !m_aborted) {
+                m_notFull.wait(&m_mutex);
+            }
+            if (m_aborted) {
+                av_packet_unref(packet);
+                return false;
+            }
+        }
+    }
+
+    // 丢包后必须从关键帧重新开始，否则解码器会输出花屏
+    if (m_waitForKeyframe) {
+        if (!isKeyframe) {
+            av_packet_unref(packet);
+            m_droppedPackets++;
+            return false;
+        }
+        m_waitForKeyframe = false;
+    }
+
+    AVPacket *shell = acquireShell();
+    if (!shell) {
+        av_packet_unref(packet);
+        m_droppedPackets++;
+        return false;
+    }
+
+    av_packet_move_ref(shell, packet);
+    m_queue.enqueue(shell);
+
+    if (m_queue.size() > m_highWaterMark) {
+        m_highWaterMark = m_queue.size();
+    }
+
+    m_notEmpty.wakeOne();
+    return true;
+}
+
+void PacketQueue::pushFlush()
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (m_aborted) {
+        return;
+    }
+
+    AVPacket *shell = acquireShell();
+    if (!shell) {
+        return;
+    }
+
+    // 空数据加丢弃标志表示刷新，与排空标记（无标志）区分
+    shell->flags = AV_PKT_FLAG_DISCARD;
+    m_queue.enqueue(shell);
+    m_waitForKeyframe = true;
+
+    m_notEmpty.wakeOne();
+}
+
+bool PacketQueue::isDrainMarker(const AVPacket *packet)
+{
+    return !packet->data && !packet->size && !(packet->flags & AV_PKT_FLAG_DISCARD);
+}
+
+bool PacketQueue::isFlushMarker(const AVPacket *packet)
+{
+    return !packet->data && !packet->size && (packet->flags & AV_PKT_FLAG_DISCARD);
+}
+
+AVPacket *PacketQueue::pop(int timeoutMs)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (m_queue.isEmpty() && !m_aborted) {
+        m_notEmpty.wait(&m_mutex, timeoutMs);
+    }
+
+    if (m_aborted || m_queue.isEmpty()) {
+        return nullptr;
+    }
+
+    AVPacket *packet = m_queue.dequeue();
+    m_notFull.wakeOne();
+    return packet;
+}
+
+void PacketQueue::recycle(AVPacket *packet)
+{
+    if (!packet) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    releaseShell(packet);
+}
+
+void PacketQueue::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    while (!m_queue.isEmpty()) {
+        releaseShell(m_queue.dequeue());
+    }
+    m_waitForKeyframe = false;
+    m_notFull.wakeAll();
+}
+
+void PacketQueue::abort()
+{
+    QMutexLocker locker(&m_mutex);
+    m_aborted = true;
+    m_notEmpty.wakeAll();
+    m_notFull.wakeAll();
+}
+
+void PacketQueue::reset()
+{
+    clear();
+
+    QMutexLocker locker(&m_mutex);
+    m_aborted = false;
+}
+
+int PacketQueue::size() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_queue.size();
+}
+
+void PacketQueue::resetStatistics()
+{
+    m_highWaterMark = 0;
+    m_droppedPackets = 0;
+}
+
+AVPacket *PacketQueue::acquireShell()
+{
+    if (!m_freePackets.isEmpty()) {
+        return m_freePackets.takeLast();
+    }
+    return av_packet_alloc();
+}
+
+void PacketQueue::releaseShell(AVPacket *packet)
+{
+    av_packet_unref(packet);
+    m_freePackets.append(packet);
+}
+
+void PacketQueue::dropToKeyframe()
+{
+    // 优先保留队列中最后一个关键帧及其之后的数据
+    int lastKeyframe = -1;
+    for (int i = m_queue.size() - 1; i > 0; --i) {
+        if (m_queue.at(i)->flags & AV_PKT_FLAG_KEY) {
+            lastKeyframe = i;
+            break;
+        }
+    }
+
+    int dropCount = lastKeyframe > 0 ? lastKeyframe : m_queue.size();
+    QVector<AVPacket *> markers;
+    for (int i = 0; i < dropCount; ++i) {
+        AVPacket *packet = m_queue.dequeue();
+        // 排空/刷新标记必须送达解码线程
+        if (!packet->data && !packet->size) {
+            markers.append(packet);
+            continue;
+        }
+        releaseShell(packet);
+        m_droppedPackets++;
+    }
+    for (int i = markers.size() - 1; i >= 0; --i) {
+        m_queue.prepend(markers.at(i));
+    }
+
+    // 队列中没有可用的关键帧，等待下一个关键帧
+    if (lastKeyframe <= 0) {
+        m_waitForKeyframe = true;
+    }
+
+    qDebug() << "Packet queue overflow, dropped" << dropCount << "packets";
+}
@@ -0,0 +1,82 @@
+#ifndef PACKETQUEUE_H
+#define PACKETQUEUE_H
+
+#include <QMutex>
+#include <QQueue>
+#include <QVector>
+#include <QWaitCondition>
+#include <atomic>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+/**
+ * @brief 有界数据包队列
+ * 连接解复用线程（单生产者）和解码线程（单消费者）。
+ * 队列满时可以阻塞生产者（本地文件），也可以丢弃到下一个关键帧（实时流），
+ * 避免慢速解码拖住网络读取。AVPacket 外壳在内部循环复用。
+ */
+class PacketQueue
+{
+public:
+    explicit PacketQueue(int capacity = 64);
+    ~PacketQueue();
+
+    // 队列深度
+    void setCapacity(int capacity);
+    int capacity() const;
+
+    // 队列满时是否丢包（true：丢弃到关键帧；false：阻塞生产者）
+    void setDropOnOverflow(bool drop);
+
+    // 生产者：将 packet 的引用移入队列，packet 本身被清空。被丢弃时返回 false
+    // 空 packet（data 和 size 均为空）作为排空标记入队
+    bool push(AVPacket *packet);
+
+    // 生产者：插入刷新标记（流不连续，如重连后），之后丢弃非关键帧直到下一个关键帧
+    // 刷新标记和排空标记一样不受容量限制，也不会被溢出丢弃
+    void pushFlush();
+
+    // 标记类型判断
+    static bool isDrainMarker(const AVPacket *packet);
+    static bool isFlushMarker(const AVPacket *packet);
+
+    // 消费者：取出一个 packet，超时返回 nullptr。用完后必须调用 recycle()
+    AVPacket *pop(int timeoutMs);
+    void recycle(AVPacket *packet);
+
+    // 清空队列中所有 packet
+    void clear();
+
+    // 中止：唤醒所有等待者，之后 push/pop 立即返回
+    void abort();
+    void reset();
+
+    // 统计信息
+    int size() const;
+    int highWaterMark() const { return m_highWaterMark; }
+    quint64 droppedPackets() const { return m_droppedPackets; }
+    void resetStatistics();
+
+private:
+    mutable QMutex m_mutex;
+    QWaitCondition m_notEmpty;
+    QWaitCondition m_notFull;
+    QQueue<AVPacket *> m_queue;
+    QVector<AVPacket *> m_freePackets;
+
+    int m_capacity;
+    bool m_dropOnOverflow;
+    bool m_aborted;
+    bool m_waitForKeyframe;
+
+    std::atomic<int> m_highWaterMark;
+    std::atomic<quint64> m_droppedPackets;
+
+    AVPacket *acquireShell();
+    void releaseShell(AVPacket *packet);
+    void dropToKeyframe();
+};
+
+#endif // PACKETQUEUE_H
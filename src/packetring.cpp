@@ -0,0 +1,207 @@
+#include "packetring.h"
+#include <QDebug>
+#include <cstring>
+
+namespace {
+// 缓冲容量在所需大小上预留1/8并按该粒度向上取整，packet大小小幅波动时复用不必重新分配
+const int kBufferGranularity = 256;
+const int kBufferHeadroomShift = 3;
+
+// 默认限制：30秒，256MB
+const int64_t kDefaultDurationUs = 30 * 1000000LL;
+const qint64 kDefaultByteBudget = 256LL * 1024 * 1024;
+}
+
+PacketRing::PacketRing()
+    : m_bytes(0)
+    , m_memoryBytes(0)
+    , m_durationLimitUs(kDefaultDurationUs)
+    , m_byteBudget(kDefaultByteBudget)
+    , m_statBytes(0)
+    , m_statDurationUs(0)
+    , m_statMemoryBytes(0)
+{
+}
+
+PacketRing::~PacketRing()
+{
+    clear();
+    for (AVPacket *packet : m_freePackets) {
+        av_packet_free(&packet);
+    }
+    m_freePackets.clear();
+}
+
+void PacketRing::setLimits(int64_t durationUs, qint64 byteBudget)
+{
+    m_durationLimitUs = qMax<int64_t>(0, durationUs);
+    m_byteBudget = qMax<qint64>(0, byteBudget);
+}
+
+void PacketRing::push(const AVPacket *packet, AVRational timeBase)
+{
+    const bool keyframe = packet->flags & AV_PKT_FLAG_KEY;
+    if (m_gops.empty() && !keyframe) {
+        return;
+    }
+
+    // 时长按DTS计算，缺失时沿用上一个packet的时间
+    const int64_t timestamp = packet->dts != AV_NOPTS_VALUE ? packet->dts : packet->pts;
+    int64_t timeUs = m_entries.empty() ? 0 : m_entries.back().timeUs;
+    if (timestamp != AV_NOPTS_VALUE) {
+        timeUs = av_rescale_q(timestamp, timeBase, AV_TIME_BASE_Q);
+    }
+
+    AVPacket *copy = acquirePacket(packet->size);
+    if (!copy) {
+        return;
+    }
+    if (packet->size > 0) {
+        memcpy(copy->data, packet->data, static_cast<size_t>(packet->size));
+    }
+    av_packet_copy_props(copy, packet);
+
+    if (keyframe) {
+        m_gops.push_back({ 0, 0, timeUs });
+    }
+    m_entries.push_back({ copy, timeUs });
+    m_gops.back().packets++;
+    m_gops.back().bytes += packet->size;
+    m_bytes += packet->size;
+
+    trim();
+    updateStatistics();
+}
+
+QVector<const AVPacket *> PacketRing::packets(bool lastGopOnly) const
+{
+    QVector<const AVPacket *> result;
+    if (m_gops.empty()) {
+        return result;
+    }
+
+    const size_t count = lastGopOnly ? static_cast<size_t>(m_gops.back().packets) : m_entries.size();
+    result.reserve(static_cast<int>(count));
+    for (size_t i = m_entries.size() - count; i < m_entries.size(); ++i) {
+        result.append(m_entries[i].packet);
+    }
+    return result;
+}
+
+void PacketRing::clear()
+{
+    for (const Entry &entry : m_entries) {
+        releasePacket(entry.packet);
+    }
+    m_entries.clear();
+    m_gops.clear();
+    m_bytes = 0;
+    updateStatistics();
+}
+
+AVPacket *PacketRing::acquirePacket(int size)
+{
+    AVPacket *packet = nullptr;
+    if (!m_freePackets.isEmpty()) {
+        packet = m_freePackets.takeLast();
+    } else {
+        packet = av_packet_alloc();
+        if (!packet) {
+            return nullptr;
+        }
+    }
+
+    // 复用缓冲：容量足够且没有被录像引用时直接覆盖
+    const int required = size + AV_INPUT_BUFFER_PADDING_SIZE;
+    if (!packet->buf || packet->buf->size < static_cast<size_t>(required) || !av_buffer_is_writable(packet->buf)) {
+        if (packet->buf) {
+            m_memoryBytes -= static_cast<qint64>(packet->buf->size);
+            av_buffer_unref(&packet->buf);
+        }
+        const int padded = required + (required >> kBufferHeadroomShift);
+        const int capacity = (padded + kBufferGranularity - 1) / kBufferGranularity * kBufferGranularity;
+        packet->buf = av_buffer_alloc(static_cast<size_t>(capacity));
+        if (!packet->buf) {
+            av_packet_free(&packet);
+            return nullptr;
+        }
+        m_memoryBytes += capacity;
+    }
+
+    packet->data = packet->buf->data;
+    packet->size = size;
+    memset(packet->data + size, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+    return packet;
+}
+
+void PacketRing::releasePacket(AVPacket *packet)
+{
+    // 附加数据每次由 av_packet_copy_props 重新复制
+    av_packet_free_side_data(packet);
+
+    // 录像仍持有引用的缓冲交给录像释放，这里以后重新分配
+    if (packet->buf && !av_buffer_is_writable(packet->buf)) {
+        m_memoryBytes -= static_cast<qint64>(packet->buf->size);
+        av_buffer_unref(&packet->buf);
+    }
+
+    // 不限数量：淘汰的GOP整体进入待复用列表，供下一个GOP使用；总内存由 trim 按预算限制
+    m_freePackets.append(packet);
+}
+
+void PacketRing::releaseIdleBuffers(qint64 byteBudget)
+{
+    while (m_memoryBytes > byteBudget && !m_freePackets.isEmpty()) {
+        AVPacket *packet = m_freePackets.takeLast();
+        if (packet->buf) {
+            m_memoryBytes -= static_cast<qint64>(packet->buf->size);
+        }
+        av_packet_free(&packet);
+    }
+}
+
+void PacketRing::evictOldestGop()
+{
+    const Gop gop = m_gops.front();
+    m_gops.pop_front();
+    for (int i = 0; i < gop.packets; ++i) {
+        releasePacket(m_entries.front().packet);
+        m_entries.pop_front();
+    }
+    m_bytes -= gop.bytes;
+}
+
+void PacketRing::trim()
+{
+    const int64_t durationLimitUs = m_durationLimitUs;
+    const qint64 byteBudget = m_byteBudget;
+    const int64_t newestUs = m_entries.back().timeUs;
+
+    // 预算按实际占用的内存（含待复用的缓冲）计算，先释放空闲缓冲
+    releaseIdleBuffers(byteBudget);
+
+    // 淘汰最早的GOP：超出内存预算，或余下的GOP已覆盖所需时长
+    while (m_gops.size() > 1) {
+        const bool overBudget = m_memoryBytes > byteBudget;
+        const bool coveredWithout = newestUs - m_gops[1].startUs >= durationLimitUs;
+        if (!overBudget && !coveredWithout) {
+            break;
+        }
+        evictOldestGop();
+        releaseIdleBuffers(byteBudget);
+    }
+
+    // 单个GOP就超出预算：放弃缓冲，等待下一个关键帧
+    if (m_memoryBytes > byteBudget) {
+        qDebug() << "Replay buffer: GOP exceeds memory budget of" << byteBudget << "bytes, dropping";
+        clear();
+        releaseIdleBuffers(byteBudget);
+    }
+}
+
+void PacketRing::updateStatistics()
+{
+    m_statBytes = m_bytes;
+    m_statDurationUs = m_entries.empty() ? 0 : m_entries.back().timeUs - m_entries.front().timeUs;
+    m_statMemoryBytes = m_memoryBytes;
+}
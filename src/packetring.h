@@ -0,0 +1,77 @@
+#ifndef PACKETRING_H
+#define PACKETRING_H
+
+#include <QVector>
+#include <QtGlobal>
+#include <atomic>
+#include <deque>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+/**
+ * @brief 回放缓冲（最近N秒的压缩数据，用于事后保存）
+ * 仅由解复用线程访问（统计值除外）。按GOP对齐：缓冲总是从关键帧开始，淘汰时整个GOP一起丢弃，
+ * 保留覆盖所需时长的最少GOP，同时占用的内存（含待复用的缓冲）不超过预算。
+ * packet数据复制到循环复用的缓冲中，淘汰的GOP的缓冲供之后的packet使用，稳定运行时不再分配内存；录像取走的引用只增加引用计数，
+ * 对应缓冲在录像写完之前不会被复用。
+ */
+class PacketRing
+{
+public:
+    PacketRing();
+    ~PacketRing();
+
+    // 保留时长（微秒）和内存预算（字节），可在任意线程设置；时长为0时只保留当前GOP
+    void setLimits(int64_t durationUs, qint64 byteBudget);
+
+    // 追加一个packet（timeBase 为其所在流的时基），第一个关键帧之前的packet被忽略
+    void push(const AVPacket *packet, AVRational timeBase);
+
+    // 缓冲中的packet（从关键帧开始，按顺序），lastGopOnly 时只取最近一个GOP
+    // 返回的指针在下一次 push/clear 之前有效，需要保留时用 av_packet_ref
+    QVector<const AVPacket *> packets(bool lastGopOnly) const;
+
+    // 丢弃所有packet（流不连续时），缓冲保留供复用
+    void clear();
+
+    // 统计（任意线程读取）：缓冲的数据量、覆盖时长、占用内存（含待复用的缓冲）
+    qint64 bytes() const { return m_statBytes; }
+    int64_t durationUs() const { return m_statDurationUs; }
+    qint64 memoryBytes() const { return m_statMemoryBytes; }
+
+private:
+    struct Entry {
+        AVPacket *packet;
+        int64_t timeUs;
+    };
+
+    struct Gop {
+        int packets;
+        qint64 bytes;
+        int64_t startUs;
+    };
+
+    std::deque<Entry> m_entries;
+    std::deque<Gop> m_gops;
+    QVector<AVPacket *> m_freePackets;
+    qint64 m_bytes;
+    qint64 m_memoryBytes;
+
+    std::atomic<int64_t> m_durationLimitUs;
+    std::atomic<qint64> m_byteBudget;
+
+    std::atomic<qint64> m_statBytes;
+    std::atomic<int64_t> m_statDurationUs;
+    std::atomic<qint64> m_statMemoryBytes;
+
+    AVPacket *acquirePacket(int size);
+    void releasePacket(AVPacket *packet);
+    void releaseIdleBuffers(qint64 byteBudget);
+    void evictOldestGop();
+    void trim();
+    void updateStatistics();
+};
+
+#endif // PACKETRING_H
@@ -0,0 +1,214 @@
+#include "pipelinemetrics.h"
+
+MetricsHistogram::MetricsHistogram()
+{
+    reset();
+}
+
+int MetricsHistogram::bucketIndex(quint64 value)
+{
+    const quint64 maxValue = (Q_UINT64_C(1) << kMaxValueBits) - 1;
+    value = qMin(value, maxValue);
+
+    // 小于 2^kSubBucketBits 的值各占一个桶
+    if (value < (Q_UINT64_C(1) << kSubBucketBits)) {
+        return static_cast<int>(value);
+    }
+
+    // 之后每个2的幂区间按最高 kSubBucketBits 位分桶
+    int msb = 63;
+    while (!(value & (Q_UINT64_C(1) << msb))) {
+        msb--;
+    }
+    const int shift = msb - (kSubBucketBits - 1);
+    return (shift + 1) * kSubBucketHalf + static_cast<int>((value >> shift) - kSubBucketHalf);
+}
+
+quint64 MetricsHistogram::bucketLowerBound(int index)
+{
+    if (index < (1 << kSubBucketBits)) {
+        return static_cast<quint64>(index);
+    }
+    const int shift = index / kSubBucketHalf - 1;
+    const quint64 sub = static_cast<quint64>(index % kSubBucketHalf + kSubBucketHalf);
+    return sub << shift;
+}
+
+quint64 MetricsHistogram::bucketUpperBound(int index)
+{
+    if (index < (1 << kSubBucketBits)) {
+        return static_cast<quint64>(index);
+    }
+    const int shift = index / kSubBucketHalf - 1;
+    return bucketLowerBound(index) + (Q_UINT64_C(1) << shift) - 1;
+}
+
+void MetricsHistogram::record(quint64 value)
+{
+    m_buckets[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(value, std::memory_order_relaxed);
+}
+
+MetricsHistogram::Summary MetricsHistogram::take()
+{
+    // 逐桶取出并清零；写线程并发写入的样本落在本次或下次采样中，不会丢失
+    quint64 counts[kBucketCount];
+    quint64 total = 0;
+    for (int i = 0; i < kBucketCount; ++i) {
+        counts[i] = m_buckets[i].exchange(0, std::memory_order_relaxed);
+        total += counts[i];
+    }
+    const quint64 sum = m_sum.exchange(0, std::memory_order_relaxed);
+
+    Summary summary = { total, 0, 0, 0.0, 0.0, 0.0, 0.0 };
+    if (total == 0) {
+        return summary;
+    }
+    summary.mean = static_cast<double>(sum) / total;
+
+    // 分位数取所在桶的中点
+    const quint64 rank50 = (total * 50 + 99) / 100;
+    const quint64 rank95 = (total * 95 + 99) / 100;
+    const quint64 rank99 = (total * 99 + 99) / 100;
+    quint64 seen = 0;
+    bool first = true;
+    for (int i = 0; i < kBucketCount; ++i) {
+        if (!counts[i]) {
+            continue;
+        }
+        const double mid = (bucketLowerBound(i) + bucketUpperBound(i)) / 2.0;
+        if (first) {
+            summary.min = bucketLowerBound(i);
+            first = false;
+        }
+        summary.max = bucketUpperBound(i);
+
+        const quint64 before = seen;
+        seen += counts[i];
+        if (before < rank50 && seen >= rank50) {
+            summary.p50 = mid;
+        }
+        if (before < rank95 && seen >= rank95) {
+            summary.p95 = mid;
+        }
+        if (before < rank99 && seen >= rank99) {
+            summary.p99 = mid;
+        }
+    }
+    return summary;
+}
+
+void MetricsHistogram::reset()
+{
+    for (int i = 0; i < kBucketCount; ++i) {
+        m_buckets[i].store(0, std::memory_order_relaxed);
+    }
+    m_sum.store(0, std::memory_order_relaxed);
+}
+
+PipelineMetrics::PipelineMetrics()
+{
+    reset();
+}
+
+void PipelineMetrics::reset()
+{
+    for (int i = 0; i < CounterCount; ++i) {
+        m_counters[i].store(0, std::memory_order_relaxed);
+        m_lastCounters[i] = 0;
+    }
+    for (int i = 0; i < HistogramCount; ++i) {
+        m_histograms[i].reset();
+    }
+    m_sampleTimer.invalidate();
+}
+
+QVariantMap PipelineMetrics::snapshot()
+{
+    const qint64 intervalMs = m_sampleTimer.isValid() ? m_sampleTimer.restart() : 0;
+    if (!m_sampleTimer.isValid()) {
+        m_sampleTimer.start();
+    }
+
+    QVariantMap counters;
+    quint64 intervalBytes = 0;
+    for (int i = 0; i < CounterCount; ++i) {
+        const quint64 total = m_counters[i].load(std::memory_order_relaxed);
+        const quint64 delta = total - m_lastCounters[i];
+        m_lastCounters[i] = total;
+        if (i == BytesReceived) {
+            intervalBytes = delta;
+        }
+
+        QVariantMap entry;
+        entry.insert("total", total);
+        entry.insert("rate", intervalMs > 0 ? delta * 1000.0 / intervalMs : 0.0);
+        counters.insert(counterName(static_cast<Counter>(i)), entry);
+    }
+
+    QVariantMap histograms;
+    for (int i = 0; i < HistogramCount; ++i) {
+        const MetricsHistogram::Summary summary = m_histograms[i].take();
+
+        // 时间类指标以微秒记录，对外统一为毫秒
+        const bool time = i == ArrivalJitter || i == DecodeTime || i == ConvertTime || i == RenderInterval;
+        const double scale = time ? 0.001 : 1.0;
+
+        QVariantMap entry;
+        entry.insert("count", summary.count);
+        entry.insert("min", summary.min * scale);
+        entry.insert("max", summary.max * scale);
+        entry.insert("mean", summary.mean * scale);
+        entry.insert("p50", summary.p50 * scale);
+        entry.insert("p95", summary.p95 * scale);
+        entry.insert("p99", summary.p99 * scale);
+        histograms.insert(histogramName(static_cast<Histogram>(i)), entry);
+    }
+
+    QVariantMap result;
+    result.insert("intervalMs", intervalMs);
+    result.insert("bitrate", intervalMs > 0 ? static_cast<qint64>(intervalBytes * 8 * 1000 / intervalMs) : 0);
+    result.insert("counters", counters);
+    result.insert("histograms", histograms);
+    return result;
+}
+
+const char *PipelineMetrics::counterName(Counter counter)
+{
+    switch (counter) {
+    case PacketsReceived:
+        return "packetsReceived";
+    case BytesReceived:
+        return "bytesReceived";
+    case PacketsDropped:
+        return "packetsDropped";
+    case FramesDecoded:
+        return "framesDecoded";
+    case FramesDropped:
+        return "framesDropped";
+    case FramesRendered:
+        return "framesRendered";
+    default:
+        return "unknown";
+    }
+}
+
+const char *PipelineMetrics::histogramName(Histogram histogram)
+{
+    switch (histogram) {
+    case PacketSize:
+        return "packetSize";
+    case ArrivalJitter:
+        return "arrivalJitter";
+    case DecodeTime:
+        return "decodeTime";
+    case ConvertTime:
+        return "convertTime";
+    case QueueDepth:
+        return "queueDepth";
+    case RenderInterval:
+        return "renderInterval";
+    default:
+        return "unknown";
+    }
+}
@@ -0,0 +1,108 @@
+#ifndef PIPELINEMETRICS_H
+#define PIPELINEMETRICS_H
+
+#include <QElapsedTimer>
+#include <QVariantMap>
+#include <QtGlobal>
+#include <atomic>
+
+/**
+ * @brief 无锁对数线性直方图（HDR风格）
+ * 每个2的幂区间分为16个子桶，相对误差约6%，可记录到 2^40。
+ * 任意线程用 record() 写入（只有 relaxed 原子加），单一采样者用 take() 取出并清零。
+ */
+class MetricsHistogram
+{
+public:
+    struct Summary {
+        quint64 count;
+        quint64 min;
+        quint64 max;
+        double mean;
+        double p50;
+        double p95;
+        double p99;
+    };
+
+    MetricsHistogram();
+
+    void record(quint64 value);
+
+    // 取出上次采样以来的分布并清零
+    Summary take();
+    void reset();
+
+private:
+    static const int kSubBucketBits = 5;
+    static const int kSubBucketHalf = 1 << (kSubBucketBits - 1);
+    static const int kMaxValueBits = 40;
+    static const int kBucketCount = (kMaxValueBits - kSubBucketBits + 2) * kSubBucketHalf;
+
+    std::atomic<quint64> m_buckets[kBucketCount];
+    std::atomic<quint64> m_sum;
+
+    static int bucketIndex(quint64 value);
+    static quint64 bucketLowerBound(int index);
+    static quint64 bucketUpperBound(int index);
+};
+
+/**
+ * @brief 视频流水线指标
+ * 解复用、解码和渲染线程直接写入计数器和直方图，不加锁也不发送信号；
+ * GUI线程每个统计周期调用一次 snapshot()，得到本周期的分布和速率。
+ */
+class PipelineMetrics
+{
+public:
+    enum Counter {
+        PacketsReceived = 0,
+        BytesReceived,
+        PacketsDropped,      // 队列溢出丢弃
+        FramesDecoded,
+        FramesDropped,       // 渲染端来不及取走被覆盖
+        FramesRendered,
+        CounterCount
+    };
+
+    enum Histogram {
+        PacketSize = 0,      // 字节
+        ArrivalJitter,       // 到达间隔与DTS间隔之差（微秒，仅实时流）
+        DecodeTime,          // 每个packet在解码器中的耗时（微秒）
+        ConvertTime,         // 每帧颜色转换耗时（微秒）
+        QueueDepth,          // 入队后的队列深度（packet）
+        RenderInterval,      // 渲染端相邻两次取到新帧的间隔（微秒）
+        HistogramCount
+    };
+
+    PipelineMetrics();
+
+    void add(Counter counter, quint64 value = 1)
+    {
+        m_counters[counter].fetch_add(value, std::memory_order_relaxed);
+    }
+
+    void record(Histogram histogram, quint64 value) { m_histograms[histogram].record(value); }
+
+    // 清零所有指标，只能在写线程都停止时调用
+    void reset();
+
+    // 采样（只允许一个采样者）：
+    // { intervalMs, bitrate,
+    //   counters: { 名称: { total, rate } },
+    //   histograms: { 名称: { count, min, max, mean, p50, p95, p99 } } }
+    // 时间类直方图单位为毫秒，其余为原始单位
+    QVariantMap snapshot();
+
+    static const char *counterName(Counter counter);
+    static const char *histogramName(Histogram histogram);
+
+private:
+    std::atomic<quint64> m_counters[CounterCount];
+    MetricsHistogram m_histograms[HistogramCount];
+
+    // 以下仅采样者访问
+    quint64 m_lastCounters[CounterCount];
+    QElapsedTimer m_sampleTimer;
+};
+
+#endif // PIPELINEMETRICS_H
@@ -0,0 +1,151 @@
+#include "processstats.h"
+
+#if defined(Q_OS_LINUX)
+#include <QDir>
+#include <QFile>
+#include <unistd.h>
+#elif defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#include <tlhelp32.h>
+#endif
+
+namespace ProcessStats {
+
+#if defined(Q_OS_LINUX)
+
+namespace {
+QByteArray readProcFile(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    return file.readAll();
+}
+}
+
+qint64 residentBytes()
+{
+    // statm：总页数 常驻页数 ...
+    const QList<QByteArray> fields = readProcFile(QStringLiteral("/proc/self/statm")).split(' ');
+    if (fields.size() < 2) {
+        return -1;
+    }
+    return fields.at(1).toLongLong() * sysconf(_SC_PAGESIZE);
+}
+
+QVector<ThreadCpu> threadCpuTimes()
+{
+    QVector<ThreadCpu> threads;
+    const double ticksPerSecond = static_cast<double>(sysconf(_SC_CLK_TCK));
+
+    const QStringList tasks = QDir(QStringLiteral("/proc/self/task")).entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString &task : tasks) {
+        const QString base = QStringLiteral("/proc/self/task/") + task;
+        const QByteArray stat = readProcFile(base + QStringLiteral("/stat"));
+
+        // 线程名可能包含空格和括号，从最后一个 ')' 之后开始解析：state(3) ... utime(14) stime(15)
+        const int end = stat.lastIndexOf(')');
+        if (end < 0) {
+            continue;
+        }
+        const QList<QByteArray> fields = stat.mid(end + 2).split(' ');
+        if (fields.size() < 13) {
+            continue;
+        }
+
+        ThreadCpu thread;
+        thread.name = QString::fromUtf8(readProcFile(base + QStringLiteral("/comm")).trimmed());
+        thread.id = task.toULongLong();
+        thread.cpuSeconds = (fields.at(11).toULongLong() + fields.at(12).toULongLong()) / ticksPerSecond;
+        threads.append(thread);
+    }
+    return threads;
+}
+
+#elif defined(Q_OS_WIN)
+
+namespace {
+double fileTimeSeconds(const FILETIME &time)
+{
+    ULARGE_INTEGER value;
+    value.LowPart = time.dwLowDateTime;
+    value.HighPart = time.dwHighDateTime;
+    return value.QuadPart / 1e7;   // 100ns 为单位
+}
+
+// GetThreadDescription 需要 Windows 10 1607，运行时查找
+typedef HRESULT (WINAPI *GetThreadDescriptionFn)(HANDLE, PWSTR *);
+GetThreadDescriptionFn threadDescriptionFn()
+{
+    static GetThreadDescriptionFn fn = reinterpret_cast<GetThreadDescriptionFn>(
+        reinterpret_cast<void *>(GetProcAddress(GetModuleHandleW(L"kernel32.dll"), "GetThreadDescription")));
+    return fn;
+}
+}
+
+qint64 residentBytes()
+{
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return -1;
+    }
+    return static_cast<qint64>(counters.WorkingSetSize);
+}
+
+QVector<ThreadCpu> threadCpuTimes()
+{
+    QVector<ThreadCpu> threads;
+    HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
+    if (snapshot == INVALID_HANDLE_VALUE) {
+        return threads;
+    }
+
+    const DWORD processId = GetCurrentProcessId();
+    THREADENTRY32 entry;
+    entry.dwSize = sizeof(entry);
+    for (BOOL ok = Thread32First(snapshot, &entry); ok; ok = Thread32Next(snapshot, &entry)) {
+        if (entry.th32OwnerProcessID != processId) {
+            continue;
+        }
+        HANDLE handle = OpenThread(THREAD_QUERY_LIMITED_INFORMATION, FALSE, entry.th32ThreadID);
+        if (!handle) {
+            continue;
+        }
+
+        FILETIME creation, exit, kernel, user;
+        if (GetThreadTimes(handle, &creation, &exit, &kernel, &user)) {
+            ThreadCpu thread;
+            thread.id = entry.th32ThreadID;
+            thread.cpuSeconds = fileTimeSeconds(kernel) + fileTimeSeconds(user);
+
+            PWSTR description = nullptr;
+            if (threadDescriptionFn() && SUCCEEDED(threadDescriptionFn()(handle, &description)) && description) {
+                thread.name = QString::fromWCharArray(description);
+                LocalFree(description);
+            }
+            threads.append(thread);
+        }
+        CloseHandle(handle);
+    }
+
+    CloseHandle(snapshot);
+    return threads;
+}
+
+#else
+
+qint64 residentBytes()
+{
+    return -1;
+}
+
+QVector<ThreadCpu> threadCpuTimes()
+{
+    return QVector<ThreadCpu>();
+}
+
+#endif
+
+} // namespace ProcessStats
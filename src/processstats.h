@@ -0,0 +1,29 @@
+#ifndef PROCESSSTATS_H
+#define PROCESSSTATS_H
+
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+
+/**
+ * @brief 进程资源统计（常驻内存、各线程CPU时间）
+ * Linux 读取 /proc/self，Windows 使用进程/线程API；其他平台返回空结果。
+ * 线程名来自系统线程名，QThread 启动时会把 objectName 设为线程名（如 VideoDemux、VideoDecode）。
+ */
+namespace ProcessStats {
+
+struct ThreadCpu {
+    QString name;
+    quint64 id;
+    double cpuSeconds;     // 用户态 + 内核态
+};
+
+// 常驻内存（字节），不支持时返回 -1
+qint64 residentBytes();
+
+// 进程内所有线程的CPU时间
+QVector<ThreadCpu> threadCpuTimes();
+
+} // namespace ProcessStats
+
+#endif // PROCESSSTATS_H
@@ -0,0 +1,63 @@
+#include "rgbvideotexture.h"
+
+#ifdef ARDKIT_RHI_TEXTURES
+
+#include <QDebug>
+
+RgbVideoTexture::RgbVideoTexture()
+    : m_texture(nullptr)
+    , m_dirty(false)
+{
+    setFiltering(QSGTexture::Linear);
+    setHorizontalWrapMode(QSGTexture::ClampToEdge);
+    setVerticalWrapMode(QSGTexture::ClampToEdge);
+}
+
+RgbVideoTexture::~RgbVideoTexture()
+{
+    if (m_texture) {
+        m_texture->deleteLater();
+    }
+}
+
+void RgbVideoTexture::setImage(const QImage &image)
+{
+    m_image = image;
+    m_dirty = true;
+}
+
+qint64 RgbVideoTexture::comparisonKey() const
+{
+    return qint64(quintptr(this));
+}
+
+void RgbVideoTexture::commitTextureOperations(QRhi *rhi, QRhiResourceUpdateBatch *resourceUpdates)
+{
+    if (!m_dirty || m_image.isNull()) {
+        return;
+    }
+    m_dirty = false;
+
+    // Format_RGB32 在内存中为 BGRA；后端不支持 BGRA8 时按 RGBA 转换后上传
+    const bool bgra = rhi->isTextureFormatSupported(QRhiTexture::BGRA8);
+    const QRhiTexture::Format format = bgra ? QRhiTexture::BGRA8 : QRhiTexture::RGBA8;
+
+    // 尺寸不变时复用纹理，只上传数据
+    if (!m_texture || m_texture->pixelSize() != m_image.size() || m_texture->format() != format) {
+        if (m_texture) {
+            m_texture->deleteLater();
+        }
+        m_texture = rhi->newTexture(format, m_image.size());
+        if (!m_texture->create()) {
+            qWarning() << "Failed to create RGB video texture:" << m_image.size();
+            delete m_texture;
+            m_texture = nullptr;
+            return;
+        }
+    }
+
+    const QImage upload = bgra ? m_image : m_image.convertToFormat(QImage::Format_RGBA8888);
+    resourceUpdates->uploadTexture(m_texture, upload);
+}
+
+#endif // ARDKIT_RHI_TEXTURES
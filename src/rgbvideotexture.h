@@ -0,0 +1,38 @@
+#ifndef RGBVIDEOTEXTURE_H
+#define RGBVIDEOTEXTURE_H
+
+#ifdef ARDKIT_RHI_TEXTURES
+
+#include <QImage>
+#include <QSGTexture>
+#include <rhi/qrhi.h>
+
+/**
+ * @brief RGB视频帧的纹理
+ * 持有一个 QRhiTexture，每帧只上传像素数据；尺寸变化时才重新创建。
+ * 上传前一直持有图像的引用（帧池中的缓冲不会被提前复用）。
+ */
+class RgbVideoTexture : public QSGTexture
+{
+public:
+    RgbVideoTexture();
+    ~RgbVideoTexture() override;
+
+    void setImage(const QImage &image);
+
+    qint64 comparisonKey() const override;
+    QRhiTexture *rhiTexture() const override { return m_texture; }
+    QSize textureSize() const override { return m_image.size(); }
+    bool hasAlphaChannel() const override { return false; }
+    bool hasMipmaps() const override { return false; }
+    void commitTextureOperations(QRhi *rhi, QRhiResourceUpdateBatch *resourceUpdates) override;
+
+private:
+    QRhiTexture *m_texture;
+    QImage m_image;
+    bool m_dirty;
+};
+
+#endif // ARDKIT_RHI_TEXTURES
+
+#endif // RGBVIDEOTEXTURE_H
@@ -0,0 +1,237 @@
+#include "screenshotwriter.h"
+#include "frameconverter.h"
+#include "tracing.h"
+#include <QDebug>
+#include <QFileInfo>
+#include <QDir>
+#include <QImageWriter>
+#include <QSaveFile>
+#include <QThread>
+#include <QTimer>
+#include <algorithm>
+
+extern "C" {
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
+}
+
+namespace {
+// 有损格式（JPEG/WebP）的编码质量
+const int kLossyQuality = 95;
+
+// 编码线程数：单张图片的编码是单线程的，多个线程用于连拍和连续截图
+int encoderThreadCount()
+{
+    return qBound(1, QThread::idealThreadCount() / 2, 4);
+}
+
+// 连拍的第 index 帧：name.png -> name_0001.png
+QString burstFramePath(const QString &filePath, int index)
+{
+    const QFileInfo info(filePath);
+    return info.dir().filePath(QString("%1_%2.%3")
+                                   .arg(info.completeBaseName())
+                                   .arg(index, 4, 10, QChar('0'))
+                                   .arg(info.suffix()));
+}
+}
+
+ScreenshotWriter::ScreenshotWriter(QObject *parent)
+    : QObject(parent)
+    , m_pendingJobs(0)
+{
+    m_threadPool.setMaxThreadCount(encoderThreadCount());
+}
+
+ScreenshotWriter::~ScreenshotWriter()
+{
+    // 解码器可能仍持有连拍缓冲，先断开完成回调再等待已排队的任务
+    {
+        QMutexLocker locker(&m_burstMutex);
+        for (const std::weak_ptr<BurstCapture> &weak : m_bursts) {
+            if (std::shared_ptr<BurstCapture> burst = weak.lock()) {
+                burst->cancel();
+            }
+        }
+        m_bursts.clear();
+    }
+    m_threadPool.waitForDone();
+
+    for (FrameConverter *converter : m_freeConverters) {
+        delete converter;
+    }
+    m_freeConverters.clear();
+}
+
+void ScreenshotWriter::save(const VideoFrame &frame, const QString &filePath)
+{
+    if (frame.isNull()) {
+        emit errorOccurred("No frame available for screenshot");
+        return;
+    }
+
+    m_pendingJobs++;
+    m_threadPool.start([this, frame, filePath]() {
+        TRACE_SCOPE_FRAME("ScreenshotWriter::save", frame.frameId(), frame.pts());
+
+        QString error;
+        if (writeFrame(frame.avFrame(), frame.image(), filePath, &error)) {
+            qDebug() << "Screenshot saved to:" << filePath;
+            emit saved(filePath);
+        } else {
+            emit errorOccurred(QString("Failed to save screenshot: %1").arg(error));
+        }
+        m_pendingJobs--;
+    });
+}
+
+void ScreenshotWriter::saveBurst(const std::shared_ptr<BurstCapture> &burst, const VideoFrame &format,
+                                 int capacity, const QString &filePath, int timeoutMs)
+{
+    {
+        QMutexLocker locker(&m_burstMutex);
+        m_bursts.erase(std::remove_if(m_bursts.begin(), m_bursts.end(),
+                                      [](const std::weak_ptr<BurstCapture> &weak) { return weak.expired(); }),
+                       m_bursts.end());
+        m_bursts.append(burst);
+    }
+
+    // 采集结束（通常在解码线程中）后把编码交给线程池
+    std::weak_ptr<BurstCapture> weak = burst;
+    burst->setFinishedCallback([this, weak, filePath]() {
+        std::shared_ptr<BurstCapture> finished = weak.lock();
+        if (!finished) {
+            return;
+        }
+        m_pendingJobs++;
+        m_threadPool.start([this, finished, filePath]() {
+            encodeBurst(finished, filePath);
+            m_pendingJobs--;
+        });
+    });
+
+    // 预分配在线程池中进行，完成后开始采集
+    m_pendingJobs++;
+    m_threadPool.start([this, burst, format, capacity]() {
+        TRACE_SCOPE("BurstCapture::allocate");
+        if (!burst->allocate(format.avFrame(), capacity)) {
+            emit errorOccurred("Burst capture failed: out of memory");
+        }
+        m_pendingJobs--;
+    });
+
+    QTimer::singleShot(timeoutMs, this, [weak]() {
+        if (std::shared_ptr<BurstCapture> burst = weak.lock()) {
+            burst->finish();
+        }
+    });
+}
+
+void ScreenshotWriter::encodeBurst(const std::shared_ptr<BurstCapture> &burst, const QString &filePath)
+{
+    const int count = burst->frameCount();
+    qDebug() << "Burst capture finished:" << count << "frames, encoding to" << filePath;
+    if (count == 0) {
+        emit errorOccurred("Burst capture: no frames captured");
+        emit burstSaved(filePath, 0);
+        return;
+    }
+
+    // 每帧一个任务并行编码，最后一个完成时通知；缓冲在所有任务结束后释放
+    auto remaining = std::make_shared<std::atomic<int>>(count);
+    auto failed = std::make_shared<std::atomic<int>>(0);
+    for (int i = 0; i < count; ++i) {
+        m_pendingJobs++;
+        m_threadPool.start([this, burst, filePath, i, count, remaining, failed]() {
+            QString error;
+            if (!writeFrame(burst->frame(i), QImage(), burstFramePath(filePath, i + 1), &error)
+                && (*failed)++ == 0) {
+                emit errorOccurred(QString("Failed to save burst frame: %1").arg(error));
+            }
+            if (--(*remaining) == 0) {
+                qDebug() << "Burst saved:" << count - *failed << "frames";
+                emit burstSaved(filePath, count - *failed);
+            }
+            m_pendingJobs--;
+        });
+    }
+}
+
+bool ScreenshotWriter::writeFrame(const AVFrame *frame, const QImage &image, const QString &filePath, QString *error)
+{
+    const QString suffix = QFileInfo(filePath).suffix().toLower();
+    if (suffix == "yuv") {
+        if (!frame) {
+            *error = "raw capture requires a decoded frame";
+            return false;
+        }
+        return writeRawFrame(frame, filePath, error);
+    }
+
+    // 原始帧按完整分辨率转换（显示的帧可能已按窗口缩小）
+    QImage output = image;
+    if (frame) {
+        output = QImage(frame->width, frame->height, QImage::Format_RGB32);
+        FrameConverter *converter = acquireConverter();
+        const bool converted = !output.isNull() && converter->convert(frame, output);
+        releaseConverter(converter);
+        if (!converted) {
+            *error = "color conversion failed";
+            return false;
+        }
+    }
+
+    QImageWriter writer(filePath);
+    if (suffix == "jpg" || suffix == "jpeg" || suffix == "webp") {
+        writer.setQuality(kLossyQuality);
+    }
+    if (!writer.write(output)) {
+        *error = writer.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool ScreenshotWriter::writeRawFrame(const AVFrame *frame, const QString &filePath, QString *error)
+{
+    // 按解码输出的像素格式紧密排列各平面（无行对齐填充）
+    const AVPixelFormat format = static_cast<AVPixelFormat>(frame->format);
+    const int size = av_image_get_buffer_size(format, frame->width, frame->height, 1);
+    if (size <= 0) {
+        *error = "unsupported pixel format";
+        return false;
+    }
+
+    QByteArray data(size, Qt::Uninitialized);
+    if (av_image_copy_to_buffer(reinterpret_cast<uint8_t *>(data.data()), size, frame->data, frame->linesize,
+                                format, frame->width, frame->height, 1) < 0) {
+        *error = "cannot copy frame planes";
+        return false;
+    }
+
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+        *error = file.errorString();
+        return false;
+    }
+
+    qDebug() << "Raw frame:" << filePath << av_get_pix_fmt_name(format) << frame->width << "x" << frame->height;
+    return true;
+}
+
+FrameConverter *ScreenshotWriter::acquireConverter()
+{
+    {
+        QMutexLocker locker(&m_converterMutex);
+        if (!m_freeConverters.isEmpty()) {
+            return m_freeConverters.takeLast();
+        }
+    }
+    return new FrameConverter();
+}
+
+void ScreenshotWriter::releaseConverter(FrameConverter *converter)
+{
+    QMutexLocker locker(&m_converterMutex);
+    m_freeConverters.append(converter);
+}
@@ -0,0 +1,65 @@
+#ifndef SCREENSHOTWRITER_H
+#define SCREENSHOTWRITER_H
+
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+#include <QVector>
+#include <atomic>
+#include <memory>
+#include "burstcapture.h"
+#include "videoframe.h"
+
+class FrameConverter;
+
+/**
+ * @brief 截图编码（在工作线程池中完成颜色转换和图片编码）
+ * 调用方只交出帧的引用（原始YUV帧或帧池中的RGB图像），立即返回；格式由扩展名决定：
+ * .png/.jpg/.webp 按原始分辨率转换后编码，.yuv 直接写出解码输出的原始平面（不转换、无损）。
+ * 完成或失败通过信号通知（在GUI线程中接收）。
+ */
+class ScreenshotWriter : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ScreenshotWriter(QObject *parent = nullptr);
+    ~ScreenshotWriter() override;
+
+    // 保存一帧（只增加引用计数，编码在线程池中进行）
+    void save(const VideoFrame &frame, const QString &filePath);
+
+    // 连拍：按 format 的格式分配 capacity 帧，采集结束后逐帧编码为 name_0001.ext ...
+    // 采集期间由解码器调用 burst->append；超过 timeoutMs 仍未结束（如视频中断）时强制结束
+    void saveBurst(const std::shared_ptr<BurstCapture> &burst, const VideoFrame &format, int capacity,
+                   const QString &filePath, int timeoutMs);
+
+    // 排队和正在编码的图片数量
+    int pendingJobs() const { return m_pendingJobs; }
+
+signals:
+    void saved(const QString &filePath);
+    void burstSaved(const QString &filePath, int frames);
+    void errorOccurred(const QString &error);
+
+private:
+    QThreadPool m_threadPool;
+    std::atomic<int> m_pendingJobs;
+
+    // 颜色转换器按需创建，线程池中的任务轮流使用
+    QMutex m_converterMutex;
+    QVector<FrameConverter *> m_freeConverters;
+
+    // 进行中的连拍，析构时取消其完成回调
+    QMutex m_burstMutex;
+    QVector<std::weak_ptr<BurstCapture>> m_bursts;
+
+    void encodeBurst(const std::shared_ptr<BurstCapture> &burst, const QString &filePath);
+    bool writeFrame(const AVFrame *frame, const QImage &image, const QString &filePath, QString *error);
+    bool writeRawFrame(const AVFrame *frame, const QString &filePath, QString *error);
+    FrameConverter *acquireConverter();
+    void releaseConverter(FrameConverter *converter);
+};
+
+#endif // SCREENSHOTWRITER_H
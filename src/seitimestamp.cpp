@@ -0,0 +1,194 @@
+#include "seitimestamp.h"
+#include <cstring>
+
+namespace {
+// 与 tools/mediakit/src/sei_timestamp.cpp 中的UUID保持一致
+const uint8_t kTimestampUuid[16] = {
+    0x6a, 0x1f, 0x3c, 0x2e, 0x8b, 0x4d, 0x4e, 0x57,
+    0x9c, 0x0a, 0x1d, 0x2b, 0x3e, 0x4f, 0x5a, 0x60
+};
+
+const int kPayloadTypeUserDataUnregistered = 5;
+const int kTimestampPayloadSize = 16 + 8;
+
+// 去除防竞争字节后SEI负载的最大长度，时间戳SEI远小于该值
+const int kMaxSeiBytes = 256;
+
+enum NalKind {
+    NalOther,
+    NalSei,
+    NalVcl
+};
+
+NalKind nalKind(AVCodecID codecId, const uint8_t *nal)
+{
+    if (codecId == AV_CODEC_ID_H264) {
+        const int type = nal[0] & 0x1f;
+        if (type == 6) {
+            return NalSei;
+        }
+        return (type >= 1 && type <= 5) ? NalVcl : NalOther;
+    }
+
+    const int type = (nal[0] >> 1) & 0x3f;
+    if (type == 39) {
+        return NalSei;
+    }
+    return type <= 31 ? NalVcl : NalOther;
+}
+
+// 解析一个SEI NAL（不含NAL头）中的所有消息
+bool parseSei(const uint8_t *data, int size, int64_t *timestampUs)
+{
+    // 去除防竞争字节（00 00 03）
+    uint8_t rbsp[kMaxSeiBytes];
+    int length = 0;
+    int zeros = 0;
+    for (int i = 0; i < size && length < kMaxSeiBytes; ++i) {
+        if (zeros >= 2 && data[i] == 0x03) {
+            zeros = 0;
+            continue;
+        }
+        rbsp[length++] = data[i];
+        zeros = data[i] == 0 ? zeros + 1 : 0;
+    }
+
+    int pos = 0;
+    while (pos < length && rbsp[pos] != 0x80) {
+        int payloadType = 0;
+        while (pos < length && rbsp[pos] == 0xff) {
+            payloadType += 255;
+            pos++;
+        }
+        if (pos >= length) {
+            return false;
+        }
+        payloadType += rbsp[pos++];
+
+        int payloadSize = 0;
+        while (pos < length && rbsp[pos] == 0xff) {
+            payloadSize += 255;
+            pos++;
+        }
+        if (pos >= length) {
+            return false;
+        }
+        payloadSize += rbsp[pos++];
+
+        if (payloadSize > length - pos) {
+            return false;
+        }
+
+        if (payloadType == kPayloadTypeUserDataUnregistered && payloadSize >= kTimestampPayloadSize
+            && memcmp(rbsp + pos, kTimestampUuid, sizeof(kTimestampUuid)) == 0) {
+            uint64_t value = 0;
+            for (int i = 0; i < 8; ++i) {
+                value = (value << 8) | rbsp[pos + 16 + i];
+            }
+            *timestampUs = static_cast<int64_t>(value);
+            return true;
+        }
+        pos += payloadSize;
+    }
+    return false;
+}
+
+bool checkNal(AVCodecID codecId, const uint8_t *nal, int size, int64_t *timestampUs, bool *stop)
+{
+    const int headerSize = codecId == AV_CODEC_ID_H264 ? 1 : 2;
+    if (size <= headerSize) {
+        return false;
+    }
+
+    const NalKind kind = nalKind(codecId, nal);
+    if (kind == NalVcl) {
+        // SEI 总在VCL之前，之后的数据不用再看
+        *stop = true;
+        return false;
+    }
+    return kind == NalSei && parseSei(nal + headerSize, size - headerSize, timestampUs);
+}
+}
+
+namespace SeiTimestamp {
+
+int nalLengthSize(const AVCodecParameters *params)
+{
+    const uint8_t *extradata = params->extradata;
+    const int size = params->extradata_size;
+    if (!extradata || size < 7) {
+        return 0;
+    }
+
+    // 以起始码开头的extradata表示Annex B（RTSP等实时流通常如此）
+    if (extradata[0] == 0 && extradata[1] == 0
+        && (extradata[2] == 1 || (extradata[2] == 0 && extradata[3] == 1))) {
+        return 0;
+    }
+
+    // avcC/hvcC 的 configurationVersion 固定为1，其他内容无法确定长度字段
+    if (extradata[0] != 1) {
+        return 0;
+    }
+
+    if (params->codec_id == AV_CODEC_ID_H264) {
+        return (extradata[4] & 0x03) + 1;
+    }
+    if (params->codec_id == AV_CODEC_ID_HEVC && size >= 23) {
+        return (extradata[21] & 0x03) + 1;
+    }
+    return 0;
+}
+
+bool extract(const AVPacket *packet, AVCodecID codecId, int nalLengthSize, int64_t *timestampUs)
+{
+    if (codecId != AV_CODEC_ID_H264 && codecId != AV_CODEC_ID_HEVC) {
+        return false;
+    }
+
+    const uint8_t *data = packet->data;
+    const int size = packet->size;
+    if (!data || size <= 0) {
+        return false;
+    }
+
+    bool stop = false;
+    if (nalLengthSize > 0) {
+        int pos = 0;
+        while (!stop && pos + nalLengthSize < size) {
+            uint32_t length = 0;
+            for (int i = 0; i < nalLengthSize; ++i) {
+                length = (length << 8) | data[pos + i];
+            }
+            pos += nalLengthSize;
+            if (length == 0 || length > static_cast<uint32_t>(size - pos)) {
+                return false;
+            }
+            if (checkNal(codecId, data + pos, static_cast<int>(length), timestampUs, &stop)) {
+                return true;
+            }
+            pos += static_cast<int>(length);
+        }
+        return false;
+    }
+
+    // Annex B：按起始码切分，NAL结束于下一个起始码（末尾的0由SEI解析忽略）
+    int nalStart = -1;
+    for (int i = 0; i + 2 < size && !stop; ++i) {
+        if (data[i] != 0 || data[i + 1] != 0 || data[i + 2] != 1) {
+            continue;
+        }
+        if (nalStart >= 0
+            && checkNal(codecId, data + nalStart, i - nalStart, timestampUs, &stop)) {
+            return true;
+        }
+        nalStart = i + 3;
+        i += 2;
+    }
+    if (!stop && nalStart >= 0 && nalStart < size) {
+        return checkNal(codecId, data + nalStart, size - nalStart, timestampUs, &stop);
+    }
+    return false;
+}
+
+} // namespace SeiTimestamp
@@ -0,0 +1,25 @@
+#ifndef SEITIMESTAMP_H
+#define SEITIMESTAMP_H
+
+#include <cstdint>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+/**
+ * @brief 发送端时间戳SEI解析
+ * mediakit --timestamp-sei 在每帧第一个VCL NAL之前插入 user_data_unregistered SEI，
+ * 负载为固定UUID加发送时刻的墙上时钟（微秒，大端）。只扫描VCL之前的NAL，开销很小。
+ */
+namespace SeiTimestamp {
+
+// NAL长度前缀字节数（avcC/hvcC），Annex B 返回0
+int nalLengthSize(const AVCodecParameters *params);
+
+// 从packet中提取时间戳（av_gettime 时基），没有时间戳SEI时返回 false
+bool extract(const AVPacket *packet, AVCodecID codecId, int nalLengthSize, int64_t *timestampUs);
+
+} // namespace SeiTimestamp
+
+#endif // SEITIMESTAMP_H
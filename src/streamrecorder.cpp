@@ -0,0 +1,687 @@
+#include "streamrecorder.h"
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <atomic>
+#include "ffmpegerror.h"
+#include "packetqueue.h"
+#include "tracing.h"
+
+extern "C" {
+#include <libavutil/opt.h>
+}
+
+namespace {
+// 写入队列容量（packet数），约为4K 60fps下8秒的数据；超过后丢弃到关键帧
+const int kQueueCapacity = 512;
+
+// 队列内部时间基（微秒），与输入流时基无关，重连后时基变化也不影响
+const AVRational kRecordTimeBase = { 1, AV_TIME_BASE };
+
+// 未知帧率时的默认帧间隔
+const int64_t kFallbackFrameDurationUs = 40000;
+
+// 分片时长：崩溃时最多丢失这么长的数据
+const int64_t kFragmentDurationUs = 1000000;
+
+// 默认分段时长（秒）
+const int kDefaultSegmentSeconds = 300;
+
+// 封装器输出缓冲，每个分片结束时整体交给I/O线程
+const int kIoBufferSize = 256 * 1024;
+}
+
+/**
+ * @brief 一次录制：写入队列、封装器和文件写入的全部状态
+ * 由 StreamRecorder::start 在解复用线程中创建，写入线程持有一份引用，写完文件尾和同步后自行退出；
+ * 新的录制使用新的会话，不等待上一个会话收尾。
+ */
+class RecordingSession
+{
+public:
+    RecordingSession(StreamRecorder *recorder, const QString &filePath, int segmentSeconds,
+                     AsyncFileWriter::SyncPolicy syncPolicy);
+    ~RecordingSession();
+
+    // 解复用线程：复制流参数和已缓冲的packet（只增加引用计数）
+    bool init(const AVCodecParameters *params, AVRational timeBase, AVRational frameRate,
+              const QVector<const AVPacket *> &preroll);
+
+    // 解复用线程
+    void write(const AVPacket *packet);
+    void discontinuity(AVRational timeBase);
+
+    // 任意线程（调用方持有 StreamRecorder 的控制锁）：送入排空标记，返回之前是否在录制
+    bool stop();
+
+    // 写入线程
+    void writerLoop();
+
+    const QString &filePath() const { return m_filePath; }
+    bool isActive() const { return m_active; }
+    qint64 bytesWritten() const { return m_bytesWritten; }
+    qint64 durationMs() const { return m_durationUs / 1000; }
+    quint64 droppedPackets() const { return m_queue.droppedPackets(); }
+
+private:
+    StreamRecorder *m_recorder;
+    const QString m_filePath;
+    std::atomic<bool> m_active;
+    PacketQueue m_queue;
+    AsyncFileWriter::SyncPolicy m_syncPolicy;
+
+    // 以下仅解复用线程访问
+    AVPacket *m_packet;
+    AVRational m_inputTimeBase;
+    bool m_needKeyframe;
+
+    // 以下仅写入线程访问（init 时设置）
+    QVector<AVPacket *> m_preroll;
+    AVCodecParameters *m_params;
+    AVFormatContext *m_output;
+    AVStream *m_outputStream;
+    bool m_headerWritten;
+    AsyncFileWriter m_fileWriter;
+    AVIOContext *m_ioContext;
+    int64_t m_ioPosition;
+    int64_t m_ioSize;
+    int64_t m_segmentDurationUs;
+    int m_segmentIndex;
+    QString m_segmentPath;
+    int64_t m_segmentStartUs;
+    qint64 m_closedBytes;
+    int64_t m_defaultDurationUs;
+    int64_t m_timestampOffset;
+    int64_t m_lastDts;
+    int64_t m_lastDuration;
+    bool m_rebase;
+
+    // 统计（写入线程更新）
+    std::atomic<qint64> m_bytesWritten;
+    std::atomic<qint64> m_durationUs;
+
+    bool openOutput(QString *error);
+    bool writePacket(AVPacket *packet, QString *error);
+    void freePreroll();
+    void closeOutput();
+    void pushDrain();
+    QString segmentPath(int index) const;
+
+    // 封装器的输出回调：数据交给I/O线程，位置在本线程维护（写文件尾时封装器会回到前面修改）
+#if LIBAVFORMAT_VERSION_MAJOR >= 61
+    static int ioWrite(void *opaque, const uint8_t *buf, int size);
+#else
+    static int ioWrite(void *opaque, uint8_t *buf, int size);
+#endif
+    static int64_t ioSeek(void *opaque, int64_t offset, int whence);
+};
+
+StreamRecorder::StreamRecorder(QObject *parent)
+    : QObject(parent)
+    , m_segmentSeconds(kDefaultSegmentSeconds)
+    , m_syncPolicy(AsyncFileWriter::SyncEveryFragment)
+{
+}
+
+StreamRecorder::~StreamRecorder()
+{
+    stop();
+    wait();
+}
+
+void StreamRecorder::setOptions(int segmentSeconds, AsyncFileWriter::SyncPolicy syncPolicy)
+{
+    QMutexLocker locker(&m_controlMutex);
+    m_segmentSeconds = qMax(0, segmentSeconds);
+    m_syncPolicy = syncPolicy;
+}
+
+bool StreamRecorder::start(const QString &filePath, const AVCodecParameters *params,
+                           AVRational timeBase, AVRational frameRate,
+                           const QVector<const AVPacket *> &preroll)
+{
+    QMutexLocker locker(&m_controlMutex);
+
+    if (m_session && m_session->isActive()) {
+        qWarning() << "Recording already in progress:" << m_session->filePath();
+        return false;
+    }
+
+    // 上一次录制的写入线程可能还在写剩余数据，不等待，只回收已经退出的线程
+    reapWriterThreads();
+
+    auto session = std::make_shared<RecordingSession>(this, filePath, m_segmentSeconds, m_syncPolicy);
+    if (!session->init(params, timeBase, frameRate, preroll)) {
+        emit errorOccurred("Recording failed: out of memory");
+        return false;
+    }
+    m_session = session;
+
+    QThread *thread = QThread::create([session]() { session->writerLoop(); });
+    thread->setObjectName("VideoRecord");
+    thread->start();
+    m_writerThreads.append(thread);
+    return true;
+}
+
+void StreamRecorder::write(const AVPacket *packet)
+{
+    // m_session 只在解复用线程中替换，这里不需要加锁
+    if (m_session) {
+        m_session->write(packet);
+    }
+}
+
+void StreamRecorder::discontinuity(AVRational timeBase)
+{
+    if (m_session) {
+        m_session->discontinuity(timeBase);
+    }
+}
+
+void StreamRecorder::stop()
+{
+    QMutexLocker locker(&m_controlMutex);
+
+    if (m_session && m_session->stop()) {
+        qDebug() << "Recording stop requested:" << m_session->filePath();
+    }
+}
+
+void StreamRecorder::stopWithError(const QString &error)
+{
+    if (!isActive()) {
+        return;
+    }
+    qWarning() << error;
+    stop();
+    emit errorOccurred(error);
+}
+
+void StreamRecorder::wait()
+{
+    QMutexLocker locker(&m_controlMutex);
+
+    for (QThread *thread : m_writerThreads) {
+        thread->wait();
+        delete thread;
+    }
+    m_writerThreads.clear();
+}
+
+bool StreamRecorder::isActive() const
+{
+    QMutexLocker locker(&m_controlMutex);
+    return m_session && m_session->isActive();
+}
+
+qint64 StreamRecorder::bytesWritten() const
+{
+    QMutexLocker locker(&m_controlMutex);
+    return m_session ? m_session->bytesWritten() : 0;
+}
+
+qint64 StreamRecorder::durationMs() const
+{
+    QMutexLocker locker(&m_controlMutex);
+    return m_session ? m_session->durationMs() : 0;
+}
+
+quint64 StreamRecorder::droppedPackets() const
+{
+    QMutexLocker locker(&m_controlMutex);
+    return m_session ? m_session->droppedPackets() : 0;
+}
+
+void StreamRecorder::reapWriterThreads()
+{
+    for (auto it = m_writerThreads.begin(); it != m_writerThreads.end();) {
+        if ((*it)->isFinished()) {
+            delete *it;
+            it = m_writerThreads.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+RecordingSession::RecordingSession(StreamRecorder *recorder, const QString &filePath, int segmentSeconds,
+                                   AsyncFileWriter::SyncPolicy syncPolicy)
+    : m_recorder(recorder)
+    , m_filePath(filePath)
+    , m_active(false)
+    , m_queue(kQueueCapacity)
+    , m_syncPolicy(syncPolicy)
+    , m_packet(av_packet_alloc())
+    , m_inputTimeBase{1, AV_TIME_BASE}
+    , m_needKeyframe(true)
+    , m_params(avcodec_parameters_alloc())
+    , m_output(nullptr)
+    , m_outputStream(nullptr)
+    , m_headerWritten(false)
+    , m_ioContext(nullptr)
+    , m_ioPosition(0)
+    , m_ioSize(0)
+    , m_segmentDurationUs(segmentSeconds * 1000000LL)
+    , m_segmentIndex(0)
+    , m_segmentStartUs(AV_NOPTS_VALUE)
+    , m_closedBytes(0)
+    , m_defaultDurationUs(kFallbackFrameDurationUs)
+    , m_timestampOffset(0)
+    , m_lastDts(AV_NOPTS_VALUE)
+    , m_lastDuration(kFallbackFrameDurationUs)
+    , m_rebase(true)
+    , m_bytesWritten(0)
+    , m_durationUs(0)
+{
+    // 录像不能阻塞解复用线程
+    m_queue.setDropOnOverflow(true);
+}
+
+RecordingSession::~RecordingSession()
+{
+    freePreroll();
+    av_packet_free(&m_packet);
+    avcodec_parameters_free(&m_params);
+}
+
+bool RecordingSession::init(const AVCodecParameters *params, AVRational timeBase, AVRational frameRate,
+                            const QVector<const AVPacket *> &preroll)
+{
+    if (!m_packet || !m_params || avcodec_parameters_copy(m_params, params) < 0) {
+        return false;
+    }
+
+    m_inputTimeBase = timeBase;
+    m_defaultDurationUs = frameRate.num > 0 && frameRate.den > 0
+                              ? av_rescale_q(1, av_inv_q(frameRate), kRecordTimeBase)
+                              : kFallbackFrameDurationUs;
+    m_lastDuration = m_defaultDurationUs;
+
+    // 已缓冲的数据由写入线程先写入，之后再处理队列中的实时数据
+    for (const AVPacket *packet : preroll) {
+        AVPacket *ref = av_packet_alloc();
+        if (!ref || av_packet_ref(ref, packet) < 0) {
+            av_packet_free(&ref);
+            break;
+        }
+        av_packet_rescale_ts(ref, m_inputTimeBase, kRecordTimeBase);
+        m_preroll.append(ref);
+    }
+    if (!m_preroll.isEmpty()) {
+        m_needKeyframe = false;
+    }
+
+    m_active = true;
+    m_fileWriter.start(m_syncPolicy);
+
+    qDebug() << "Recording requested:" << m_filePath << "with" << m_preroll.size() << "buffered packets";
+    return true;
+}
+
+void RecordingSession::write(const AVPacket *packet)
+{
+    if (!m_active.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    // 从关键帧开始，否则文件开头无法解码
+    if (m_needKeyframe) {
+        if (!(packet->flags & AV_PKT_FLAG_KEY)) {
+            return;
+        }
+        m_needKeyframe = false;
+    }
+
+    if (av_packet_ref(m_packet, packet) < 0) {
+        return;
+    }
+    av_packet_rescale_ts(m_packet, m_inputTimeBase, kRecordTimeBase);
+    m_queue.push(m_packet);
+}
+
+void RecordingSession::discontinuity(AVRational timeBase)
+{
+    if (!m_active) {
+        return;
+    }
+
+    m_inputTimeBase = timeBase;
+    m_needKeyframe = true;
+    m_queue.pushFlush();
+}
+
+bool RecordingSession::stop()
+{
+    if (!m_active.exchange(false)) {
+        return false;
+    }
+    pushDrain();
+    return true;
+}
+
+void RecordingSession::pushDrain()
+{
+    // 空packet作为排空标记，写入线程写完之前的数据后结束
+    AVPacket *drain = av_packet_alloc();
+    if (drain) {
+        m_queue.push(drain);
+        av_packet_free(&drain);
+    } else {
+        m_queue.abort();
+    }
+}
+
+void RecordingSession::writerLoop()
+{
+    QString error;
+    if (!openOutput(&error)) {
+        m_active = false;
+        closeOutput();
+        m_fileWriter.finish();
+        freePreroll();
+        qWarning() << "Recording failed:" << error;
+        emit m_recorder->errorOccurred(QString("Recording failed: %1").arg(error));
+        return;
+    }
+
+    qDebug() << "Recording started:" << m_filePath;
+    emit m_recorder->started(m_filePath);
+
+    bool failed = false;
+    for (AVPacket *packet : m_preroll) {
+        if (!writePacket(packet, &error)) {
+            failed = true;
+            break;
+        }
+    }
+    freePreroll();
+
+    while (!failed) {
+        AVPacket *packet = m_queue.pop(100);
+        if (!packet) {
+            // 分配排空标记失败时队列被中止
+            if (!m_active && m_queue.size() == 0) {
+                break;
+            }
+            continue;
+        }
+
+        if (PacketQueue::isDrainMarker(packet)) {
+            m_queue.recycle(packet);
+            break;
+        }
+
+        // 重连：之后的时间戳接在已写入的数据之后
+        if (PacketQueue::isFlushMarker(packet)) {
+            m_queue.recycle(packet);
+            m_rebase = true;
+            continue;
+        }
+
+        const bool written = writePacket(packet, &error);
+        m_queue.recycle(packet);
+        if (!written) {
+            failed = true;
+        }
+    }
+
+    // 文件尾很小（分片格式不需要写入整个文件的索引），之后等待I/O线程写完积压的数据
+    closeOutput();
+    m_fileWriter.finish();
+    if (!failed && m_fileWriter.hasError()) {
+        error = m_fileWriter.errorString();
+        failed = true;
+    }
+
+    if (failed) {
+        m_active = false;
+        qWarning() << "Recording failed:" << error;
+        emit m_recorder->errorOccurred(QString("Recording failed: %1").arg(error));
+    }
+
+    const quint64 dropped = m_queue.droppedPackets();
+    qDebug() << "Recording finished:" << m_filePath << m_bytesWritten << "bytes,"
+             << m_durationUs / 1000 << "ms," << m_segmentIndex << "segments,"
+             << dropped << "packets dropped";
+
+    // 磁盘吞吐：写入耗时、最大积压和同步耗时，用于判断磁盘能否跟上（多路同时录像时尤其需要关注）
+    const qint64 writeTimeMs = m_fileWriter.writeTimeMs();
+    qDebug() << "Recording I/O:" << m_fileWriter.bytesWritten() << "bytes in" << writeTimeMs << "ms"
+             << "(" << (writeTimeMs > 0 ? m_fileWriter.bytesWritten() / 1048576.0 / (writeTimeMs / 1000.0) : 0.0)
+             << "MB/s ),"
+             << "max write" << m_fileWriter.maxWriteMs() << "ms, max backlog"
+             << m_fileWriter.maxBacklogBytes() << "bytes," << m_fileWriter.syncCount() << "syncs, max sync"
+             << m_fileWriter.maxSyncMs() << "ms";
+    emit m_recorder->finished(m_filePath, m_bytesWritten, m_durationUs / 1000);
+}
+
+void RecordingSession::freePreroll()
+{
+    for (AVPacket *packet : m_preroll) {
+        av_packet_free(&packet);
+    }
+    m_preroll.clear();
+}
+
+QString RecordingSession::segmentPath(int index) const
+{
+    if (m_segmentDurationUs <= 0) {
+        return m_filePath;
+    }
+
+    const QFileInfo info(m_filePath);
+    return info.dir().filePath(QString("%1_%2.%3")
+                                   .arg(info.completeBaseName())
+                                   .arg(index, 3, 10, QChar('0'))
+                                   .arg(info.suffix()));
+}
+
+bool RecordingSession::openOutput(QString *error)
+{
+    m_segmentPath = segmentPath(m_segmentIndex++);
+    m_segmentStartUs = AV_NOPTS_VALUE;
+    const QByteArray path = m_segmentPath.toUtf8();
+
+    // 容器格式由扩展名决定
+    int ret = avformat_alloc_output_context2(&m_output, nullptr, nullptr, path.constData());
+    if (ret < 0 || !m_output) {
+        *error = QString("unsupported container for %1").arg(m_segmentPath);
+        return false;
+    }
+
+    m_outputStream = avformat_new_stream(m_output, nullptr);
+    if (!m_outputStream || avcodec_parameters_copy(m_outputStream->codecpar, m_params) < 0) {
+        *error = "failed to create output stream";
+        return false;
+    }
+    // 输入的codec tag不一定适用于输出容器，由封装器重新选择
+    m_outputStream->codecpar->codec_tag = 0;
+    m_outputStream->time_base = AVRational{1, 90000};
+
+    // 文件由I/O线程写入，封装器只写内存缓冲
+    if (!(m_output->oformat->flags & AVFMT_NOFILE)) {
+        unsigned char *buffer = static_cast<unsigned char *>(av_malloc(kIoBufferSize));
+        m_ioContext = buffer ? avio_alloc_context(buffer, kIoBufferSize, 1, this, nullptr,
+                                                  &RecordingSession::ioWrite, &RecordingSession::ioSeek)
+                             : nullptr;
+        if (!m_ioContext) {
+            av_free(buffer);
+            *error = "out of memory";
+            return false;
+        }
+        m_ioPosition = 0;
+        m_ioSize = 0;
+        m_output->pb = m_ioContext;
+        m_output->flags |= AVFMT_FLAG_CUSTOM_IO;
+        m_fileWriter.open(m_segmentPath);
+    }
+
+    // 每个packet后刷新输出缓冲：分片/簇在封装器内部攒齐后才输出，完成一个就交给I/O线程一个
+    AVDictionary *options = nullptr;
+    av_dict_set(&options, "flush_packets", "1", 0);
+    if (av_opt_find(m_output->priv_data, "movflags", nullptr, 0, 0)) {
+        // 分片MP4：开头写空索引，每个关键帧或每秒一个分片
+        av_dict_set(&options, "movflags", "+frag_keyframe+empty_moov+default_base_moof", 0);
+        av_dict_set_int(&options, "frag_duration", kFragmentDurationUs, 0);
+    } else if (av_opt_find(m_output->priv_data, "cluster_time_limit", nullptr, 0, 0)) {
+        av_dict_set_int(&options, "cluster_time_limit", kFragmentDurationUs / 1000, 0);
+    }
+
+    ret = avformat_write_header(m_output, &options);
+    av_dict_free(&options);
+    if (ret < 0) {
+        *error = m_fileWriter.hasError() ? m_fileWriter.errorString()
+                                         : QString("cannot write header: %1").arg(ffmpegError(ret));
+        return false;
+    }
+    m_headerWritten = true;
+
+    if (m_segmentDurationUs > 0) {
+        qDebug() << "Recording segment started:" << m_segmentPath;
+    }
+    return true;
+}
+
+bool RecordingSession::writePacket(AVPacket *packet, QString *error)
+{
+    TRACE_SCOPE_FRAME("RecordingSession::writePacket", Tracing::kNoValue, packet->pts);
+
+    // 缺失的时间戳按帧间隔补齐
+    int64_t dts = packet->dts != AV_NOPTS_VALUE ? packet->dts : packet->pts;
+    if (dts == AV_NOPTS_VALUE) {
+        dts = m_lastDts != AV_NOPTS_VALUE ? m_lastDts - m_timestampOffset + m_lastDuration : 0;
+    }
+    int64_t pts = packet->pts != AV_NOPTS_VALUE ? packet->pts : dts;
+
+    // 第一个packet从0开始；重连后接在上一个packet之后
+    if (m_rebase) {
+        m_timestampOffset = (m_lastDts != AV_NOPTS_VALUE ? m_lastDts + m_lastDuration : 0) - dts;
+        m_rebase = false;
+    }
+    dts += m_timestampOffset;
+    pts += m_timestampOffset;
+
+    // 封装器要求DTS严格递增
+    if (m_lastDts != AV_NOPTS_VALUE) {
+        if (dts <= m_lastDts) {
+            dts = m_lastDts + 1;
+        } else {
+            m_lastDuration = qBound<int64_t>(1, dts - m_lastDts, AV_TIME_BASE);
+        }
+    }
+    if (pts < dts) {
+        pts = dts;
+    }
+    m_lastDts = dts;
+
+    if (pts > m_durationUs) {
+        m_durationUs = pts;
+    }
+
+    // 分段：达到时长后在关键帧处切换到新文件，每段时间戳从0开始
+    if (m_segmentDurationUs > 0 && (packet->flags & AV_PKT_FLAG_KEY)
+        && m_segmentStartUs != AV_NOPTS_VALUE && dts - m_segmentStartUs >= m_segmentDurationUs) {
+        closeOutput();
+        if (m_fileWriter.hasError()) {
+            *error = m_fileWriter.errorString();
+            return false;
+        }
+        if (!openOutput(error)) {
+            return false;
+        }
+    }
+    if (m_segmentStartUs == AV_NOPTS_VALUE) {
+        m_segmentStartUs = dts;
+    }
+
+    packet->dts = dts - m_segmentStartUs;
+    packet->pts = pts - m_segmentStartUs;
+    if (packet->duration <= 0) {
+        packet->duration = m_lastDuration;
+    }
+    packet->stream_index = m_outputStream->index;
+    packet->pos = -1;
+    av_packet_rescale_ts(packet, kRecordTimeBase, m_outputStream->time_base);
+
+    // 写入后packet被清空（封装器接管引用）
+    const int ret = av_interleaved_write_frame(m_output, packet);
+    if (ret < 0) {
+        *error = m_fileWriter.hasError() ? m_fileWriter.errorString()
+                                         : QString("write error: %1").arg(ffmpegError(ret));
+        return false;
+    }
+
+    m_bytesWritten = m_closedBytes + m_ioSize;
+    return true;
+}
+
+void RecordingSession::closeOutput()
+{
+    if (!m_output) {
+        return;
+    }
+
+    // 只有成功写入文件头后才能写文件尾
+    if (m_headerWritten) {
+        av_write_trailer(m_output);
+    }
+    avformat_free_context(m_output);
+    m_output = nullptr;
+    m_outputStream = nullptr;
+    m_headerWritten = false;
+
+    if (m_ioContext) {
+        avio_flush(m_ioContext);
+        av_freep(&m_ioContext->buffer);
+        avio_context_free(&m_ioContext);
+        m_fileWriter.close();
+        m_closedBytes += m_ioSize;
+        m_ioPosition = 0;
+        m_ioSize = 0;
+    }
+    m_bytesWritten = m_closedBytes;
+}
+
+#if LIBAVFORMAT_VERSION_MAJOR >= 61
+int RecordingSession::ioWrite(void *opaque, const uint8_t *buf, int size)
+#else
+int RecordingSession::ioWrite(void *opaque, uint8_t *buf, int size)
+#endif
+{
+    RecordingSession *session = static_cast<RecordingSession *>(opaque);
+    if (!session->m_fileWriter.write(session->m_ioPosition, buf, size)) {
+        return AVERROR(EIO);
+    }
+    session->m_ioPosition += size;
+    session->m_ioSize = qMax(session->m_ioSize, session->m_ioPosition);
+    return size;
+}
+
+int64_t RecordingSession::ioSeek(void *opaque, int64_t offset, int whence)
+{
+    RecordingSession *session = static_cast<RecordingSession *>(opaque);
+
+    int64_t position;
+    switch (whence & ~AVSEEK_FORCE) {
+    case AVSEEK_SIZE:
+        return session->m_ioSize;
+    case SEEK_SET:
+        position = offset;
+        break;
+    case SEEK_CUR:
+        position = session->m_ioPosition + offset;
+        break;
+    case SEEK_END:
+        position = session->m_ioSize + offset;
+        break;
+    default:
+        return AVERROR(EINVAL);
+    }
+
+    if (position < 0) {
+        return AVERROR(EINVAL);
+    }
+    session->m_ioPosition = position;
+    return position;
+}
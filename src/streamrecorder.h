@@ -0,0 +1,85 @@
+#ifndef STREAMRECORDER_H
+#define STREAMRECORDER_H
+
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QThread>
+#include <QVector>
+#include <memory>
+#include "asyncfilewriter.h"
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+}
+
+class RecordingSession;
+
+/**
+ * @brief 录像（直接封装收到的压缩数据，不重新编码）
+ * 解复用线程把视频packet的引用送入有界队列（不复制数据），封装在独立的写入线程中完成，磁盘I/O再交给
+ * AsyncFileWriter 的I/O线程，录像不占用解码和渲染时间。磁盘跟不上时队列丢弃到下一个关键帧，不会阻塞网络读取。
+ * 容器按文件扩展名选择（.mp4、.mkv 等）。MP4 写成分片格式（每个分片自带索引），MKV 按时长切分簇，
+ * 程序崩溃时最多丢失最后一个分片，结束录制也不需要写入整个文件的索引。
+ * 设置分段时长后按时长在关键帧处切换到新文件（name_000.mp4、name_001.mp4 ...），每段时间戳从0开始。
+ * 录像从关键帧开始，重连后在下一个关键帧处接续。
+ * 每次录制是一个独立的会话（RecordingSession），结束后写入线程自行写完剩余数据、文件尾和同步，
+ * 开始和结束录制都不等待上一个会话，只有析构时等待所有写入线程退出。
+ */
+class StreamRecorder : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit StreamRecorder(QObject *parent = nullptr);
+    ~StreamRecorder() override;
+
+    // 分段时长（秒，0表示不分段）和同步策略，下一次开始录制时生效
+    void setOptions(int segmentSeconds, AsyncFileWriter::SyncPolicy syncPolicy);
+
+    // 解复用线程：开始录制，params/timeBase/frameRate 为输入视频流的参数，文件在写入线程中打开
+    // preroll 为开始前已收到的packet（从关键帧开始，见 PacketRing），只增加引用计数，不受写入队列容量限制
+    bool start(const QString &filePath, const AVCodecParameters *params, AVRational timeBase, AVRational frameRate,
+               const QVector<const AVPacket *> &preroll = QVector<const AVPacket *>());
+
+    // 解复用线程：送入一个视频packet（只增加引用计数），第一个关键帧之前的packet被忽略
+    void write(const AVPacket *packet);
+
+    // 解复用线程：流不连续（重连后），从下一个关键帧接续时间戳
+    void discontinuity(AVRational timeBase);
+
+    // 任意线程：结束录制，写入线程写完剩余数据后发出 finished，不等待
+    void stop();
+
+    // 任意线程：因错误结束录制
+    void stopWithError(const QString &error);
+
+    // 等待所有写入线程退出（析构时调用，保证文件完整）
+    void wait();
+
+    // 当前（最近一次）录制的状态和统计
+    bool isActive() const;
+    qint64 bytesWritten() const;
+    qint64 durationMs() const;
+    quint64 droppedPackets() const;
+
+signals:
+    void started(const QString &filePath);
+    void finished(const QString &filePath, qint64 bytes, qint64 durationMs);
+    void errorOccurred(const QString &error);
+
+private:
+    // 控制状态（start/stop 可能在不同线程调用）；m_session 只在解复用线程中替换，替换时持有锁
+    mutable QMutex m_controlMutex;
+    int m_segmentSeconds;
+    AsyncFileWriter::SyncPolicy m_syncPolicy;
+    std::shared_ptr<RecordingSession> m_session;
+
+    // 写入线程（包括已结束录制、仍在收尾的），开始录制时回收已退出的线程
+    QVector<QThread *> m_writerThreads;
+
+    void reapWriterThreads();
+};
+
+#endif // STREAMRECORDER_H
@@ -0,0 +1,234 @@
+#include "tracing.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QThread>
+#include <QVector>
+
+namespace Tracing {
+
+namespace {
+
+// 每个线程保留的事件数（约40字节/事件），60fps时可覆盖一分钟以上
+const quint64 kEventsPerThread = 16384;
+
+struct Event {
+    // 字段用 relaxed 原子变量，导出线程可以与写入线程同时读取而不产生数据竞争
+    std::atomic<const char *> name;
+    std::atomic<qint64> startNs;
+    std::atomic<qint64> durationNs;
+    std::atomic<qint64> frameId;
+    std::atomic<qint64> pts;
+};
+
+/**
+ * 单写者环形缓冲：写入前先推进 begin，写完后推进 end。
+ * 导出时读取 end 之前的事件，读完后再检查 begin，被覆盖（或正在覆盖）的事件丢弃。
+ */
+struct ThreadBuffer {
+    int index = 0;
+    QString threadName;
+    bool inUse = false;
+    std::atomic<quint64> begin{0};
+    std::atomic<quint64> end{0};
+    Event events[kEventsPerThread];
+};
+
+std::atomic<bool> g_enabled{true};
+
+// 缓冲在线程退出后保留（事件仍可导出），新线程优先复用空闲缓冲
+QMutex g_registryMutex;
+QVector<ThreadBuffer *> g_buffers;
+
+QString currentThreadName()
+{
+    QThread *thread = QThread::currentThread();
+    if (QCoreApplication::instance() && thread == QCoreApplication::instance()->thread()) {
+        return QStringLiteral("GUI");
+    }
+    if (!thread) {
+        return QString();
+    }
+    // 与 QThread 设置的系统线程名一致：objectName，未设置时为类名（如 QSGRenderThread）
+    if (!thread->objectName().isEmpty()) {
+        return thread->objectName();
+    }
+    return QString::fromLatin1(thread->metaObject()->className());
+}
+
+ThreadBuffer *acquireBuffer()
+{
+    QMutexLocker locker(&g_registryMutex);
+
+    ThreadBuffer *buffer = nullptr;
+    for (ThreadBuffer *candidate : g_buffers) {
+        if (!candidate->inUse) {
+            buffer = candidate;
+            break;
+        }
+    }
+    if (!buffer) {
+        buffer = new ThreadBuffer;
+        buffer->index = g_buffers.size() + 1;
+        g_buffers.append(buffer);
+    }
+
+    buffer->inUse = true;
+    buffer->threadName = currentThreadName();
+    if (buffer->threadName.isEmpty()) {
+        buffer->threadName = QString("Thread %1").arg(buffer->index);
+    }
+    buffer->begin.store(0, std::memory_order_relaxed);
+    buffer->end.store(0, std::memory_order_relaxed);
+    return buffer;
+}
+
+// 线程退出时归还缓冲
+struct ThreadSlot {
+    ThreadBuffer *buffer = nullptr;
+
+    ~ThreadSlot()
+    {
+        if (buffer) {
+            QMutexLocker locker(&g_registryMutex);
+            buffer->inUse = false;
+        }
+    }
+};
+
+thread_local ThreadSlot t_slot;
+
+void appendNumber(QByteArray &out, double value)
+{
+    out += QByteArray::number(value, 'f', 3);
+}
+
+} // namespace
+
+void setEnabled(bool enabled)
+{
+    g_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool isEnabled()
+{
+    return g_enabled.load(std::memory_order_relaxed);
+}
+
+void record(const char *name, qint64 startNs, qint64 durationNs, qint64 frameId, qint64 pts)
+{
+    ThreadBuffer *buffer = t_slot.buffer;
+    if (!buffer) {
+        buffer = acquireBuffer();
+        t_slot.buffer = buffer;
+    }
+
+    const quint64 index = buffer->end.load(std::memory_order_relaxed);
+    buffer->begin.store(index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    Event &event = buffer->events[index % kEventsPerThread];
+    event.name.store(name, std::memory_order_relaxed);
+    event.startNs.store(startNs, std::memory_order_relaxed);
+    event.durationNs.store(durationNs, std::memory_order_relaxed);
+    event.frameId.store(frameId, std::memory_order_relaxed);
+    event.pts.store(pts, std::memory_order_relaxed);
+
+    buffer->end.store(index + 1, std::memory_order_release);
+}
+
+bool writeChromeTrace(const QString &filePath, QString *error)
+{
+    struct Copy {
+        const char *name;
+        qint64 startNs;
+        qint64 durationNs;
+        qint64 frameId;
+        qint64 pts;
+    };
+
+    const QByteArray pid = QByteArray::number(QCoreApplication::applicationPid());
+    QByteArray json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    int eventCount = 0;
+
+    {
+        QMutexLocker locker(&g_registryMutex);
+        QVector<Copy> copies;
+        copies.reserve(static_cast<int>(kEventsPerThread));
+
+        const QVector<ThreadBuffer *> &buffers = g_buffers;
+        for (ThreadBuffer *buffer : buffers) {
+            const quint64 end = buffer->end.load(std::memory_order_acquire);
+            const quint64 start = end > kEventsPerThread ? end - kEventsPerThread : 0;
+
+            copies.clear();
+            for (quint64 i = start; i < end; ++i) {
+                const Event &event = buffer->events[i % kEventsPerThread];
+                copies.append({ event.name.load(std::memory_order_relaxed),
+                                event.startNs.load(std::memory_order_relaxed),
+                                event.durationNs.load(std::memory_order_relaxed),
+                                event.frameId.load(std::memory_order_relaxed),
+                                event.pts.load(std::memory_order_relaxed) });
+            }
+
+            // 复制期间被写入线程覆盖的事件无效
+            std::atomic_thread_fence(std::memory_order_acquire);
+            const quint64 begin = buffer->begin.load(std::memory_order_relaxed);
+            const quint64 firstValid = begin > kEventsPerThread ? begin - kEventsPerThread : 0;
+            const int skip = static_cast<int>(qMin<quint64>(firstValid > start ? firstValid - start : 0,
+                                                            static_cast<quint64>(copies.size())));
+            if (skip == copies.size()) {
+                continue;
+            }
+
+            const QByteArray tid = QByteArray::number(buffer->index);
+            QByteArray threadName = buffer->threadName.toUtf8();
+            threadName.replace('\\', "\\\\").replace('"', "\\\"");
+            if (!first) {
+                json += ',';
+            }
+            first = false;
+            json += "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" + pid + ",\"tid\":" + tid
+                    + ",\"args\":{\"name\":\"" + threadName + "\"}}";
+
+            for (int i = skip; i < copies.size(); ++i) {
+                const Copy &event = copies.at(i);
+                json += ",\n{\"name\":\"";
+                json += event.name;
+                json += "\",\"cat\":\"video\",\"ph\":\"X\",\"ts\":";
+                appendNumber(json, event.startNs / 1000.0);
+                json += ",\"dur\":";
+                appendNumber(json, event.durationNs / 1000.0);
+                json += ",\"pid\":" + pid + ",\"tid\":" + tid + ",\"args\":{";
+                bool firstArg = true;
+                if (event.frameId != kNoValue && event.frameId >= 0) {
+                    json += "\"frame\":" + QByteArray::number(event.frameId);
+                    firstArg = false;
+                }
+                if (event.pts != kNoValue) {
+                    json += QByteArray(firstArg ? "" : ",") + "\"pts\":" + QByteArray::number(event.pts);
+                }
+                json += "}}";
+                eventCount++;
+            }
+        }
+    }
+    json += "\n]}\n";
+
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly) || file.write(json) != json.size() || !file.commit()) {
+        if (error) {
+            *error = file.errorString();
+        }
+        qWarning() << "Failed to write trace to" << filePath << ":" << file.errorString();
+        return false;
+    }
+
+    qDebug() << "Trace written to" << filePath << ":" << eventCount << "events";
+    return true;
+}
+
+} // namespace Tracing
@@ -0,0 +1,98 @@
+#ifndef TRACING_H
+#define TRACING_H
+
+#include <QString>
+#include <QtGlobal>
+#include <atomic>
+#include <chrono>
+#include <limits>
+
+/**
+ * @brief 流水线跟踪（定位卡顿发生在哪个阶段）
+ * 每个线程一个固定大小的环形缓冲，只记录最近的事件，写入时不加锁、不分配内存；
+ * 需要时导出为 Chrome trace-event JSON，可在 chrome://tracing 或 Perfetto 中打开。
+ * 每个事件带帧序号和PTS，同一帧在解复用、解码、转换、GUI线程和渲染线程的各阶段可以对应起来。
+ * 编译时关闭 ARDKIT_TRACING 后 TRACE_* 宏展开为空。
+ */
+namespace Tracing {
+
+// 未知的帧序号/PTS（与 AV_NOPTS_VALUE 相同）
+const qint64 kNoValue = std::numeric_limits<qint64>::min();
+
+// 运行时开关，默认开启；关闭后每个跟踪点只剩一次原子读取
+void setEnabled(bool enabled);
+bool isEnabled();
+
+// 单调时钟（纳秒）
+inline qint64 now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 写入当前线程的环形缓冲，name 必须是静态字符串
+void record(const char *name, qint64 startNs, qint64 durationNs, qint64 frameId, qint64 pts);
+
+// 导出所有线程缓冲中的事件，失败时返回 false 并填写 error
+bool writeChromeTrace(const QString &filePath, QString *error = nullptr);
+
+/**
+ * @brief 作用域事件：构造时计时，析构时记录
+ * 帧序号和PTS在作用域内才得知时（如读取packet后）用 setFrame 补充。
+ */
+class Scope
+{
+public:
+    explicit Scope(const char *name, qint64 frameId = kNoValue, qint64 pts = kNoValue)
+        : m_name(isEnabled() ? name : nullptr)
+        , m_frameId(frameId)
+        , m_pts(pts)
+        , m_startNs(m_name ? now() : 0)
+    {
+    }
+
+    ~Scope()
+    {
+        if (m_name) {
+            record(m_name, m_startNs, now() - m_startNs, m_frameId, m_pts);
+        }
+    }
+
+    void setFrame(qint64 frameId, qint64 pts)
+    {
+        m_frameId = frameId;
+        m_pts = pts;
+    }
+
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+private:
+    const char *m_name;
+    qint64 m_frameId;
+    qint64 m_pts;
+    qint64 m_startNs;
+};
+
+} // namespace Tracing
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#ifdef ARDKIT_TRACING
+// 记录当前作用域
+#define TRACE_SCOPE(name) Tracing::Scope TRACE_CONCAT(traceScope_, __LINE__)(name)
+// 记录当前作用域，带帧序号和PTS
+#define TRACE_SCOPE_FRAME(name, frameId, pts) \
+    Tracing::Scope TRACE_CONCAT(traceScope_, __LINE__)(name, frameId, pts)
+// 具名作用域，之后用 TRACE_SET_FRAME 补充帧序号和PTS
+#define TRACE_SCOPE_VAR(var, name) Tracing::Scope var(name)
+#define TRACE_SET_FRAME(var, frameId, pts) var.setFrame(frameId, pts)
+#else
+#define TRACE_SCOPE(name) do {} while (0)
+#define TRACE_SCOPE_FRAME(name, frameId, pts) do {} while (0)
+#define TRACE_SCOPE_VAR(var, name) do {} while (0)
+#define TRACE_SET_FRAME(var, frameId, pts) do {} while (0)
+#endif
+
+#endif // TRACING_H
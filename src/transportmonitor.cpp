@@ -0,0 +1,143 @@
+#include "transportmonitor.h"
+#include <QHash>
+#include <QMutex>
+#include <cstring>
+
+extern "C" {
+#include <libavutil/log.h>
+}
+
+namespace {
+// 以太网MTU下单个RTP包的最大负载（1500 - IP/UDP/RTP头），用于计算分片数的下限
+const int kMaxRtpPayload = 1460;
+
+// 窗口内收到的包数少于该值时不计算丢包率
+const quint64 kMinWindowPackets = 50;
+
+QMutex &registryMutex()
+{
+    static QMutex mutex;
+    return mutex;
+}
+
+QHash<const void *, TransportMonitor *> &registry()
+{
+    static QHash<const void *, TransportMonitor *> monitors;
+    return monitors;
+}
+}
+
+TransportMonitor::TransportMonitor()
+    : m_formatContext(nullptr)
+    , m_lostPackets(0)
+    , m_latePackets(0)
+    , m_jitterOverflows(0)
+    , m_lossRate(0.0)
+    , m_windowLost(0)
+    , m_windowPackets(0)
+{
+}
+
+TransportMonitor::~TransportMonitor()
+{
+    detach();
+}
+
+void TransportMonitor::attach(const void *formatContext)
+{
+    QMutexLocker locker(&registryMutex());
+
+    // 日志回调是全局的，第一次使用时安装
+    static bool installed = false;
+    if (!installed) {
+        av_log_set_callback(&TransportMonitor::logCallback);
+        installed = true;
+    }
+
+    if (m_formatContext) {
+        registry().remove(m_formatContext);
+    }
+    m_formatContext = formatContext;
+    if (m_formatContext) {
+        registry().insert(m_formatContext, this);
+    }
+}
+
+void TransportMonitor::detach()
+{
+    QMutexLocker locker(&registryMutex());
+    if (m_formatContext) {
+        registry().remove(m_formatContext);
+        m_formatContext = nullptr;
+    }
+}
+
+void TransportMonitor::reset()
+{
+    m_lostPackets = 0;
+    m_latePackets = 0;
+    m_jitterOverflows = 0;
+    m_lossRate = 0.0;
+    m_windowLost = 0;
+    m_windowPackets = 0;
+}
+
+void TransportMonitor::addReceivedPacket(int bytes)
+{
+    // rtpdec 每个RTP包最多输出一个AVPacket（分片在解包器中合并），所以每个AVPacket至少对应一个RTP包；
+    // 大于一个RTP负载的AVPacket至少由 ceil(size / 最大负载) 个分片组成。
+    // 得到的是收到包数的下限，丢包率只会偏高不会偏低，但不再受平均包大小影响（小包码流不会误判）
+    const quint64 fragments = bytes > kMaxRtpPayload
+                                  ? static_cast<quint64>((bytes + kMaxRtpPayload - 1) / kMaxRtpPayload)
+                                  : 1;
+    m_windowPackets += fragments;
+}
+
+double TransportMonitor::takeWindowLossRate()
+{
+    const quint64 received = m_windowPackets;
+    const quint64 lost = m_windowLost.exchange(0);
+    m_windowPackets = 0;
+
+    if (received + lost < kMinWindowPackets) {
+        return -1.0;
+    }
+
+    const double rate = static_cast<double>(lost) / (received + lost);
+    m_lossRate = rate;
+    return rate;
+}
+
+void TransportMonitor::handleMessage(const char *fmt, va_list args)
+{
+    // 与 libavformat/rtpdec.c、rtsp.c 中的消息格式一致
+    if (strcmp(fmt, "RTP: missed %d packets\n") == 0) {
+        const int missed = va_arg(args, int);
+        if (missed > 0) {
+            m_lostPackets += missed;
+            m_windowLost += missed;
+        }
+    } else if (strcmp(fmt, "RTP: dropping old packet received too late\n") == 0) {
+        m_latePackets++;
+    } else if (strcmp(fmt, "jitter buffer full\n") == 0
+               || strcmp(fmt, "max delay reached. need to consume packet\n") == 0) {
+        m_jitterOverflows++;
+    }
+}
+
+void TransportMonitor::logCallback(void *avcl, int level, const char *fmt, va_list vl)
+{
+    // 只关心告警及以上级别，其余日志不加锁直接输出
+    if (avcl && fmt && level <= AV_LOG_WARNING) {
+        QMutexLocker locker(&registryMutex());
+        TransportMonitor *monitor = registry().value(avcl, nullptr);
+        if (monitor) {
+            va_list args;
+            va_copy(args, vl);
+            monitor->handleMessage(fmt, args);
+            va_end(args);
+        }
+    }
+
+    av_log_default_callback(avcl, level, fmt, vl);
+}
@@ -0,0 +1,53 @@
+#ifndef TRANSPORTMONITOR_H
+#define TRANSPORTMONITOR_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <cstdarg>
+
+/**
+ * @brief RTP传输质量统计
+ * FFmpeg没有公开RTP接收统计，这里通过日志回调识别 rtpdec/rtsp 对序号缺口和迟到包的告警，
+ * 按 AVFormatContext 把消息路由到对应的监视器，其余日志照常输出。
+ * 只有启用了重排队列（reorder_queue_size > 1）的UDP传输才会产生这些告警。
+ */
+class TransportMonitor
+{
+public:
+    TransportMonitor();
+    ~TransportMonitor();
+
+    // 接收该 AVFormatContext 的日志（替换之前的注册）
+    void attach(const void *formatContext);
+    void detach();
+
+    void reset();
+
+    // 解复用线程：每读到一个packet调用一次，按大小计入对应RTP包数的下限
+    void addReceivedPacket(int bytes);
+
+    // 解复用线程定期调用：结束当前统计窗口，返回窗口内的丢包率；样本不足时返回 -1
+    double takeWindowLossRate();
+
+    quint64 lostPackets() const { return m_lostPackets; }
+    quint64 latePackets() const { return m_latePackets; }            // 超出重排队列的乱序包（被丢弃）
+    quint64 jitterOverflows() const { return m_jitterOverflows; }    // 重排队列满或等待超时，带缺口输出
+    double lossRate() const { return m_lossRate; }                   // 最近一个完整窗口的丢包率
+
+private:
+    const void *m_formatContext;
+
+    std::atomic<quint64> m_lostPackets;
+    std::atomic<quint64> m_latePackets;
+    std::atomic<quint64> m_jitterOverflows;
+    std::atomic<double> m_lossRate;
+
+    // 当前窗口（丢包数由日志回调线程累加）
+    std::atomic<quint64> m_windowLost;
+    quint64 m_windowPackets;
+
+    void handleMessage(const char *fmt, va_list args);
+    static void logCallback(void *avcl, int level, const char *fmt, va_list vl);
+};
+
+#endif // TRANSPORTMONITOR_H
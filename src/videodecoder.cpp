@@ -1,5 +1,98 @@
 #include "videodecoder.h"
+#include "seitimestamp.h"
+#include "tracing.h"
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QRandomGenerator>
+#include <cstring>
+
+extern "C" {
+#include <libavutil/time.h>
+}
+
+namespace {
+// 呈现时钟参数（微秒）
+const int64_t kMaxEarlyUs = 1000000;      // 帧提前超过1秒视为PTS跳变，重新对齐
+const int64_t kMaxLateUs = 500000;        // 帧落后超过500ms视为时钟失步，重新对齐
+const int64_t kJitterBudgetUs = 100000;   // 实时流允许的最大缓冲（抖动预算）
+const int64_t kSleepSliceUs = 10000;      // 等待时每次最多休眠10ms，保证停止响应及时
+
+// FFmpeg阻塞操作的超时（微秒），由中断回调检查
+const int64_t kOpenTimeoutUs = 10000000;  // 连接
+const int64_t kProbeTimeoutUs = 10000000; // 探测流信息
+const int64_t kReadTimeoutUs = 5000000;   // 单次读取，超过视为连接丢失
+
+// 实时流连续读取失败超过该次数后重连
+const int kMaxReadRetries = 3;
+const int kReadRetryDelayMs = 50;
+
+// 重连退避（毫秒）：每次失败后延迟加倍，并加入±25%抖动
+const int kReconnectInitialDelayMs = 100;
+const int kReconnectMaxDelayMs = 5000;
+const int kMaxReconnectAttempts = 8;
+
+// UDP传输：打开后超过该时间仍未收到数据则改用TCP（微秒）
+const int64_t kUdpFirstPacketTimeoutUs = 2000000;
+
+// UDP丢包率统计窗口（微秒）
+const int64_t kLossWindowUs = 1000000;
+
+// 停止耗时超过该值时输出警告（毫秒）
+const qint64 kSlowStopMs = 50;
+
+// 等待解复用线程退出时重复唤醒的间隔（毫秒），信号可能恰好在FFmpeg进入poll之前到达
+const unsigned long kStopWakeIntervalMs = 10;
+
+// 解码统计输出间隔（微秒）
+const int64_t kDecodeStatsIntervalUs = 5000000;
+
+// 回放缓冲默认保留时长和字节预算
+const int kDefaultReplaySeconds = 30;
+const int kDefaultReplayBudgetMB = 256;
+
+double streamFrameRate(const AVStream *stream)
+{
+    AVRational fps = stream->avg_frame_rate;
+    if (fps.num && fps.den) {
+        return static_cast<double>(fps.num) / fps.den;
+    }
+    return 30.0;  // 默认30fps
+}
+
+// 流参数缓存格式版本，格式变化时旧缓存自动失效
+const int kStreamInfoVersion = 1;
+
+// 使用缓存参数时，超过该数量的packet仍未解出帧则视为缓存不可用
+const int kStreamInfoVerifyPackets = 120;
+
+QVariantMap streamInfoFromStream(const AVStream *stream)
+{
+    const AVCodecParameters *params = stream->codecpar;
+    QVariantMap info;
+    info.insert("version", kStreamInfoVersion);
+    info.insert("codecId", static_cast<int>(params->codec_id));
+    info.insert("width", params->width);
+    info.insert("height", params->height);
+    info.insert("pixelFormat", params->format);
+    info.insert("extradata", QByteArray(reinterpret_cast<const char *>(params->extradata), params->extradata_size));
+    info.insert("timeBaseNum", stream->time_base.num);
+    info.insert("timeBaseDen", stream->time_base.den);
+    info.insert("frameRateNum", stream->avg_frame_rate.num);
+    info.insert("frameRateDen", stream->avg_frame_rate.den);
+    return info;
+}
+
+// 重连后的流能否沿用现有解码器
+bool codecParametersChanged(const AVCodecParameters *a, const AVCodecParameters *b)
+{
+    return a->codec_id != b->codec_id
+           || a->width != b->width || a->height != b->height
+           || a->format != b->format
+           || a->extradata_size != b->extradata_size
+           || (a->extradata_size > 0 && memcmp(a->extradata, b->extradata, a->extradata_size) != 0);
+}
+}
 
 VideoDecoder::VideoDecoder(QObject *parent)
     : QThread(parent)
@@ -7,19 +100,65 @@ VideoDecoder::VideoDecoder(QObject *parent)
     , m_codecContext(nullptr)
     , m_codec(nullptr)
     , m_frame(nullptr)
-    , m_frameRGB(nullptr)
     , m_packet(nullptr)
-    , m_swsContext(nullptr)
     , m_videoStreamIndex(-1)
     , m_videoWidth(0)
     , m_videoHeight(0)
     , m_frameRate(0.0)
-    , m_buffer(nullptr)
-    , m_bufferSize(0)
+    , m_timeBase{0, 1}
+    , m_isLiveSource(true)
+    , m_ingestProfile(IngestProfile::byName(IngestProfile::defaultName()))
+    , m_activeTransport(TransportNone)
+    , m_tcpFallback(false)
+    , m_receivedSinceOpen(false)
+    , m_lossWindowStartUs(0)
+    , m_lastFrame(nullptr)
     , m_running(false)
     , m_streamOpened(false)
+    , m_streamState(StreamIdle)
+    , m_ioDeadlineUs(0)
+    , m_ioTimedOut(false)
+    , m_streamCodecParams(nullptr)
+    , m_pendingCodecParams(nullptr)
+    , m_pendingTimeBase{0, 1}
+    , m_pendingFrameRate(0.0)
+    , m_reconnectCount(0)
+    , m_lastReconnectTimeMs(-1)
+    , m_reconnectStartUs(0)
+    , m_awaitingFirstFrame(false)
+    , m_verifyStreamInfo(false)
+    , m_streamInfoRejected(false)
+    , m_verifyPackets(0)
+    , m_lastArrivalUs(0)
+    , m_lastArrivalDts(AV_NOPTS_VALUE)
+    , m_seenDroppedPackets(0)
+    , m_seenDroppedFrames(0)
+    , m_packetDecodeTimeUs(0)
+    , m_frameSerial(0)
+    , m_hasTimestampSei(false)
     , m_paused(false)
+    , m_demuxFinished(false)
+    , m_presentationMode(LivePresentation)
+    , m_decoderThreadCount(0)
+    , m_decoderThreadType(AutoThreading)
+    , m_clockValid(false)
+    , m_clockBaseUs(0)
+    , m_clockBasePts(0.0)
+    , m_recordReplay(false)
+    , m_recordRequested(false)
+    , m_replaySeconds(kDefaultReplaySeconds)
+    , m_replayBudgetMB(kDefaultReplayBudgetMB)
+    , m_decodeThread(nullptr)
+    , m_sentPtsHead(0)
+    , m_sentPtsCount(0)
+    , m_decoderDelayFrames(0)
+    , m_statsDecodeTimeUs(0)
+    , m_statsConvertTimeUs(0)
+    , m_statsDecodedFrames(0)
+    , m_yuvOutput(false)
+    , m_lastFrameYuv(false)
 {
+    m_replayRing.setLimits(kDefaultReplaySeconds * 1000000LL, kDefaultReplayBudgetMB * 1024LL * 1024);
     qDebug() << "VideoDecoder created";
 }
 
@@ -32,76 +171,186 @@ VideoDecoder::~VideoDecoder()
 
 bool VideoDecoder::openStream(const QString &url)
 {
-    if (m_streamOpened) {
+    if (m_streamOpened || QThread::isRunning()) {
         qWarning() << "Stream already opened";
         return false;
     }
 
     qDebug() << "Opening stream:" << url;
 
-    if (!initFFmpeg(url)) {
-        emit errorOccurred("Failed to initialize FFmpeg");
-        return false;
-    }
-
-    m_streamOpened = true;
-    emit streamOpened(m_videoWidth, m_videoHeight, m_frameRate);
-
-    qDebug() << "Stream opened successfully:"
-             << m_videoWidth << "x" << m_videoHeight
-             << "@" << m_frameRate << "fps";
+    // 连接和探测可能阻塞数秒，交给解复用线程完成，GUI线程立即返回
+    m_url = url;
+    resetPresentationClock();
+    m_packetQueue.reset();
+    m_packetQueue.resetStatistics();
+    m_demuxFinished = false;
+    m_reconnectCount = 0;
+    m_lastReconnectTimeMs = -1;
+    m_streamInfoRejected = false;
+    m_tcpFallback = false;
+    m_transportMonitor.reset();
+    m_latencyTracker.reset();
+    m_hasTimestampSei = false;
+    m_metrics.reset();
+    m_lastArrivalUs = 0;
+    m_lastArrivalDts = AV_NOPTS_VALUE;
+    m_seenDroppedPackets = 0;
+    m_seenDroppedFrames = 0;
+    m_running = true;
+    setStreamState(StreamConnecting);
 
+    setObjectName("VideoDemux");
+    start();
     return true;
 }
 
 void VideoDecoder::closeStream()
 {
+    // 正在打开时同样有效：中断回调让阻塞中的FFmpeg调用立即返回
+    stopDecoding();
+
     if (!m_streamOpened) {
+        setStreamState(StreamIdle);
         return;
     }
 
     qDebug() << "Closing stream";
 
-    stopDecoding();
     cleanupFFmpeg();
 
     m_streamOpened = false;
+    setStreamState(StreamIdle);
     emit streamClosed();
 }
 
-void VideoDecoder::startDecoding()
+void VideoDecoder::setStreamState(StreamState state)
 {
-    if (!m_streamOpened) {
-        qWarning() << "Cannot start decoding: stream not opened";
-        return;
+    if (m_streamState.exchange(state) != state) {
+        emit streamStateChanged(state);
     }
+}
 
-    if (m_running) {
-        qWarning() << "Decoding already running";
-        return;
+int VideoDecoder::interruptCallback(void *opaque)
+{
+    // 返回非0时FFmpeg中止当前的阻塞操作（连接、探测、读取）
+    // FFmpeg在等待网络数据时约每100ms调用一次，停止请求因此能及时生效
+    VideoDecoder *decoder = static_cast<VideoDecoder *>(opaque);
+    if (!decoder->m_running) {
+        return 1;
     }
 
-    qDebug() << "Starting decoding thread";
-    m_running = true;
-    start();
+    const int64_t deadline = decoder->m_ioDeadlineUs;
+    if (deadline > 0 && av_gettime_relative() > deadline) {
+        decoder->m_ioTimedOut = true;
+        return 1;
+    }
+    return 0;
+}
+
+void VideoDecoder::setIoDeadline(int64_t timeoutUs)
+{
+    m_ioTimedOut = false;
+    m_ioDeadlineUs = timeoutUs > 0 ? av_gettime_relative() + timeoutUs : 0;
+}
+
+void VideoDecoder::sleepWhileRunning(int ms)
+{
+    // 分段休眠，停止请求最多延迟一个分段
+    QElapsedTimer timer;
+    timer.start();
+    while (m_running && timer.elapsed() < ms) {
+        QThread::usleep(static_cast<unsigned long>(kSleepSliceUs));
+    }
+}
+
+void VideoDecoder::startDecodeThread()
+{
+    qDebug() << "Starting decode thread";
+    // 实时流队列满时丢弃到关键帧；本地文件则阻塞读取，保证不丢帧
+    m_packetQueue.setDropOnOverflow(m_isLiveSource);
+
+    m_decodeThread = QThread::create([this]() { decodeLoop(); });
+    m_decodeThread->setObjectName("VideoDecode");
+    m_decodeThread->start();
 }
 
 void VideoDecoder::stopDecoding()
 {
-    if (!m_running) {
+    if (!m_running && !QThread::isRunning()) {
         return;
     }
 
-    qDebug() << "Stopping decoding thread";
+    qDebug() << "Stopping demux and decode threads";
+    QElapsedTimer stopTimer;
+    stopTimer.start();
+
     m_running = false;
     m_paused = false;
+    m_packetQueue.abort();
+
+    // 中断回调让阻塞中的FFmpeg调用返回，线程总能正常退出，不再强制终止；
+    // 唤醒信号让网络等待立即检查中断回调，不必等到下一个100ms轮询周期
+    m_ioWaker.wake();
+    while (QThread::currentThread() != this && !wait(kStopWakeIntervalMs)) {
+        m_ioWaker.wake();
+    }
+
+    // 录像的写入线程在后台写完剩余数据、文件尾和同步，这里不等待（析构时才等待，保证文件完整）
+    m_recordRequested = false;
+    m_recorder.stop();
+    m_replayRing.clear();
 
-    // 等待线程结束
-    if (!wait(3000)) {
-        qWarning() << "Decoding thread did not stop in time, terminating";
-        terminate();
-        wait();
+    if (m_decodeThread) {
+        m_decodeThread->wait();
+        delete m_decodeThread;
+        m_decodeThread = nullptr;
     }
+
+    m_packetQueue.clear();
+
+    const qint64 stopMs = stopTimer.elapsed();
+    if (stopMs > kSlowStopMs) {
+        qWarning() << "Demux and decode threads stopped slowly:" << stopMs << "ms";
+    } else {
+        qDebug() << "Demux and decode threads stopped in" << stopMs << "ms";
+    }
+}
+
+void VideoDecoder::setIngestProfile(const QString &name)
+{
+    if (!IngestProfile::names().contains(name)) {
+        qWarning() << "Unknown ingest profile:" << name;
+    }
+
+    m_ingestProfile = IngestProfile::byName(name);
+    qDebug() << "Ingest profile set to:" << m_ingestProfile.name;
+}
+
+void VideoDecoder::setDecoderThreadCount(int count)
+{
+    if (count < 0) {
+        qWarning() << "Invalid decoder thread count:" << count;
+        return;
+    }
+
+    m_decoderThreadCount = count;
+    qDebug() << "Decoder thread count set to:" << (count == 0 ? QString("auto") : QString::number(count));
+}
+
+void VideoDecoder::setDecoderThreadType(int type)
+{
+    if (type < AutoThreading || type > SliceThreading) {
+        qWarning() << "Invalid decoder thread type:" << type;
+        return;
+    }
+
+    m_decoderThreadType = type;
+    qDebug() << "Decoder thread type set to:" << type;
+}
+
+void VideoDecoder::setPacketQueueCapacity(int capacity)
+{
+    m_packetQueue.setCapacity(capacity);
 }
 
 void VideoDecoder::pauseDecoding()
@@ -123,236 +372,737 @@ void VideoDecoder::resumeDecoding()
     }
 
     qDebug() << "Resuming decoding";
+    resetPresentationClock();
     m_paused = false;
 }
 
-QImage VideoDecoder::getLatestFrame()
+void VideoDecoder::setPresentationMode(int mode)
+{
+    if (mode != LivePresentation && mode != SmoothPresentation) {
+        qWarning() << "Invalid presentation mode:" << mode;
+        return;
+    }
+
+    if (m_presentationMode.exchange(mode) != mode) {
+        qDebug() << "Presentation mode set to:"
+                 << (mode == LivePresentation ? "live" : "smooth");
+    }
+}
+
+void VideoDecoder::setOutputSize(const QSize &size)
+{
+    QMutexLocker locker(&m_outputSizeMutex);
+    if (m_requestedOutputSize != size) {
+        m_requestedOutputSize = size;
+        qDebug() << "Decoder output size requested:" << size;
+    }
+}
+
+void VideoDecoder::setYuvOutputEnabled(bool enabled)
+{
+    if (m_yuvOutput != enabled) {
+        m_yuvOutput = enabled;
+        qDebug() << "Decoder YUV output:" << (enabled ? "enabled" : "disabled");
+    }
+}
+
+VideoFrame VideoDecoder::captureFrame()
+{
+    // 只在锁内增加引用，转换和编码由截图线程完成，不阻塞解码线程
+    QMutexLocker locker(&m_lastFrameMutex);
+    if (m_lastFrame && m_lastFrame->data[0]) {
+        return VideoFrame::fromAVFrame(m_lastFrame);
+    }
+    return VideoFrame();
+}
+
+void VideoDecoder::setBurstCapture(const std::shared_ptr<BurstCapture> &burst)
 {
-    QMutexLocker locker(&m_frameMutex);
-    return m_latestFrame;
+    QMutexLocker locker(&m_lastFrameMutex);
+    if (m_burst) {
+        m_burst->finish();
+    }
+    m_burst = burst;
 }
 
 void VideoDecoder::run()
 {
-    qDebug() << "Decoding thread started";
+    qDebug() << "Demux thread started";
+    IoWaker::ThreadScope wakeScope(&m_ioWaker);
+
+    if (!initFFmpeg(m_url)) {
+        cleanupFFmpeg();
+        m_demuxFinished = true;
+        if (!m_running) {
+            qDebug() << "Stream open cancelled";
+            return;
+        }
+        m_running = false;
+        setStreamState(StreamFailed);
+        emit errorOccurred("Failed to open video stream");
+        return;
+    }
+
+    m_streamOpened = true;
+    qDebug() << "Stream opened successfully:"
+             << m_videoWidth << "x" << m_videoHeight
+             << "@" << m_frameRate << "fps";
+    emit streamOpened(m_videoWidth, m_videoHeight, m_frameRate);
+
+    startDecodeThread();
+    setStreamState(StreamStreaming);
 
+    demuxLoop();
+
+    m_demuxFinished = true;
+    qDebug() << "Demux thread stopped";
+}
+
+void VideoDecoder::demuxLoop()
+{
     int errorCount = 0;
     const int maxConsecutiveErrors = 10;
+    bool reachedEof = false;
 
     while (m_running) {
         // 如果暂停，等待并继续循环
         if (m_paused) {
-            msleep(100);
+            sleepWhileRunning(100);
             continue;
         }
 
-        // 读取packet
-        int ret = av_read_frame(m_formatContext, m_packet);
-
-        if (ret < 0) {
-            if (ret == AVERROR_EOF) {
-                // 对于实时流，EOF 可能是暂时的，等待后重试
-                qDebug() << "Temporary end of stream, retrying...";
-                msleep(100);  // 等待 100ms
-                errorCount++;
-                if (errorCount > maxConsecutiveErrors) {
-                    qWarning() << "Too many consecutive EOF errors, stopping";
+        // 缓存的流参数被解码线程否决：丢弃缓存，重新连接并完整探测
+        if (m_streamInfoRejected.exchange(false)) {
+            m_cachedStreamInfo.clear();
+            if (!reconnect()) {
+                if (m_running) {
                     emit errorOccurred("Stream ended or connection lost");
-                    break;
                 }
-                continue;
-            } else {
-                char errbuf[AV_ERROR_MAX_STRING_SIZE];
-                av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
-                qWarning() << "Error reading frame:" << errbuf;
-                emit errorOccurred(QString("Read frame error: %1").arg(errbuf));
+                break;
+            }
+            continue;
+        }
+
+        // 读取packet（实时流设置读取超时，数据中断时不会无限阻塞）
+        // UDP在收到第一个包之前使用更短的超时，不通时尽快改用TCP
+        int64_t readTimeoutUs = m_isLiveSource ? kReadTimeoutUs : 0;
+        if (m_activeTransport == TransportUdp && !m_receivedSinceOpen) {
+            readTimeoutUs = kUdpFirstPacketTimeoutUs;
+        }
+        setIoDeadline(readTimeoutUs);
+        int ret;
+        {
+            TRACE_SCOPE_VAR(readTrace, "av_read_frame");
+            ret = av_read_frame(m_formatContext, m_packet);
+            TRACE_SET_FRAME(readTrace, Tracing::kNoValue, ret >= 0 ? m_packet->pts : AV_NOPTS_VALUE);
+        }
+
+        if (ret < 0) {
+            // 停止请求中断的读取，不是错误
+            if (!m_running) {
+                break;
+            }
+
+            // 本地文件读到结尾，排空解码器后结束
+            if (ret == AVERROR_EOF && !m_isLiveSource) {
+                qDebug() << "End of file reached";
+                reachedEof = true;
+                break;
+            }
 
-                // 对于网络错误，尝试重试
-                msleep(100);
-                errorCount++;
-                if (errorCount > maxConsecutiveErrors) {
-                    qWarning() << "Too many consecutive errors, stopping";
-                    break;
+            char errbuf[AV_ERROR_MAX_STRING_SIZE];
+            av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
+            errorCount++;
+
+            if (m_isLiveSource) {
+                // 实时流：读取超时或连续出错视为连接中断，在解码器内部重连
+                if (m_ioTimedOut || errorCount > kMaxReadRetries) {
+                    if (m_ioTimedOut) {
+                        qWarning() << "No data received for" << readTimeoutUs / 1000 << "ms";
+                    } else {
+                        qWarning() << "Too many consecutive read errors:" << errbuf;
+                    }
+                    if (!m_receivedSinceOpen && canFallBackToTcp()) {
+                        qWarning() << "No data over UDP, switching to TCP";
+                        m_tcpFallback = true;
+                    }
+                    if (!reconnect()) {
+                        if (m_running) {
+                            emit errorOccurred("Stream ended or connection lost");
+                        }
+                        break;
+                    }
+                    errorCount = 0;
+                    continue;
                 }
+
+                // EOF 或网络错误可能是暂时的，稍后重试
+                qDebug() << "Read error, retrying:" << errbuf;
+                sleepWhileRunning(kReadRetryDelayMs);
                 continue;
             }
+
+            qWarning() << "Error reading frame:" << errbuf;
+            if (errorCount > maxConsecutiveErrors) {
+                qWarning() << "Too many consecutive errors, stopping";
+                emit errorOccurred(QString("Read frame error: %1").arg(errbuf));
+                break;
+            }
+            sleepWhileRunning(100);
+            continue;
         }
 
         // 成功读取，重置错误计数
         errorCount = 0;
+        m_receivedSinceOpen = true;
+        m_transportMonitor.addReceivedPacket(m_packet->size);
 
         // 只处理视频流的packet
         if (m_packet->stream_index == m_videoStreamIndex) {
-            // 发送packet大小用于码率计算
-            emit packetReceived(m_packet->size);
-
-            if (decodePacket()) {
-                // 转换为RGB并发送信号
-                convertFrameToRGB();
-                emit frameReady();
+            recordPacketMetrics(m_packet);
+            trackTimestampSei(m_packet);
+            recordPacket(m_packet);
+
+            // 交给解码线程，队列满时由队列决定阻塞或丢弃
+            m_packetQueue.push(m_packet);
+
+            m_metrics.record(PipelineMetrics::QueueDepth, static_cast<quint64>(m_packetQueue.size()));
+            const quint64 dropped = m_packetQueue.droppedPackets();
+            if (dropped != m_seenDroppedPackets) {
+                m_metrics.add(PipelineMetrics::PacketsDropped, dropped - m_seenDroppedPackets);
+                m_seenDroppedPackets = dropped;
             }
         }
 
         av_packet_unref(m_packet);
 
-        // 控制帧率，避免解码太快
-        msleep(1000 / (m_frameRate > 0 ? m_frameRate : 30));
+        // auto 传输：按窗口统计UDP丢包率，超过阈值后重连并改用TCP
+        if (m_activeTransport == TransportUdp && transportNeedsFallback()) {
+            if (!reconnect()) {
+                if (m_running) {
+                    emit errorOccurred("Stream ended or connection lost");
+                }
+                break;
+            }
+        }
     }
 
-    qDebug() << "Decoding thread stopped";
+    // 本地文件结束：发送空packet让解码器排空缓存帧
+    if (!m_isLiveSource && reachedEof) {
+        m_packetQueue.push(m_packet);
+    }
 }
 
-bool VideoDecoder::initFFmpeg(const QString &url)
+bool VideoDecoder::reconnect()
 {
-    qDebug() << "=== VideoDecoder::initFFmpeg ===";
-    qDebug() << "URL:" << url;
+    const int64_t startUs = av_gettime_relative();
+    int backoffMs = kReconnectInitialDelayMs;
+
+    for (int attempt = 1; attempt <= kMaxReconnectAttempts && m_running; ++attempt) {
+        // 加入抖动，避免多个客户端在设备恢复时同时重连
+        const double jitter = 0.75 + 0.5 * QRandomGenerator::global()->generateDouble();
+        const int delayMs = static_cast<int>(backoffMs * jitter);
+        qWarning() << "Connection lost, reconnect attempt" << attempt << "of" << kMaxReconnectAttempts
+                   << "in" << delayMs << "ms";
+
+        setStreamState(StreamConnecting);
+        sleepWhileRunning(delayMs);
+        if (!m_running) {
+            return false;
+        }
 
-    // 分配format context
-    m_formatContext = avformat_alloc_context();
-    if (!m_formatContext) {
-        qCritical() << "Failed to allocate format context";
-        return false;
+        avformat_close_input(&m_formatContext);
+        if (openInput(m_url)) {
+            resumeAfterReconnect(startUs);
+            return true;
+        }
+
+        backoffMs = qMin(backoffMs * 2, kReconnectMaxDelayMs);
     }
 
-    qDebug() << "Format context allocated successfully";
+    qWarning() << "Reconnect failed after" << (av_gettime_relative() - startUs) / 1000 << "ms";
+    return false;
+}
 
-    // 打开输入流
-    AVDictionary *options = nullptr;
-    av_dict_set(&options, "rtsp_transport", "tcp", 0);  // RTSP使用TCP传输
-    av_dict_set(&options, "max_delay", "500000", 0);    // 最大延迟500ms
-    av_dict_set(&options, "timeout", "5000000", 0);     // 超时5秒
+void VideoDecoder::resumeAfterReconnect(int64_t startUs)
+{
+    AVStream *stream = m_formatContext->streams[m_videoStreamIndex];
+    const bool changed = codecParametersChanged(m_streamCodecParams, stream->codecpar);
+
+    // 解码器由解码线程在收到刷新标记时更新，这里只登记新参数
+    {
+        QMutexLocker locker(&m_reconfigureMutex);
+        if (changed) {
+            if (!m_pendingCodecParams) {
+                m_pendingCodecParams = avcodec_parameters_alloc();
+            }
+            if (m_pendingCodecParams) {
+                avcodec_parameters_copy(m_pendingCodecParams, stream->codecpar);
+            }
+            avcodec_parameters_copy(m_streamCodecParams, stream->codecpar);
+        }
+        m_pendingTimeBase = stream->time_base;
+        m_pendingFrameRate = streamFrameRate(stream);
+    }
 
-    qDebug() << "Opening input with options: rtsp_transport=tcp, max_delay=500000, timeout=5000000";
+    // 回放缓冲只保存连续的数据，断线前的内容丢弃；编码参数变化后录像无法写入同一个文件
+    m_replayRing.clear();
+    if (changed) {
+        m_recorder.stopWithError("Recording stopped: stream format changed after reconnect");
+    } else {
+        m_recorder.discontinuity(stream->time_base);
+    }
 
-    int ret = avformat_open_input(&m_formatContext, url.toUtf8().constData(), nullptr, &options);
-    av_dict_free(&options);
+    // 队列在刷新标记之后丢弃非关键帧，解码从下一个关键帧恢复
+    m_reconnectStartUs = startUs;
+    m_reconnectCount++;
+    m_lastArrivalDts = AV_NOPTS_VALUE;
+    m_packetQueue.pushFlush();
+    setStreamState(StreamStreaming);
 
-    if (ret < 0) {
-        char errbuf[AV_ERROR_MAX_STRING_SIZE];
-        av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
-        qCritical() << "Failed to open input:" << errbuf << "(error code:" << ret << ")";
-        qCritical() << "URL was:" << url;
-        avformat_free_context(m_formatContext);
-        m_formatContext = nullptr;
-        return false;
+    qDebug() << "Reconnected in" << (av_gettime_relative() - startUs) / 1000 << "ms,"
+             << (changed ? "codec parameters changed, decoder will be reopened" : "reusing decoder");
+}
+
+bool VideoDecoder::handleDiscontinuity()
+{
+    AVCodecParameters *params = nullptr;
+    AVRational timeBase;
+    double frameRate;
+    {
+        QMutexLocker locker(&m_reconfigureMutex);
+        params = m_pendingCodecParams;
+        m_pendingCodecParams = nullptr;
+        timeBase = m_pendingTimeBase;
+        frameRate = m_pendingFrameRate;
     }
 
-    qDebug() << "Input opened successfully";
+    if (params) {
+        // 分辨率、编码格式或extradata变化，重建解码器
+        avcodec_free_context(&m_codecContext);
+        const bool opened = openCodec(params);
+        avcodec_parameters_free(&params);
+        if (!opened) {
+            emit errorOccurred("Failed to open video stream");
+            return false;
+        }
 
-    // 获取流信息
-    qDebug() << "Finding stream info...";
-    ret = avformat_find_stream_info(m_formatContext, nullptr);
-    if (ret < 0) {
-        char errbuf[AV_ERROR_MAX_STRING_SIZE];
-        av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
-        qCritical() << "Failed to find stream info:" << errbuf;
-        cleanupFFmpeg();
-        return false;
+        m_videoWidth = m_codecContext->width;
+        m_videoHeight = m_codecContext->height;
+        m_frameRate = frameRate;
+        emit streamOpened(m_videoWidth, m_videoHeight, m_frameRate);
+    } else {
+        // 参数不变：沿用解码器，只丢弃断线前残留的参考帧
+        avcodec_flush_buffers(m_codecContext);
     }
 
-    qDebug() << "Found" << m_formatContext->nb_streams << "streams";
+    m_timeBase = timeBase;
+    resetPresentationClock();
+    m_sentPtsHead = 0;
+    m_sentPtsCount = 0;
+    m_decoderDelayFrames = 0;
+    m_awaitingFirstFrame = true;
+    m_verifyPackets = 0;
+    return true;
+}
 
-    // 查找视频流
-    m_videoStreamIndex = -1;
-    for (unsigned int i = 0; i < m_formatContext->nb_streams; i++) {
-        AVMediaType type = m_formatContext->streams[i]->codecpar->codec_type;
-        qDebug() << "Stream" << i << "type:" << av_get_media_type_string(type);
-        if (type == AVMEDIA_TYPE_VIDEO) {
-            m_videoStreamIndex = i;
-            break;
+void VideoDecoder::decodeLoop()
+{
+    qDebug() << "Decode thread started";
+
+    resetDecodeStatistics();
+    m_verifyPackets = 0;
+    int64_t statsStart = av_gettime_relative();
+
+    while (m_running) {
+        if (m_paused) {
+            sleepWhileRunning(100);
+            continue;
+        }
+
+        AVPacket *packet = m_packetQueue.pop(100);
+        if (!packet) {
+            // 解复用线程已退出且队列已取空
+            if (m_demuxFinished && m_packetQueue.size() == 0) {
+                break;
+            }
+            continue;
+        }
+
+        // 重连后的刷新标记：更新或清空解码器
+        if (PacketQueue::isFlushMarker(packet)) {
+            m_packetQueue.recycle(packet);
+            if (!handleDiscontinuity()) {
+                break;
+            }
+            continue;
+        }
+
+        if (m_hasTimestampSei && packet->pts != AV_NOPTS_VALUE) {
+            m_latencyTracker.packetDequeued(packet->pts, av_gettime());
+        }
+
+        decodePacket(packet);
+        m_packetQueue.recycle(packet);
+
+        int64_t elapsed = av_gettime_relative() - statsStart;
+        if (elapsed >= kDecodeStatsIntervalUs && m_statsDecodedFrames > 0) {
+            qDebug() << "Decode stats:"
+                     << m_statsDecodedFrames * 1000000.0 / elapsed << "fps,"
+                     << m_statsDecodeTimeUs / 1000.0 / m_statsDecodedFrames << "ms/frame decode,"
+                     << "capacity" << m_statsDecodedFrames * 1000000.0 / qMax<int64_t>(m_statsDecodeTimeUs, 1) << "fps,"
+                     << "threads" << m_codecContext->thread_count
+                     << (m_codecContext->active_thread_type == FF_THREAD_FRAME ? "(frame)" :
+                         m_codecContext->active_thread_type == FF_THREAD_SLICE ? "(slice)" : "(none)")
+                     << "codec delay" << m_decoderDelayFrames << "frames,"
+                     << m_statsConvertTimeUs / 1000.0 / m_statsDecodedFrames << "ms/frame convert"
+                     << "(" << (m_lastFrameYuv ? QString("shader") : m_frameConverter.backendName()) << ")";
+            if (m_hasTimestampSei) {
+                qDebug() << "End-to-end latency p50/p95/p99:"
+                         << m_latencyTracker.totalPercentile(0.50) << "/"
+                         << m_latencyTracker.totalPercentile(0.95) << "/"
+                         << m_latencyTracker.totalPercentile(0.99) << "ms";
+            }
+            statsStart = av_gettime_relative();
+            m_statsDecodeTimeUs = 0;
+            m_statsConvertTimeUs = 0;
+            m_statsDecodedFrames = 0;
         }
     }
 
-    if (m_videoStreamIndex == -1) {
-        qCritical() << "No video stream found in" << m_formatContext->nb_streams << "streams";
-        cleanupFFmpeg();
-        return false;
+    // 本地文件播放完毕（所有缓存帧已排空并显示）
+    if (m_running && m_demuxFinished && !m_isLiveSource) {
+        emit errorOccurred("Stream ended");
     }
 
-    qDebug() << "Video stream found at index:" << m_videoStreamIndex;
+    // 停止时丢弃解码器内部缓存的帧，下次启动从干净状态开始
+    if (m_codecContext) {
+        avcodec_flush_buffers(m_codecContext);
+    }
+    resetDecodeStatistics();
 
-    // 获取codec parameters
-    AVCodecParameters *codecParams = m_formatContext->streams[m_videoStreamIndex]->codecpar;
+    qDebug() << "Decode thread stopped";
+}
 
-    // 查找decoder
-    m_codec = avcodec_find_decoder(codecParams->codec_id);
-    if (!m_codec) {
-        qCritical() << "Codec not found";
-        cleanupFFmpeg();
-        return false;
+QString VideoDecoder::activeTransport() const
+{
+    switch (m_activeTransport) {
+    case TransportTcp:
+        return QStringLiteral("tcp");
+    case TransportUdp:
+        return QStringLiteral("udp");
+    default:
+        return QString();
     }
+}
 
-    // 分配codec context
-    m_codecContext = avcodec_alloc_context3(m_codec);
-    if (!m_codecContext) {
-        qCritical() << "Failed to allocate codec context";
-        cleanupFFmpeg();
-        return false;
-    }
+bool VideoDecoder::canFallBackToTcp() const
+{
+    return m_running && m_activeTransport == TransportUdp
+           && m_ingestProfile.transport == QLatin1String("auto");
+}
 
-    // 复制codec parameters到context
-    ret = avcodec_parameters_to_context(m_codecContext, codecParams);
-    if (ret < 0) {
-        qCritical() << "Failed to copy codec parameters";
-        cleanupFFmpeg();
+bool VideoDecoder::transportNeedsFallback()
+{
+    const int64_t now = av_gettime_relative();
+    if (now - m_lossWindowStartUs < kLossWindowUs) {
         return false;
     }
+    m_lossWindowStartUs = now;
 
-    // 打开codec
-    ret = avcodec_open2(m_codecContext, m_codec, nullptr);
-    if (ret < 0) {
-        qCritical() << "Failed to open codec";
-        cleanupFFmpeg();
+    const double lossRate = m_transportMonitor.takeWindowLossRate();
+    if (lossRate < 0 || lossRate <= m_ingestProfile.udpLossThreshold || !canFallBackToTcp()) {
         return false;
     }
 
-    // 获取视频信息
-    m_videoWidth = m_codecContext->width;
-    m_videoHeight = m_codecContext->height;
+    qWarning() << "UDP loss rate" << lossRate * 100.0 << "% exceeds"
+               << m_ingestProfile.udpLossThreshold * 100.0 << "%, switching to TCP";
+    m_tcpFallback = true;
+    return true;
+}
 
-    AVRational fps = m_formatContext->streams[m_videoStreamIndex]->avg_frame_rate;
-    if (fps.num && fps.den) {
-        m_frameRate = static_cast<double>(fps.num) / fps.den;
+bool VideoDecoder::openInput(const QString &url)
+{
+    if (tryOpenInput(url)) {
+        return true;
+    }
+
+    // UDP不通（被防火墙拦截或设备不支持）时直接改用TCP重试
+    if (canFallBackToTcp()) {
+        qWarning() << "RTSP over UDP failed, retrying with TCP";
+        m_tcpFallback = true;
+        return tryOpenInput(url);
+    }
+    return false;
+}
+
+bool VideoDecoder::tryOpenInput(const QString &url)
+{
+    // 分配format context
+    m_formatContext = avformat_alloc_context();
+    if (!m_formatContext) {
+        qCritical() << "Failed to allocate format context";
+        return false;
+    }
+
+    // 中断回调：停止时立即中止阻塞中的连接、探测和读取
+    m_formatContext->interrupt_callback.callback = &VideoDecoder::interruptCallback;
+    m_formatContext->interrupt_callback.opaque = this;
+
+    // 路由该 context 的RTP告警，用于统计丢包和乱序
+    m_transportMonitor.attach(m_formatContext);
+
+    qDebug() << "Format context allocated successfully";
+
+    // 按接入配置设置解复用参数
+    const IngestProfile &profile = m_ingestProfile;
+    if (profile.noBuffer) {
+        m_formatContext->flags |= AVFMT_FLAG_NOBUFFER;
+    }
+    if (profile.flushPackets) {
+        m_formatContext->flags |= AVFMT_FLAG_FLUSH_PACKETS;
+    }
+    m_formatContext->probesize = profile.probeSize;
+    m_formatContext->max_analyze_duration = profile.analyzeDurationUs;
+
+    // auto 传输先尝试UDP，本次会话回退过则一直使用TCP
+    QString transport = profile.transport;
+    if (transport == QLatin1String("auto")) {
+        transport = m_tcpFallback ? QStringLiteral("tcp") : QStringLiteral("udp");
+    }
+    if (url.startsWith(QLatin1String("rtsp"), Qt::CaseInsensitive)) {
+        m_activeTransport = transport == QLatin1String("udp") ? TransportUdp : TransportTcp;
     } else {
-        m_frameRate = 30.0;  // 默认30fps
+        m_activeTransport = TransportNone;
     }
 
-    // 分配frame
-    m_frame = av_frame_alloc();
-    m_frameRGB = av_frame_alloc();
-    if (!m_frame || !m_frameRGB) {
-        qCritical() << "Failed to allocate frames";
-        cleanupFFmpeg();
+    // 打开输入流
+    AVDictionary *options = nullptr;
+    av_dict_set(&options, "rtsp_transport", transport.toUtf8().constData(), 0);
+    av_dict_set_int(&options, "max_delay", profile.maxDelayUs, 0);
+    av_dict_set_int(&options, "timeout", profile.timeoutUs, 0);
+    if (profile.reorderQueueSize >= 0) {
+        av_dict_set_int(&options, "reorder_queue_size", profile.reorderQueueSize, 0);
+    }
+    if (profile.bufferSize > 0) {
+        av_dict_set_int(&options, "buffer_size", profile.bufferSize, 0);
+    }
+
+    qDebug() << "Opening input with profile" << profile.name << ": rtsp_transport=" << transport
+             << "max_delay=" << profile.maxDelayUs << "timeout=" << profile.timeoutUs
+             << "reorder_queue_size=" << profile.reorderQueueSize << "buffer_size=" << profile.bufferSize
+             << "probesize=" << profile.probeSize << "nobuffer=" << profile.noBuffer;
+
+    setStreamState(StreamConnecting);
+    setIoDeadline(kOpenTimeoutUs);
+    int ret = avformat_open_input(&m_formatContext, url.toUtf8().constData(), nullptr, &options);
+    av_dict_free(&options);
+
+    if (ret < 0) {
+        // 失败时 avformat_open_input 已释放 context
+        m_formatContext = nullptr;
+        m_transportMonitor.detach();
+        if (!m_running) {
+            return false;
+        }
+        char errbuf[AV_ERROR_MAX_STRING_SIZE];
+        av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
+        qCritical() << "Failed to open input:" << (m_ioTimedOut ? "timed out" : errbuf) << "(error code:" << ret << ")";
+        qCritical() << "URL was:" << url;
+        return false;
+    }
+
+    qDebug() << "Input opened successfully";
+
+    // 有缓存参数时跳过探测：RTSP等协议打开后即可从SDP得到视频流，只缺尺寸等信息
+    m_videoStreamIndex = -1;
+    m_verifyStreamInfo = false;
+    if (m_isLiveSource && !m_cachedStreamInfo.isEmpty()) {
+        const int index = findVideoStream();
+        if (index >= 0 && applyCachedStreamInfo(index)) {
+            m_videoStreamIndex = index;
+            m_verifyStreamInfo = true;
+            qDebug() << "Using cached stream parameters, stream probe skipped";
+        } else {
+            qDebug() << "Cached stream parameters not applicable, probing stream";
+        }
+    }
+
+    if (m_videoStreamIndex == -1) {
+        setStreamState(StreamProbing);
+
+        // 获取流信息
+        qDebug() << "Finding stream info...";
+        setIoDeadline(kProbeTimeoutUs);
+        ret = avformat_find_stream_info(m_formatContext, nullptr);
+        setIoDeadline(0);
+        if (ret < 0) {
+            avformat_close_input(&m_formatContext);
+            m_transportMonitor.detach();
+            if (!m_running) {
+                return false;
+            }
+            char errbuf[AV_ERROR_MAX_STRING_SIZE];
+            av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
+            qCritical() << "Failed to find stream info:" << (m_ioTimedOut ? "timed out" : errbuf);
+            return false;
+        }
+
+        qDebug() << "Found" << m_formatContext->nb_streams << "streams";
+
+        // 查找视频流
+        m_videoStreamIndex = findVideoStream();
+        if (m_videoStreamIndex == -1) {
+            qCritical() << "No video stream found in" << m_formatContext->nb_streams << "streams";
+            avformat_close_input(&m_formatContext);
+            m_transportMonitor.detach();
+            return false;
+        }
+
+        // 实时流的探测结果交给配置缓存，下次连接同一地址时跳过探测
+        if (m_isLiveSource) {
+            emit streamInfoProbed(url, streamInfoFromStream(m_formatContext->streams[m_videoStreamIndex]));
+        }
+    }
+
+    qDebug() << "Video stream found at index:" << m_videoStreamIndex;
+    m_receivedSinceOpen = false;
+    m_lossWindowStartUs = av_gettime_relative();
+    return true;
+}
+
+int VideoDecoder::findVideoStream() const
+{
+    for (unsigned int i = 0; i < m_formatContext->nb_streams; i++) {
+        AVMediaType type = m_formatContext->streams[i]->codecpar->codec_type;
+        qDebug() << "Stream" << i << "type:" << av_get_media_type_string(type);
+        if (type == AVMEDIA_TYPE_VIDEO) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+bool VideoDecoder::applyCachedStreamInfo(int streamIndex)
+{
+    const QVariantMap &info = m_cachedStreamInfo;
+    if (info.value("version").toInt() != kStreamInfoVersion) {
+        return false;
+    }
+
+    AVStream *stream = m_formatContext->streams[streamIndex];
+    AVCodecParameters *params = stream->codecpar;
+    const AVCodecID codecId = static_cast<AVCodecID>(info.value("codecId").toInt());
+    const QByteArray extradata = info.value("extradata").toByteArray();
+
+    // 打开阶段已得到的信息（SDP中的编码格式和参数集）必须与缓存一致
+    if (params->codec_id != AV_CODEC_ID_NONE && params->codec_id != codecId) {
+        return false;
+    }
+    if (params->extradata_size > 0
+        && QByteArray::fromRawData(reinterpret_cast<const char *>(params->extradata), params->extradata_size) != extradata) {
+        return false;
+    }
+
+    params->codec_type = AVMEDIA_TYPE_VIDEO;
+    params->codec_id = codecId;
+    params->width = info.value("width").toInt();
+    params->height = info.value("height").toInt();
+    params->format = info.value("pixelFormat").toInt();
+
+    if (params->extradata_size == 0 && !extradata.isEmpty()) {
+        params->extradata = static_cast<uint8_t *>(av_mallocz(extradata.size() + AV_INPUT_BUFFER_PADDING_SIZE));
+        if (!params->extradata) {
+            return false;
+        }
+        memcpy(params->extradata, extradata.constData(), extradata.size());
+        params->extradata_size = extradata.size();
+    }
+
+    if (stream->time_base.num <= 0 || stream->time_base.den <= 0) {
+        stream->time_base = AVRational{ info.value("timeBaseNum").toInt(), info.value("timeBaseDen").toInt() };
+    }
+    if (stream->avg_frame_rate.num <= 0 || stream->avg_frame_rate.den <= 0) {
+        stream->avg_frame_rate = AVRational{ info.value("frameRateNum").toInt(), info.value("frameRateDen").toInt() };
+    }
+
+    return params->width > 0 && params->height > 0
+           && stream->time_base.num > 0 && stream->time_base.den > 0;
+}
+
+void VideoDecoder::verifyStreamInfo(const AVFrame *frame)
+{
+    // 第一帧与缓存的尺寸一致，或迟迟解不出帧，才能判断缓存是否可信
+    bool mismatch = false;
+    if (frame) {
+        mismatch = frame->width != m_videoWidth || frame->height != m_videoHeight;
+    } else if (++m_verifyPackets < kStreamInfoVerifyPackets) {
+        return;
+    } else {
+        mismatch = true;
+    }
+
+    m_verifyStreamInfo = false;
+    m_verifyPackets = 0;
+    if (!mismatch) {
+        qDebug() << "Cached stream parameters verified";
+        return;
+    }
+
+    qWarning() << "Cached stream parameters do not match the stream"
+               << (frame ? QString("(%1x%2)").arg(frame->width).arg(frame->height) : QString("(no frames decoded)"));
+    m_streamInfoRejected = true;
+    emit streamInfoRejected(m_url);
+}
+
+bool VideoDecoder::initFFmpeg(const QString &url)
+{
+    qDebug() << "=== VideoDecoder::initFFmpeg ===";
+    qDebug() << "URL:" << url;
+
+    // 本地文件没有实时约束，总是按PTS节奏播放
+    m_isLiveSource = !QFileInfo(url).isFile();
+
+    if (!openInput(url)) {
         return false;
     }
 
-    // 分配RGB buffer
-    m_bufferSize = av_image_get_buffer_size(AV_PIX_FMT_RGB24, m_videoWidth, m_videoHeight, 1);
-    m_buffer = (uint8_t *)av_malloc(m_bufferSize);
-    if (!m_buffer) {
-        qCritical() << "Failed to allocate buffer";
+    AVStream *stream = m_formatContext->streams[m_videoStreamIndex];
+    if (!openCodec(stream->codecpar)) {
         cleanupFFmpeg();
         return false;
     }
 
-    // 填充frameRGB
-    av_image_fill_arrays(m_frameRGB->data, m_frameRGB->linesize,
-                         m_buffer, AV_PIX_FMT_RGB24,
-                         m_videoWidth, m_videoHeight, 1);
+    // 保存当前流的参数，重连后据此判断能否沿用解码器
+    m_streamCodecParams = avcodec_parameters_alloc();
+    if (!m_streamCodecParams || avcodec_parameters_copy(m_streamCodecParams, stream->codecpar) < 0) {
+        qCritical() << "Failed to copy codec parameters";
+        cleanupFFmpeg();
+        return false;
+    }
 
-    // 创建sws context用于格式转换
-    m_swsContext = sws_getContext(
-        m_videoWidth, m_videoHeight, m_codecContext->pix_fmt,
-        m_videoWidth, m_videoHeight, AV_PIX_FMT_RGB24,
-        SWS_BILINEAR, nullptr, nullptr, nullptr
-    );
+    // 获取视频信息
+    m_videoWidth = m_codecContext->width;
+    m_videoHeight = m_codecContext->height;
+    m_timeBase = stream->time_base;
+    m_frameRate = streamFrameRate(stream);
 
-    if (!m_swsContext) {
-        qCritical() << "Failed to create sws context";
+    // 分配frame
+    m_frame = av_frame_alloc();
+    m_lastFrame = av_frame_alloc();
+    if (!m_frame || !m_lastFrame) {
+        qCritical() << "Failed to allocate frames";
         cleanupFFmpeg();
         return false;
     }
 
+    // 预分配RGB帧缓冲池，转换结果直接写入池中缓冲
+    // RGB32每像素4字节对齐，SIMD内核可以整块写入
+    const QSize outputSize = outputSizeFor(m_videoWidth, m_videoHeight);
+    m_framePool.configure(outputSize.width(), outputSize.height(), QImage::Format_RGB32);
+    m_framePool.resetStatistics();
+    m_frameSlot.resetStatistics();
+
     // 分配packet
     m_packet = av_packet_alloc();
     if (!m_packet) {
@@ -365,6 +1115,120 @@ bool VideoDecoder::initFFmpeg(const QString &url)
     return true;
 }
 
+bool VideoDecoder::openCodec(const AVCodecParameters *params)
+{
+    // 查找decoder
+    m_codec = avcodec_find_decoder(params->codec_id);
+    if (!m_codec) {
+        qCritical() << "Codec not found";
+        return false;
+    }
+
+    // 分配codec context
+    m_codecContext = avcodec_alloc_context3(m_codec);
+    if (!m_codecContext) {
+        qCritical() << "Failed to allocate codec context";
+        return false;
+    }
+
+    // 复制codec parameters到context
+    int ret = avcodec_parameters_to_context(m_codecContext, params);
+    if (ret < 0) {
+        qCritical() << "Failed to copy codec parameters";
+        avcodec_free_context(&m_codecContext);
+        return false;
+    }
+
+    // 低延迟接入配置：解码器不为帧重排缓存输出
+    if (m_ingestProfile.lowDelay) {
+        m_codecContext->flags |= AV_CODEC_FLAG_LOW_DELAY;
+    }
+
+    // 配置多线程解码（必须在打开codec之前设置）
+    configureDecoderThreading();
+
+    // 打开codec
+    ret = avcodec_open2(m_codecContext, m_codec, nullptr);
+    if (ret < 0) {
+        qCritical() << "Failed to open codec";
+        avcodec_free_context(&m_codecContext);
+        return false;
+    }
+
+    qDebug() << "Decoder opened with" << m_codecContext->thread_count << "threads, active type:"
+             << (m_codecContext->active_thread_type == FF_THREAD_FRAME ? "frame" :
+                 m_codecContext->active_thread_type == FF_THREAD_SLICE ? "slice" : "none");
+    return true;
+}
+
+void VideoDecoder::configureDecoderThreading()
+{
+    const int width = m_codecContext->width;
+    const int height = m_codecContext->height;
+    const qint64 pixels = static_cast<qint64>(width) * height;
+    const bool lowLatency = m_isLiveSource && m_presentationMode == LivePresentation;
+
+    // 线程数：按分辨率选择，避免小分辨率时线程同步开销大于收益
+    int threadCount = m_decoderThreadCount;
+    if (threadCount == 0) {
+        int ideal = qMax(1, QThread::idealThreadCount());
+        if (pixels <= 1280 * 720) {
+            threadCount = qMin(ideal, 4);
+        } else if (pixels <= 1920 * 1080) {
+            threadCount = qMin(ideal, 8);
+        } else {
+            threadCount = qMin(ideal, 16);
+        }
+    }
+
+    // 线程方式：片级多线程不增加延迟；帧级多线程每个线程增加一帧延迟
+    int threadType = 0;
+    switch (m_decoderThreadType) {
+    case FrameThreading:
+        threadType = FF_THREAD_FRAME;
+        break;
+    case SliceThreading:
+        threadType = FF_THREAD_SLICE;
+        break;
+    default:
+        if (!lowLatency) {
+            threadType = FF_THREAD_FRAME | FF_THREAD_SLICE;
+        } else if (pixels > 1920 * 1080) {
+            // 4K实时流单核解不动，允许少量帧级线程（最多增加2帧延迟）
+            threadType = FF_THREAD_FRAME | FF_THREAD_SLICE;
+            if (m_decoderThreadCount == 0) {
+                threadCount = qMin(threadCount, 3);
+            }
+        } else {
+            threadType = FF_THREAD_SLICE;
+        }
+        break;
+    }
+
+    // 只保留解码器支持的方式
+    int supported = 0;
+    if (m_codec->capabilities & AV_CODEC_CAP_FRAME_THREADS) {
+        supported |= FF_THREAD_FRAME;
+    }
+    if (m_codec->capabilities & AV_CODEC_CAP_SLICE_THREADS) {
+        supported |= FF_THREAD_SLICE;
+    }
+    threadType &= supported;
+    if (threadType == 0) {
+        threadCount = 1;
+    }
+
+    m_codecContext->thread_count = threadCount;
+    m_codecContext->thread_type = threadType;
+
+    const int frameDelay = (threadType & FF_THREAD_FRAME) ? threadCount - 1 : 0;
+    qDebug() << "Decoder threading:" << width << "x" << height
+             << "threads:" << threadCount
+             << "type:" << ((threadType & FF_THREAD_FRAME) ? "frame" : (threadType ? "slice" : "none"))
+             << "low latency:" << lowLatency
+             << "max added delay:" << frameDelay << "frames";
+}
+
 void VideoDecoder::cleanupFFmpeg()
 {
     if (m_packet) {
@@ -372,19 +1236,19 @@ void VideoDecoder::cleanupFFmpeg()
         m_packet = nullptr;
     }
 
-    if (m_swsContext) {
-        sws_freeContext(m_swsContext);
-        m_swsContext = nullptr;
-    }
+    m_frameConverter.reset();
 
-    if (m_buffer) {
-        av_free(m_buffer);
-        m_buffer = nullptr;
-    }
+    m_frameSlot.clear();
+    m_framePool.reset();
+    m_outputSize = QSize();
 
-    if (m_frameRGB) {
-        av_frame_free(&m_frameRGB);
-        m_frameRGB = nullptr;
+    {
+        QMutexLocker locker(&m_lastFrameMutex);
+        av_frame_free(&m_lastFrame);
+        if (m_burst) {
+            m_burst->finish();
+            m_burst.reset();
+        }
     }
 
     if (m_frame) {
@@ -397,53 +1261,430 @@ void VideoDecoder::cleanupFFmpeg()
         m_codecContext = nullptr;
     }
 
+    avcodec_parameters_free(&m_streamCodecParams);
+    {
+        QMutexLocker locker(&m_reconfigureMutex);
+        avcodec_parameters_free(&m_pendingCodecParams);
+    }
+
     if (m_formatContext) {
         avformat_close_input(&m_formatContext);
         m_formatContext = nullptr;
     }
+    m_transportMonitor.detach();
+    m_activeTransport = TransportNone;
 
     m_videoStreamIndex = -1;
     m_videoWidth = 0;
     m_videoHeight = 0;
     m_frameRate = 0.0;
+    m_timeBase = AVRational{0, 1};
 }
 
-bool VideoDecoder::decodePacket()
+int VideoDecoder::decodePacket(AVPacket *packet)
 {
-    // 发送packet到decoder
-    int ret = avcodec_send_packet(m_codecContext, m_packet);
-    if (ret < 0) {
-        qWarning() << "Error sending packet to decoder";
-        return false;
+    // 空packet表示排空请求（文件结束），解码器输出所有缓存帧
+    const bool drain = !packet->data && !packet->size;
+    int frames = 0;
+
+    int64_t sendStart = av_gettime_relative();
+    int ret;
+    {
+        TRACE_SCOPE_FRAME("avcodec_send_packet", Tracing::kNoValue, packet->pts);
+        ret = avcodec_send_packet(m_codecContext, packet);
+    }
+    m_packetDecodeTimeUs = av_gettime_relative() - sendStart;
+    m_statsDecodeTimeUs += m_packetDecodeTimeUs;
+
+    // 解码器输出缓冲已满：先取出帧，再重新发送
+    while (ret == AVERROR(EAGAIN)) {
+        int received = receiveFrames();
+        frames += received;
+        if (received == 0) {
+            break;
+        }
+        ret = avcodec_send_packet(m_codecContext, packet);
+    }
+
+    if (ret < 0 && ret != AVERROR_EOF) {
+        char errbuf[AV_ERROR_MAX_STRING_SIZE];
+        av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
+        qWarning() << "Error sending packet to decoder:" << errbuf;
+        return frames;
+    }
+
+    if (!drain && ret >= 0) {
+        // 记录已送入解码器的PTS，用于计算解码器内部帧延迟
+        m_sentPts[m_sentPtsHead] = packet->pts;
+        m_sentPtsHead = (m_sentPtsHead + 1) % kSentPtsHistory;
+        m_sentPtsCount = qMin(m_sentPtsCount + 1, kSentPtsHistory);
+    }
+
+    // 每个packet可能对应零到多个帧，必须全部取出
+    frames += receiveFrames();
+
+    if (!drain) {
+        m_metrics.record(PipelineMetrics::DecodeTime, static_cast<quint64>(qMax<int64_t>(m_packetDecodeTimeUs, 0)));
+    }
+
+    if (m_verifyStreamInfo && frames == 0 && !drain) {
+        verifyStreamInfo(nullptr);
+    }
+
+    if (drain) {
+        qDebug() << "Decoder drained at end of stream";
+        avcodec_flush_buffers(m_codecContext);
+        m_sentPtsCount = 0;
+    }
+
+    return frames;
+}
+
+int VideoDecoder::receiveFrames()
+{
+    int frames = 0;
+
+    while (true) {
+        int64_t receiveStart = av_gettime_relative();
+        int ret;
+        {
+            TRACE_SCOPE_VAR(receiveTrace, "avcodec_receive_frame");
+            ret = avcodec_receive_frame(m_codecContext, m_frame);
+            TRACE_SET_FRAME(receiveTrace, ret >= 0 ? m_frameSerial + 1 : Tracing::kNoValue,
+                            ret >= 0 ? m_frame->best_effort_timestamp : AV_NOPTS_VALUE);
+        }
+        const int64_t receiveTimeUs = av_gettime_relative() - receiveStart;
+        m_statsDecodeTimeUs += receiveTimeUs;
+        m_packetDecodeTimeUs += receiveTimeUs;
+
+        if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
+            break;
+        } else if (ret < 0) {
+            char errbuf[AV_ERROR_MAX_STRING_SIZE];
+            av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
+            qWarning() << "Error receiving frame from decoder:" << errbuf;
+            break;
+        }
+
+        frames++;
+        m_frameSerial++;
+        m_statsDecodedFrames++;
+        m_metrics.add(PipelineMetrics::FramesDecoded);
+        updateDecoderDelay(m_frame->pts);
+
+        if (m_verifyStreamInfo) {
+            verifyStreamInfo(m_frame);
+        }
+
+        // 停止过程中只排空，不再显示
+        if (m_running) {
+            presentFrame();
+        }
+
+        av_frame_unref(m_frame);
+    }
+
+    return frames;
+}
+
+void VideoDecoder::presentFrame()
+{
+    const int64_t pts = m_frame->best_effort_timestamp;
+    TRACE_SCOPE_FRAME("presentFrame", m_frameSerial, pts);
+
+    // 带发送端时间戳的帧按阶段打点（使用与发送端一致的墙上时钟）
+    LatencyTracker::FrameTimes latency;
+    const bool measured = m_hasTimestampSei && m_frame->pts != AV_NOPTS_VALUE
+                          && m_latencyTracker.takeFrame(m_frame->pts, &latency);
+    if (measured) {
+        latency.decodedUs = av_gettime();
+    }
+
+    // 转换为RGB（或直接交出YUV平面），按呈现时钟等待后交给渲染端；帧池耗尽时丢弃该帧
+    VideoFrame frame;
+    if (!prepareFrame(frame)) {
+        return;
+    }
+    if (measured) {
+        latency.convertedUs = av_gettime();
+    }
+    frame.setSequence(m_frameSerial, pts);
+    {
+        TRACE_SCOPE_FRAME("waitForPresentationTime", m_frameSerial, pts);
+        waitForPresentationTime(pts);
+    }
+
+    // 渲染端还没处理上一次通知时不再发送，避免GUI线程繁忙时信号堆积
+    if (m_frameSlot.publish(frame)) {
+        emit frameReady(pts);
+    }
+
+    const quint64 droppedFrames = m_frameSlot.droppedFrames();
+    if (droppedFrames != m_seenDroppedFrames) {
+        m_metrics.add(PipelineMetrics::FramesDropped, droppedFrames - m_seenDroppedFrames);
+        m_seenDroppedFrames = droppedFrames;
+    }
+
+    if (measured) {
+        latency.presentedUs = av_gettime();
+        m_latencyTracker.addFrame(latency);
+    }
+
+    if (m_awaitingFirstFrame) {
+        m_awaitingFirstFrame = false;
+        m_lastReconnectTimeMs = static_cast<int>((av_gettime_relative() - m_reconnectStartUs) / 1000);
+        qDebug() << "First frame after reconnect in" << m_lastReconnectTimeMs << "ms";
+    }
+}
+
+void VideoDecoder::recordPacketMetrics(const AVPacket *packet)
+{
+    m_metrics.add(PipelineMetrics::PacketsReceived);
+    m_metrics.add(PipelineMetrics::BytesReceived, static_cast<quint64>(packet->size));
+    m_metrics.record(PipelineMetrics::PacketSize, static_cast<quint64>(packet->size));
+
+    // 到达抖动：相邻packet的到达间隔与DTS间隔之差（本地文件按需读取，没有意义）
+    if (!m_isLiveSource || packet->dts == AV_NOPTS_VALUE) {
+        return;
+    }
+    const int64_t arrivalUs = av_gettime_relative();
+    if (m_lastArrivalDts != AV_NOPTS_VALUE && packet->dts > m_lastArrivalDts) {
+        const AVRational timeBase = m_formatContext->streams[m_videoStreamIndex]->time_base;
+        const int64_t expectedUs = av_rescale_q(packet->dts - m_lastArrivalDts, timeBase, AV_TIME_BASE_Q);
+        const int64_t jitterUs = (arrivalUs - m_lastArrivalUs) - expectedUs;
+        m_metrics.record(PipelineMetrics::ArrivalJitter, static_cast<quint64>(jitterUs < 0 ? -jitterUs : jitterUs));
     }
+    m_lastArrivalUs = arrivalUs;
+    m_lastArrivalDts = packet->dts;
+}
 
-    // 从decoder接收frame
-    ret = avcodec_receive_frame(m_codecContext, m_frame);
-    if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
+void VideoDecoder::startRecording(const QString &filePath, bool includeReplay)
+{
+    {
+        QMutexLocker locker(&m_recordMutex);
+        m_recordPath = filePath;
+        m_recordReplay = includeReplay;
+    }
+    m_recordRequested = true;
+}
+
+void VideoDecoder::stopRecording()
+{
+    m_recordRequested = false;
+    m_recorder.stop();
+}
+
+void VideoDecoder::setReplayBuffer(int seconds, int budgetMB)
+{
+    m_replaySeconds = qMax(0, seconds);
+    m_replayBudgetMB = qMax(1, budgetMB);
+    m_replayRing.setLimits(m_replaySeconds * 1000000LL, m_replayBudgetMB * 1024LL * 1024);
+    qDebug() << "Replay buffer:" << m_replaySeconds << "s," << m_replayBudgetMB << "MB";
+}
+
+void VideoDecoder::recordPacket(const AVPacket *packet)
+{
+    const AVStream *stream = m_formatContext->streams[m_videoStreamIndex];
+
+    if (m_recordRequested.exchange(false)) {
+        QString path;
+        bool includeReplay;
+        {
+            QMutexLocker locker(&m_recordMutex);
+            path = m_recordPath;
+            includeReplay = m_recordReplay;
+        }
+
+        // 保存回放时取整个缓冲；普通录像只取最近一个GOP，当前packet就是关键帧时直接从它开始
+        QVector<const AVPacket *> preroll;
+        if (includeReplay || !(packet->flags & AV_PKT_FLAG_KEY)) {
+            preroll = m_replayRing.packets(!includeReplay);
+        }
+        m_recorder.start(path, stream->codecpar, stream->time_base, stream->avg_frame_rate, preroll);
+    }
+
+    m_recorder.write(packet);
+    m_replayRing.push(packet, stream->time_base);
+}
+
+void VideoDecoder::trackTimestampSei(const AVPacket *packet)
+{
+    if (packet->pts == AV_NOPTS_VALUE) {
+        return;
+    }
+
+    const AVCodecParameters *params = m_formatContext->streams[m_videoStreamIndex]->codecpar;
+    int64_t captureUs = 0;
+    if (!SeiTimestamp::extract(packet, params->codec_id, SeiTimestamp::nalLengthSize(params), &captureUs)) {
+        return;
+    }
+
+    m_latencyTracker.packetReceived(packet->pts, captureUs, av_gettime());
+    if (!m_hasTimestampSei.exchange(true)) {
+        qDebug() << "Timestamp SEI detected, measuring end-to-end latency";
+    }
+}
+
+void VideoDecoder::updateDecoderDelay(int64_t framePts)
+{
+    if (framePts == AV_NOPTS_VALUE) {
+        return;
+    }
+
+    // 在最近送入的PTS中查找该帧，其后送入的packet数即解码器内部滞留的帧数
+    for (int i = 1; i <= m_sentPtsCount; ++i) {
+        int index = (m_sentPtsHead - i + kSentPtsHistory) % kSentPtsHistory;
+        if (m_sentPts[index] == framePts) {
+            m_decoderDelayFrames = i - 1;
+            return;
+        }
+    }
+}
+
+void VideoDecoder::resetDecodeStatistics()
+{
+    m_statsDecodeTimeUs = 0;
+    m_statsConvertTimeUs = 0;
+    m_statsDecodedFrames = 0;
+    m_sentPtsHead = 0;
+    m_sentPtsCount = 0;
+    m_decoderDelayFrames = 0;
+}
+
+bool VideoDecoder::prepareFrame(VideoFrame &frame)
+{
+    // 保留原始帧引用供截图使用（只增加引用计数，不复制数据）；连拍时复制到预分配的缓冲
+    std::shared_ptr<BurstCapture> burst;
+    {
+        QMutexLocker locker(&m_lastFrameMutex);
+        av_frame_unref(m_lastFrame);
+        av_frame_ref(m_lastFrame, m_frame);
+        burst = m_burst;
+    }
+    if (burst) {
+        TRACE_SCOPE_FRAME("BurstCapture::append", m_frameSerial, m_frame->best_effort_timestamp);
+        if (!burst->append(m_frame)) {
+            QMutexLocker locker(&m_lastFrameMutex);
+            if (m_burst == burst) {
+                m_burst.reset();
+            }
+        }
+    }
+
+    // 渲染器可以在着色器中转换颜色时，直接交出解码帧的YUV平面
+    m_lastFrameYuv = m_yuvOutput && VideoFrame::isYuvRenderable(m_frame->format);
+    if (!m_lastFrameYuv) {
+        return convertFrameToRGB(frame);
+    }
+
+    frame = VideoFrame::fromAVFrame(m_frame);
+    return !frame.isNull();
+}
+
+bool VideoDecoder::convertFrameToRGB(VideoFrame &frame)
+{
+    // 输出尺寸变化时帧池按新尺寸重新分配，尺寸不变时直接返回
+    const QSize outputSize = outputSizeFor(m_frame->width, m_frame->height);
+    m_framePool.configure(outputSize.width(), outputSize.height(), QImage::Format_RGB32);
+
+    // 从帧池取出空闲缓冲，渲染器仍持有所有缓冲时返回空图像
+    QImage image = m_framePool.acquire();
+    if (image.isNull()) {
         return false;
-    } else if (ret < 0) {
-        qWarning() << "Error receiving frame from decoder";
+    }
+
+    // 转换颜色空间从YUV到RGB，直接写入池缓冲
+    int64_t convertStart = av_gettime_relative();
+    bool converted;
+    {
+        TRACE_SCOPE_FRAME("FrameConverter::convert", m_frameSerial, m_frame->best_effort_timestamp);
+        converted = m_frameConverter.convert(m_frame, image);
+    }
+    const int64_t convertTimeUs = av_gettime_relative() - convertStart;
+    m_statsConvertTimeUs += convertTimeUs;
+    m_metrics.record(PipelineMetrics::ConvertTime, static_cast<quint64>(convertTimeUs));
+    if (!converted) {
         return false;
     }
 
+    // 只传递引用，旧缓冲在最后一个使用者释放后回到池中
+    frame = VideoFrame(image);
     return true;
 }
 
-void VideoDecoder::convertFrameToRGB()
+QSize VideoDecoder::outputSizeFor(int width, int height)
 {
-    // 转换颜色空间从YUV到RGB
-    sws_scale(m_swsContext,
-              m_frame->data, m_frame->linesize,
-              0, m_videoHeight,
-              m_frameRGB->data, m_frameRGB->linesize);
+    QSize requested;
+    {
+        QMutexLocker locker(&m_outputSizeMutex);
+        requested = m_requestedOutputSize;
+    }
+
+    QSize output(width, height);
+    if (requested.width() > 0 && requested.height() > 0
+        && (requested.width() < width || requested.height() < height)) {
+        // 保持宽高比缩小到目标尺寸内，宽高取偶数
+        output.scale(requested, Qt::KeepAspectRatio);
+        output.setWidth(qMax(2, output.width() & ~1));
+        output.setHeight(qMax(2, output.height() & ~1));
+    }
 
-    // 创建QImage
-    QImage image(m_frameRGB->data[0],
-                 m_videoWidth, m_videoHeight,
-                 m_frameRGB->linesize[0],
-                 QImage::Format_RGB888);
+    if (output != m_outputSize) {
+        qDebug() << "Decoder output size:" << width << "x" << height << "->" << output;
+        m_outputSize = output;
+    }
+    return output;
+}
 
-    // 复制到成员变量（因为m_frameRGB的数据会被重用）
-    QMutexLocker locker(&m_frameMutex);
-    m_latestFrame = image.copy();
+void VideoDecoder::resetPresentationClock()
+{
+    m_clockValid = false;
+}
+
+void VideoDecoder::waitForPresentationTime(int64_t pts)
+{
+    // 实时模式下直接显示最新帧；本地文件始终按平滑模式调度
+    bool smooth = m_presentationMode == SmoothPresentation || !m_isLiveSource;
+    if (!smooth || pts == AV_NOPTS_VALUE || m_timeBase.den == 0) {
+        m_clockValid = false;
+        return;
+    }
+
+    const double ptsSeconds = pts * av_q2d(m_timeBase);
+    const int64_t now = av_gettime_relative();
+
+    if (!m_clockValid) {
+        m_clockBaseUs = now;
+        m_clockBasePts = ptsSeconds;
+        m_clockValid = true;
+        return;
+    }
+
+    const int64_t target = m_clockBaseUs + static_cast<int64_t>((ptsSeconds - m_clockBasePts) * 1000000.0);
+    const int64_t delay = target - now;
+
+    if (delay > kMaxEarlyUs || delay < -kMaxLateUs) {
+        // PTS跳变（循环播放、流重启）或严重落后，以当前帧重新对齐时钟
+        qDebug() << "Presentation clock resync, drift:" << delay / 1000 << "ms";
+        m_clockBaseUs = now;
+        m_clockBasePts = ptsSeconds;
+        return;
+    }
+
+    if (delay < 0) {
+        // 帧迟到：立即显示，并把时钟基准后移，避免后续帧连续追赶
+        m_clockBaseUs -= delay;
+        return;
+    }
+
+    if (m_isLiveSource && delay > kJitterBudgetUs) {
+        // 发送端时钟快于本地时钟时缓冲会不断增长，逐步收敛到抖动预算内
+        m_clockBaseUs -= (delay - kJitterBudgetUs) / 16;
+    }
+
+    int64_t remaining = delay;
+    while (remaining > 0 && m_running && !m_paused) {
+        QThread::usleep(static_cast<unsigned long>(qMin(remaining, kSleepSliceUs)));
+        remaining = target - av_gettime_relative();
+    }
 }
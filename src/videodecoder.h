@@ -4,9 +4,26 @@
 #include <QObject>
 #include <QImage>
 #include <QMutex>
+#include <QSize>
 #include <QThread>
 #include <QString>
-#include <QQueue>
+#include <QVariantMap>
+#include <QVector>
+#include <atomic>
+#include <memory>
+#include "burstcapture.h"
+#include "frameconverter.h"
+#include "framepool.h"
+#include "frameslot.h"
+#include "ingestprofile.h"
+#include "iowaker.h"
+#include "latencytracker.h"
+#include "packetqueue.h"
+#include "packetring.h"
+#include "pipelinemetrics.h"
+#include "streamrecorder.h"
+#include "transportmonitor.h"
+#include "videoframe.h"
 
 extern "C" {
 #include <libavcodec/avcodec.h>
@@ -21,17 +38,56 @@ class VideoDecoder : public QThread
     Q_OBJECT
 
 public:
+    // 帧呈现模式
+    enum PresentationMode {
+        LivePresentation = 0,    // 实时模式：从不等待，总是显示最新帧
+        SmoothPresentation = 1   // 平滑模式：按流时基和PTS调度帧，并校正时钟漂移
+    };
+    Q_ENUM(PresentationMode)
+
+    // 软件解码多线程方式
+    enum DecoderThreadType {
+        AutoThreading = 0,       // 根据分辨率和呈现模式自动选择
+        FrameThreading = 1,      // 帧级多线程：吞吐量高，但每个线程增加一帧延迟
+        SliceThreading = 2       // 片级多线程：不增加延迟，需要码流包含多个slice
+    };
+    Q_ENUM(DecoderThreadType)
+
+    // 流打开状态（在解复用线程中推进）
+    enum StreamState {
+        StreamIdle = 0,          // 未打开
+        StreamConnecting = 1,    // 正在连接（avformat_open_input）
+        StreamProbing = 2,       // 正在探测流信息（avformat_find_stream_info）
+        StreamStreaming = 3,     // 已打开，正在读取数据
+        StreamFailed = 4         // 打开失败
+    };
+    Q_ENUM(StreamState)
+
     explicit VideoDecoder(QObject *parent = nullptr);
     ~VideoDecoder() override;
 
-    // 打开视频流
+    // 异步打开视频流：连接和探测在解复用线程中进行，成功后自动开始解码
+    // 结果通过 streamOpened 或 errorOccurred 返回，closeStream 可随时取消
     bool openStream(const QString &url);
 
-    // 关闭视频流
+    // 接入配置（按名称，见 IngestProfile），下次打开流时生效
+    void setIngestProfile(const QString &name);
+    QString ingestProfile() const { return m_ingestProfile.name; }
+
+    // RTSP实际使用的传输方式（"tcp"/"udp"，非RTSP流为空）及UDP接收统计
+    QString activeTransport() const;
+    quint64 rtpLostPackets() const { return m_transportMonitor.lostPackets(); }
+    quint64 rtpReorderedPackets() const { return m_transportMonitor.latePackets() + m_transportMonitor.jitterOverflows(); }
+    double rtpLossRate() const { return m_transportMonitor.lossRate(); }
+
+    // 该地址上次探测得到的流参数（见 streamInfoProbed），下次打开前设置
+    // 参数有效时跳过 avformat_find_stream_info，首批数据与之不符时自动回退到完整探测
+    void setCachedStreamInfo(const QVariantMap &info) { m_cachedStreamInfo = info; }
+
+    // 关闭视频流（取消正在进行的打开）
     void closeStream();
 
-    // 启动/停止解码
-    void startDecoding();
+    // 停止/暂停/恢复解码
     void stopDecoding();
     void pauseDecoding();
     void resumeDecoding();
@@ -41,19 +97,86 @@ public:
     int videoHeight() const { return m_videoHeight; }
     double frameRate() const { return m_frameRate; }
 
-    // 获取最新的帧（RGB格式）
-    QImage getLatestFrame();
+    // 呈现模式（可在解码过程中切换）
+    int presentationMode() const { return m_presentationMode; }
+    void setPresentationMode(int mode);
+
+    // 解码线程配置（下次打开流时生效），线程数为0表示自动
+    int decoderThreadCount() const { return m_decoderThreadCount; }
+    void setDecoderThreadCount(int count);
+    int decoderThreadType() const { return m_decoderThreadType; }
+    void setDecoderThreadType(int type);
+
+    // 解复用与解码之间的数据包队列
+    void setPacketQueueCapacity(int capacity);
+    int packetQueueCapacity() const { return m_packetQueue.capacity(); }
+    int packetQueueDepth() const { return m_packetQueue.size(); }
+    int packetQueueHighWaterMark() const { return m_packetQueue.highWaterMark(); }
+    quint64 droppedPackets() const { return m_packetQueue.droppedPackets(); }
+
+    // RGB帧缓冲池（下次打开流时按新大小分配）
+    void setFramePoolSize(int size) { m_framePool.setPoolSize(size); }
+    int framePoolSize() const { return m_framePool.poolSize(); }
+    int framePoolAvailable() const { return m_framePool.availableBuffers(); }
+    quint64 framePoolExhausted() const { return m_framePool.exhaustedCount(); }
+
+    // 解码器内部滞留的帧数（B帧重排和帧级多线程引入的延迟）
+    int decoderDelayFrames() const { return m_decoderDelayFrames; }
+
+    // 转换输出尺寸（渲染器的物理像素尺寸），帧按宽高比缩小到该尺寸内，不放大；空尺寸表示原始分辨率
+    void setOutputSize(const QSize &size);
+
+    // 渲染器支持着色器颜色转换时直接输出YUV平面，不支持的像素格式仍转换为RGB
+    void setYuvOutputEnabled(bool enabled);
+
+    // 最新帧交接（渲染线程在 updatePaintNode 中读取）
+    FrameSlot *frameSlot() { return &m_frameSlot; }
+    quint64 droppedFrames() const { return m_frameSlot.droppedFrames(); }
+
+    // 最新解码帧的引用（原始分辨率的YUV平面，用于截图），只增加引用计数
+    VideoFrame captureFrame();
+
+    // 连拍：之后每个解码帧复制到 burst 中，直到采集结束
+    void setBurstCapture(const std::shared_ptr<BurstCapture> &burst);
+
+    // 断线重连统计：重连次数，最近一次从断线到重连后首帧显示的耗时（-1表示尚未重连）
+    int reconnectCount() const { return m_reconnectCount; }
+    int lastReconnectTimeMs() const { return m_lastReconnectTimeMs; }
+
+    // 流水线指标（各线程无锁写入，GUI线程定期采样），渲染器也写入渲染间隔
+    PipelineMetrics *metrics() { return &m_metrics; }
+
+    // 端到端延迟（发送端嵌入时间戳SEI时有效，见 LatencyTracker::snapshot），没有样本时为空
+    QVariantMap latencyStats() const { return m_latencyTracker.snapshot(); }
+
+    // 录像：直接封装收到的压缩数据（见 StreamRecorder），请求在解复用线程处理下一个视频packet时执行
+    // 普通录像从回放缓冲中最近的关键帧开始；includeReplay 时先写入整个回放缓冲（最近N秒），再继续实时录制
+    void startRecording(const QString &filePath, bool includeReplay = false);
+    void stopRecording();
+    StreamRecorder *recorder() { return &m_recorder; }
+
+    // 回放缓冲（见 PacketRing）：保留时长和内存预算，可随时修改
+    void setReplayBuffer(int seconds, int budgetMB);
+    int replayBufferSeconds() const { return m_replaySeconds; }
+    int replayBufferBudgetMB() const { return m_replayBudgetMB; }
+    qint64 replayBufferBytes() const { return m_replayRing.bytes(); }
+    qint64 replayBufferMemory() const { return m_replayRing.memoryBytes(); }
+    int replayBufferDurationMs() const { return static_cast<int>(m_replayRing.durationUs() / 1000); }
 
     bool isRunning() const { return m_running; }
+    int streamState() const { return m_streamState; }
 
 signals:
-    void frameReady();
+    void frameReady(qint64 pts);    // 已合并：渲染端处理前不会再次发送
     void errorOccurred(const QString &error);
     void streamOpened(int width, int height, double fps);
     void streamClosed();
-    void packetReceived(int packetSize);  // 新增：接收到数据包时发送大小
+    void streamStateChanged(int state);
+    void streamInfoProbed(const QString &url, const QVariantMap &info);   // 完整探测得到的流参数，可缓存
+    void streamInfoRejected(const QString &url);                          // 缓存的流参数与实际码流不符
 
 protected:
+    // 解复用线程：读取数据包并送入队列
     void run() override;
 
 private:
@@ -62,34 +185,160 @@ private:
     AVCodecContext *m_codecContext;
     const AVCodec *m_codec;
     AVFrame *m_frame;
-    AVFrame *m_frameRGB;
     AVPacket *m_packet;
-    SwsContext *m_swsContext;
 
     // 视频流信息
     int m_videoStreamIndex;
     int m_videoWidth;
     int m_videoHeight;
     double m_frameRate;
+    AVRational m_timeBase;
+    bool m_isLiveSource;     // 实时流（非本地文件）
+    QString m_url;
+    IngestProfile m_ingestProfile;   // 打开前由GUI线程设置，之后仅工作线程访问
+
+    // RTSP传输方式：auto 配置先用UDP，不通或丢包率超过阈值后本次会话改用TCP
+    enum Transport {
+        TransportNone = 0,
+        TransportTcp = 1,
+        TransportUdp = 2
+    };
+    std::atomic<int> m_activeTransport;
+    bool m_tcpFallback;                // 以下仅解复用线程访问
+    bool m_receivedSinceOpen;
+    int64_t m_lossWindowStartUs;
+    TransportMonitor m_transportMonitor;
 
-    // RGB buffer
-    uint8_t *m_buffer;
-    int m_bufferSize;
+    // RGB帧缓冲池及颜色转换
+    FramePool m_framePool;
+    FrameConverter m_frameConverter;
+
+    // 输出尺寸
+    QMutex m_outputSizeMutex;
+    QSize m_requestedOutputSize;
+    QSize m_outputSize;
+
+    // 保留最新解码帧的引用供截图使用；连拍时同时复制到连拍缓冲
+    QMutex m_lastFrameMutex;
+    AVFrame *m_lastFrame;
+    std::shared_ptr<BurstCapture> m_burst;
 
     // 控制标志
-    bool m_running;
-    bool m_streamOpened;
-    bool m_paused;
+    std::atomic<bool> m_running;
+    std::atomic<bool> m_streamOpened;
+    std::atomic<int> m_streamState;
+
+    // 当前FFmpeg阻塞操作的截止时间（av_gettime_relative，0表示不限），由中断回调检查
+    std::atomic<int64_t> m_ioDeadlineUs;
+    std::atomic<bool> m_ioTimedOut;
+    IoWaker m_ioWaker;                 // 停止时唤醒阻塞在网络等待中的解复用线程
+
+    // 断线重连：解复用线程登记新流的参数，解码线程收到刷新标记后应用
+    AVCodecParameters *m_streamCodecParams;    // 当前解码器对应的参数（仅解复用线程访问）
+    QMutex m_reconfigureMutex;
+    AVCodecParameters *m_pendingCodecParams;   // 非空表示需要重建解码器
+    AVRational m_pendingTimeBase;
+    double m_pendingFrameRate;
+    std::atomic<int> m_reconnectCount;
+    std::atomic<int> m_lastReconnectTimeMs;
+    std::atomic<int64_t> m_reconnectStartUs;
+    bool m_awaitingFirstFrame;                 // 仅解码线程访问
+
+    // 探测缓存：使用缓存参数打开后，解码线程用首批数据校验，不符时通知解复用线程重新完整探测
+    QVariantMap m_cachedStreamInfo;            // 打开前由GUI线程设置，之后仅解复用线程访问
+    std::atomic<bool> m_verifyStreamInfo;
+    std::atomic<bool> m_streamInfoRejected;
+    int m_verifyPackets;                       // 仅解码线程访问
+
+    // 流水线指标；以下打点状态各自仅由一个线程访问
+    PipelineMetrics m_metrics;
+    int64_t m_lastArrivalUs;                   // 解复用线程：上一个视频packet的到达时刻和DTS
+    int64_t m_lastArrivalDts;
+    quint64 m_seenDroppedPackets;              // 解复用线程：已计入指标的队列丢包数
+    quint64 m_seenDroppedFrames;               // 解码线程：已计入指标的丢帧数
+    int64_t m_packetDecodeTimeUs;              // 解码线程：当前packet的解码耗时
+    qint64 m_frameSerial;                      // 解码线程：已解码帧序号（跟踪事件用）
+
+    // 端到端延迟：解复用线程发现时间戳SEI后置位，解码线程才开始打点
+    LatencyTracker m_latencyTracker;
+    std::atomic<bool> m_hasTimestampSei;
+    std::atomic<bool> m_paused;
+    std::atomic<bool> m_demuxFinished;
+    std::atomic<int> m_presentationMode;
+
+    // 解码多线程配置
+    int m_decoderThreadCount;
+    int m_decoderThreadType;
+
+    // 呈现时钟：将PTS映射到本地单调时钟（微秒）
+    std::atomic<bool> m_clockValid;
+    int64_t m_clockBaseUs;
+    double m_clockBasePts;
+
+    // 录像：GUI线程登记请求，解复用线程执行；回放缓冲仅由解复用线程写入
+    StreamRecorder m_recorder;
+    QMutex m_recordMutex;
+    QString m_recordPath;
+    bool m_recordReplay;
+    std::atomic<bool> m_recordRequested;
+    PacketRing m_replayRing;
+    std::atomic<int> m_replaySeconds;
+    std::atomic<int> m_replayBudgetMB;
+
+    // 解码线程及数据包队列
+    QThread *m_decodeThread;
+    PacketQueue m_packetQueue;
+
+    // 解码统计
+    static const int kSentPtsHistory = 64;
+    int64_t m_sentPts[kSentPtsHistory];
+    int m_sentPtsHead;
+    int m_sentPtsCount;
+    std::atomic<int> m_decoderDelayFrames;
+    int64_t m_statsDecodeTimeUs;
+    int64_t m_statsConvertTimeUs;
+    int m_statsDecodedFrames;
 
-    // 帧缓冲
-    QMutex m_frameMutex;
-    QImage m_latestFrame;
+    // 帧交接
+    FrameSlot m_frameSlot;
+    std::atomic<bool> m_yuvOutput;
+    bool m_lastFrameYuv;     // 最近一帧走着色器路径（仅解码线程访问）
 
     // 内部方法
     bool initFFmpeg(const QString &url);
+    bool openInput(const QString &url);
+    bool tryOpenInput(const QString &url);
+    bool canFallBackToTcp() const;
+    bool transportNeedsFallback();
+    int findVideoStream() const;
+    bool applyCachedStreamInfo(int streamIndex);
+    void verifyStreamInfo(const AVFrame *frame);
+    bool openCodec(const AVCodecParameters *params);
+    bool reconnect();
+    void resumeAfterReconnect(int64_t startUs);
+    bool handleDiscontinuity();
+    static int interruptCallback(void *opaque);
+    void setIoDeadline(int64_t timeoutUs);
+    void sleepWhileRunning(int ms);
+    void setStreamState(StreamState state);
+    void startDecodeThread();
+    void demuxLoop();
     void cleanupFFmpeg();
-    bool decodePacket();
-    void convertFrameToRGB();
+    void configureDecoderThreading();
+    void decodeLoop();
+    int decodePacket(AVPacket *packet);
+    int receiveFrames();
+    void presentFrame();
+    void trackTimestampSei(const AVPacket *packet);
+    void recordPacketMetrics(const AVPacket *packet);
+    void recordPacket(const AVPacket *packet);
+    bool prepareFrame(VideoFrame &frame);
+    void updateDecoderDelay(int64_t framePts);
+    void resetDecodeStatistics();
+    bool convertFrameToRGB(VideoFrame &frame);
+    QSize outputSizeFor(int width, int height);
+    void resetPresentationClock();
+    void waitForPresentationTime(int64_t pts);
 };
 
 #endif // VIDEODECODER_H
@@ -0,0 +1,87 @@
+#include "videoframe.h"
+
+extern "C" {
+#include <libavutil/pixfmt.h>
+}
+
+VideoFrame::VideoFrame()
+    : m_frameId(-1)
+    , m_pts(AV_NOPTS_VALUE)
+{
+}
+
+VideoFrame::VideoFrame(const QImage &image)
+    : m_image(image)
+    , m_frameId(-1)
+    , m_pts(AV_NOPTS_VALUE)
+{
+}
+
+void VideoFrame::setSequence(qint64 frameId, qint64 pts)
+{
+    m_frameId = frameId;
+    m_pts = pts;
+}
+
+VideoFrame VideoFrame::fromAVFrame(const AVFrame *frame)
+{
+    VideoFrame videoFrame;
+    if (!frame) {
+        return videoFrame;
+    }
+
+    AVFrame *ref = av_frame_alloc();
+    if (!ref) {
+        return videoFrame;
+    }
+
+    if (av_frame_ref(ref, frame) < 0) {
+        av_frame_free(&ref);
+        return videoFrame;
+    }
+
+    // 最后一个引用释放时归还解码器缓冲
+    videoFrame.m_frame.reset(ref, [](AVFrame *f) { av_frame_free(&f); });
+    return videoFrame;
+}
+
+bool VideoFrame::isYuvRenderable(int pixelFormat)
+{
+    switch (pixelFormat) {
+    case AV_PIX_FMT_YUV420P:
+    case AV_PIX_FMT_YUVJ420P:
+    case AV_PIX_FMT_YUV422P:
+    case AV_PIX_FMT_YUVJ422P:
+    case AV_PIX_FMT_YUV444P:
+    case AV_PIX_FMT_YUVJ444P:
+    case AV_PIX_FMT_NV12:
+        return true;
+    default:
+        return false;
+    }
+}
+
+YuvConvert::Matrix VideoFrame::colorMatrix(const AVFrame *frame)
+{
+    if (frame->colorspace == AVCOL_SPC_BT709
+        || (frame->colorspace == AVCOL_SPC_UNSPECIFIED && frame->height >= 720)) {
+        return YuvConvert::MatrixBT709;
+    }
+    return YuvConvert::MatrixBT601;
+}
+
+bool VideoFrame::isFullRange(const AVFrame *frame)
+{
+    return frame->color_range == AVCOL_RANGE_JPEG
+           || frame->format == AV_PIX_FMT_YUVJ420P
+           || frame->format == AV_PIX_FMT_YUVJ422P
+           || frame->format == AV_PIX_FMT_YUVJ444P;
+}
+
+QSize VideoFrame::size() const
+{
+    if (m_frame) {
+        return QSize(m_frame->width, m_frame->height);
+    }
+    return m_image.size();
+}
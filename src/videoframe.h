@@ -0,0 +1,53 @@
+#ifndef VIDEOFRAME_H
+#define VIDEOFRAME_H
+
+#include <QImage>
+#include <QSize>
+#include <memory>
+#include "yuvconvert.h"
+
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+/**
+ * @brief 解码器交给渲染器的一帧
+ * 既可以是已转换的 RGB 图像，也可以是引用解码输出的 YUV 平面（由着色器完成颜色转换）。
+ * 复制只增加引用计数，不复制像素数据。
+ */
+class VideoFrame
+{
+public:
+    VideoFrame();
+    explicit VideoFrame(const QImage &image);
+
+    // 引用frame的YUV平面（av_frame_ref），失败时返回空帧
+    static VideoFrame fromAVFrame(const AVFrame *frame);
+
+    // 着色器路径支持的像素格式
+    static bool isYuvRenderable(int pixelFormat);
+
+    // 颜色矩阵和范围：未标注色彩空间时高清按BT.709，标清按BT.601
+    static YuvConvert::Matrix colorMatrix(const AVFrame *frame);
+    static bool isFullRange(const AVFrame *frame);
+
+    bool isNull() const { return m_image.isNull() && !m_frame; }
+    bool isYuv() const { return static_cast<bool>(m_frame); }
+
+    QImage image() const { return m_image; }
+    const AVFrame *avFrame() const { return m_frame.get(); }
+    QSize size() const;
+
+    // 解码序号和PTS（跟踪事件用于关联同一帧的各阶段），-1/AV_NOPTS_VALUE 表示未知
+    void setSequence(qint64 frameId, qint64 pts);
+    qint64 frameId() const { return m_frameId; }
+    qint64 pts() const { return m_pts; }
+
+private:
+    QImage m_image;
+    std::shared_ptr<AVFrame> m_frame;
+    qint64 m_frameId;
+    qint64 m_pts;
+};
+
+#endif // VIDEOFRAME_H
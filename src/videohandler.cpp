@@ -1,19 +1,48 @@
 #include "videohandler.h"
+#include "tracing.h"
 #include <QDebug>
 #include <QDateTime>
+#include <cmath>
+
+namespace {
+// 连拍缓冲的内存上限，4K NV12 约可保存 80 帧
+const qint64 kBurstMemoryBudget = 1024LL * 1024 * 1024;
+
+// 未知帧率时按此估算连拍帧数
+const double kFallbackBurstFrameRate = 30.0;
+}
 
 VideoHandler::VideoHandler(QObject *parent)
     : QObject(parent)
     , m_isPlaying(false)
     , m_isRecording(false)
+    , m_isBursting(false)
     , m_isPaused(false)
     , m_videoSize(0, 0)
     , m_frameRate(0.0)
     , m_bitrate(0)
     , m_decoder(nullptr)
+    , m_screenshotWriter(nullptr)
     , m_renderer(nullptr)
-    , m_totalBytes(0)
-    , m_lastBitrateTime(0)
+    , m_statsTimer(nullptr)
+    , m_packetQueueDepth(0)
+    , m_packetQueueHighWaterMark(0)
+    , m_droppedPackets(0)
+    , m_decoderDelayFrames(0)
+    , m_framePoolAvailable(0)
+    , m_framePoolExhausted(0)
+    , m_droppedFrames(0)
+    , m_reconnectCount(0)
+    , m_reconnectTimeMs(-1)
+    , m_rtpLostPackets(0)
+    , m_rtpReorderedPackets(0)
+    , m_rtpLossRate(0.0)
+    , m_replayBufferBytes(0)
+    , m_replayBufferMemory(0)
+    , m_replayBufferDurationMs(0)
+    , m_recordingBytes(0)
+    , m_recordingDurationMs(0)
+    , m_timeToFirstFrameMs(-1)
 {
     // 创建解码器
     m_decoder = new VideoDecoder(this);
@@ -25,7 +54,21 @@ VideoHandler::VideoHandler(QObject *parent)
     connect(m_decoder, &VideoDecoder::errorOccurred, this, &VideoHandler::onDecoderError);
     connect(m_decoder, &VideoDecoder::streamOpened, this, &VideoHandler::onStreamOpened);
     connect(m_decoder, &VideoDecoder::streamClosed, this, &VideoHandler::onStreamClosed);
-    connect(m_decoder, &VideoDecoder::packetReceived, this, &VideoHandler::onPacketReceived);
+    connect(m_decoder, &VideoDecoder::streamStateChanged, this, &VideoHandler::streamStateChanged);
+    connect(m_decoder, &VideoDecoder::streamInfoProbed, this, &VideoHandler::streamInfoProbed);
+    connect(m_decoder, &VideoDecoder::streamInfoRejected, this, &VideoHandler::streamInfoRejected);
+    connect(m_decoder->recorder(), &StreamRecorder::errorOccurred, this, &VideoHandler::onRecordingError);
+
+    // 截图在线程池中编码，完成后通知
+    m_screenshotWriter = new ScreenshotWriter(this);
+    connect(m_screenshotWriter, &ScreenshotWriter::saved, this, &VideoHandler::screenshotSaved);
+    connect(m_screenshotWriter, &ScreenshotWriter::burstSaved, this, &VideoHandler::onBurstSaved);
+    connect(m_screenshotWriter, &ScreenshotWriter::errorOccurred, this, &VideoHandler::errorOccurred);
+
+    // 每秒采样一次流水线统计
+    m_statsTimer = new QTimer(this);
+    m_statsTimer->setInterval(1000);
+    connect(m_statsTimer, &QTimer::timeout, this, &VideoHandler::updateStatistics);
 
     qDebug() << "VideoHandler initialized";
 }
@@ -52,11 +95,109 @@ void VideoHandler::setVideoSource(const QString &source)
     }
 }
 
+void VideoHandler::setIngestProfile(const QString &name)
+{
+    m_decoder->setIngestProfile(name);
+}
+
+void VideoHandler::setCachedStreamInfo(const QVariantMap &info)
+{
+    m_decoder->setCachedStreamInfo(info);
+}
+
+void VideoHandler::setPresentationMode(int mode)
+{
+    int oldMode = m_decoder->presentationMode();
+    m_decoder->setPresentationMode(mode);
+
+    if (m_decoder->presentationMode() != oldMode) {
+        emit presentationModeChanged();
+    }
+}
+
+void VideoHandler::setDecoderThreadCount(int count)
+{
+    if (m_decoder->decoderThreadCount() != count) {
+        m_decoder->setDecoderThreadCount(count);
+        emit decoderThreadingChanged();
+    }
+}
+
+void VideoHandler::setDecoderThreadType(int type)
+{
+    if (m_decoder->decoderThreadType() != type) {
+        m_decoder->setDecoderThreadType(type);
+        emit decoderThreadingChanged();
+    }
+}
+
+void VideoHandler::setPacketQueueCapacity(int capacity)
+{
+    if (capacity > 0 && m_decoder->packetQueueCapacity() != capacity) {
+        m_decoder->setPacketQueueCapacity(capacity);
+        emit packetQueueCapacityChanged();
+    }
+}
+
+void VideoHandler::setFramePoolSize(int size)
+{
+    if (size > 1 && m_decoder->framePoolSize() != size) {
+        m_decoder->setFramePoolSize(size);
+        emit framePoolSizeChanged();
+    }
+}
+
+void VideoHandler::setReplayBufferSeconds(int seconds)
+{
+    if (seconds >= 0 && m_decoder->replayBufferSeconds() != seconds) {
+        m_decoder->setReplayBuffer(seconds, m_decoder->replayBufferBudgetMB());
+        emit replayBufferChanged();
+    }
+}
+
+void VideoHandler::setReplayBufferBudgetMB(int budgetMB)
+{
+    if (budgetMB > 0 && m_decoder->replayBufferBudgetMB() != budgetMB) {
+        m_decoder->setReplayBuffer(m_decoder->replayBufferSeconds(), budgetMB);
+        emit replayBufferChanged();
+    }
+}
+
+void VideoHandler::setRecordingOptions(int segmentSeconds, int syncPolicy)
+{
+    m_decoder->recorder()->setOptions(segmentSeconds, static_cast<AsyncFileWriter::SyncPolicy>(syncPolicy));
+}
+
 void VideoHandler::setRenderer(VideoRenderer *renderer)
 {
     if (m_renderer != renderer) {
+        if (m_renderer) {
+            disconnect(m_renderer, &VideoRenderer::targetSizeChanged, this, nullptr);
+            disconnect(m_renderer, &VideoRenderer::yuvRenderingChanged, this, nullptr);
+            m_renderer->setFrameSlot(nullptr);
+            m_renderer->setMetrics(nullptr);
+        }
+
         m_renderer = renderer;
         qDebug() << "VideoRenderer set to VideoHandler";
+
+        // 渲染线程直接从解码器的帧交接缓冲读取最新帧
+        if (m_renderer) {
+            m_renderer->setFrameSlot(m_decoder->frameSlot());
+            m_renderer->setMetrics(m_decoder->metrics());
+
+            // 解码端直接按渲染器的屏幕尺寸转换，避免转换和绘制全分辨率帧
+            connect(m_renderer, &VideoRenderer::targetSizeChanged, this, [this](const QSize &size) {
+                m_decoder->setOutputSize(size);
+            });
+            m_decoder->setOutputSize(m_renderer->targetSize());
+
+            // 渲染器能在着色器中转换颜色时，解码端跳过CPU颜色转换
+            connect(m_renderer, &VideoRenderer::yuvRenderingChanged, this, [this](bool available) {
+                m_decoder->setYuvOutputEnabled(available);
+            });
+            m_decoder->setYuvOutputEnabled(m_renderer->yuvRendering());
+        }
     }
 }
 
@@ -74,22 +215,23 @@ void VideoHandler::startVideo()
 
     qDebug() << "Starting video from source:" << m_videoSource;
 
-    // 打开视频流
+    m_timeToFirstFrameMs = -1;
+    m_startTimer.start();
+
+    // 异步打开视频流，连接结果通过 streamOpened / errorOccurred 返回
     if (!m_decoder->openStream(m_videoSource)) {
         emit errorOccurred("Failed to open video stream");
         return;
     }
 
-    // 启动解码
-    m_decoder->startDecoding();
-
     m_isPlaying = true;
     if (m_renderer) {
         m_renderer->setPlaying(true);
     }
+    m_statsTimer->start();
     emit isPlayingChanged();
 
-    qDebug() << "Video started successfully";
+    qDebug() << "Video started, connecting...";
 }
 
 void VideoHandler::stopVideo()
@@ -105,9 +247,8 @@ void VideoHandler::stopVideo()
         stopRecording();
     }
 
-    // 停止解码
+    // 停止解码（正在连接时取消打开）
     if (m_decoder) {
-        m_decoder->stopDecoding();
         m_decoder->closeStream();
     }
 
@@ -117,6 +258,9 @@ void VideoHandler::stopVideo()
         m_renderer->clearFrame();
     }
 
+    m_statsTimer->stop();
+    updateStatistics();
+
     m_isPlaying = false;
     emit isPlayingChanged();
 
@@ -177,14 +321,48 @@ void VideoHandler::startRecording(const QString &filePath)
         return;
     }
 
-    // TODO: 实现录像功能
-    // 这需要另一个FFmpeg编码器来编码和保存视频
-    // 暂时先标记为recording状态
+    QString finalPath = filePath;
+    if (finalPath.isEmpty()) {
+        finalPath = QString("recording_%1.mp4")
+                        .arg(QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss"));
+    }
+
+    // 直接封装收到的压缩数据，不重新编码；文件在录像写入线程中打开，失败时通过 onRecordingError 通知
+    m_decoder->startRecording(finalPath);
 
+    m_recordingBytes = 0;
+    m_recordingDurationMs = 0;
     m_isRecording = true;
     emit isRecordingChanged();
-    qDebug() << "Recording started to:" << filePath;
-    qDebug() << "Note: Recording feature not yet implemented";
+    qDebug() << "Recording started to:" << finalPath;
+}
+
+void VideoHandler::saveReplay(const QString &filePath)
+{
+    if (m_isRecording) {
+        emit errorOccurred("Cannot save replay: already recording");
+        return;
+    }
+
+    if (!m_isPlaying) {
+        emit errorOccurred("Cannot save replay: video not playing");
+        return;
+    }
+
+    QString finalPath = filePath;
+    if (finalPath.isEmpty()) {
+        finalPath = QString("replay_%1.mp4")
+                        .arg(QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss"));
+    }
+
+    // 先写入回放缓冲中最近N秒的数据，之后继续实时录制，直到 stopRecording
+    m_decoder->startRecording(finalPath, true);
+
+    m_recordingBytes = 0;
+    m_recordingDurationMs = 0;
+    m_isRecording = true;
+    emit isRecordingChanged();
+    qDebug() << "Saving replay buffer (" << m_replayBufferDurationMs << "ms) and recording to:" << finalPath;
 }
 
 void VideoHandler::stopRecording()
@@ -193,7 +371,8 @@ void VideoHandler::stopRecording()
         return;
     }
 
-    // TODO: 停止录像并保存文件
+    // 写入线程写完队列中剩余的数据后关闭文件，不阻塞GUI线程
+    m_decoder->stopRecording();
 
     m_isRecording = false;
     emit isRecordingChanged();
@@ -207,74 +386,141 @@ void VideoHandler::takeScreenshot(const QString &filePath)
         return;
     }
 
-    if (m_currentFrame.isNull()) {
-        emit errorOccurred("No frame available for screenshot");
-        return;
-    }
-
-    // 保存当前帧为图片
     QString finalPath = filePath;
     if (finalPath.isEmpty()) {
         finalPath = QString("screenshot_%1.png")
                         .arg(QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss"));
     }
 
-    if (m_currentFrame.save(finalPath)) {
-        qDebug() << "Screenshot saved to:" << finalPath;
-    } else {
-        emit errorOccurred("Failed to save screenshot");
-    }
+    // 只取最新解码帧的引用，按原始分辨率转换和编码都在截图线程中完成，不阻塞GUI线程
+    m_screenshotWriter->save(m_decoder->captureFrame(), finalPath);
 }
 
-void VideoHandler::onFrameReady()
+void VideoHandler::startBurst(int seconds, const QString &filePath)
 {
-    if (!m_decoder) {
+    if (!m_isPlaying) {
+        emit errorOccurred("Cannot start burst: video not playing");
         return;
     }
 
-    // 获取最新帧
-    m_currentFrame = m_decoder->getLatestFrame();
+    if (m_isBursting) {
+        emit errorOccurred("Cannot start burst: burst already in progress");
+        return;
+    }
 
-    if (m_currentFrame.isNull()) {
+    // 按当前帧的格式和尺寸预分配，帧数按帧率估算并受内存上限限制
+    const VideoFrame format = m_decoder->captureFrame();
+    const qint64 frameBytes = format.avFrame() ? BurstCapture::frameBytes(format.avFrame()) : 0;
+    if (frameBytes <= 0 || seconds <= 0) {
+        emit errorOccurred("Cannot start burst: no frame available");
+        return;
+    }
+    const double fps = m_frameRate > 0.0 ? m_frameRate : kFallbackBurstFrameRate;
+    const int wanted = static_cast<int>(std::ceil(seconds * fps)) + 1;
+    const int capacity = static_cast<int>(qMin<qint64>(wanted, kBurstMemoryBudget / frameBytes));
+    if (capacity <= 0) {
+        emit errorOccurred("Cannot start burst: frame too large");
         return;
     }
 
-    // 更新渲染器
-    if (m_renderer) {
-        m_renderer->updateFrame(m_currentFrame);
+    QString finalPath = filePath;
+    if (finalPath.isEmpty()) {
+        finalPath = QString("burst_%1.png")
+                        .arg(QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss"));
     }
 
-    // 发送信号
-    emit frameReady(m_currentFrame);
+    // 视频中断时超时结束采集（预分配时间另计）
+    auto burst = std::make_shared<BurstCapture>(seconds * 1000000LL);
+    m_screenshotWriter->saveBurst(burst, format, capacity, finalPath, seconds * 1000 + 5000);
+    m_decoder->setBurstCapture(burst);
 
-    // TODO: 如果正在录制，将帧写入视频文件
+    m_isBursting = true;
+    emit isBurstingChanged();
+    qDebug() << "Burst started:" << seconds << "s," << capacity << "frames,"
+             << capacity * frameBytes / (1024 * 1024) << "MB ->" << finalPath;
 }
 
-void VideoHandler::onPacketReceived(int packetSize)
+void VideoHandler::onBurstSaved(const QString &filePath, int frames)
 {
-    // 使用实际的packet大小计算码率
-    m_totalBytes += packetSize;
+    m_isBursting = false;
+    emit isBurstingChanged();
+    emit burstSaved(filePath, frames);
+}
 
-    qint64 currentTime = QDateTime::currentMSecsSinceEpoch();
+bool VideoHandler::saveTrace(const QString &filePath)
+{
+#ifdef ARDKIT_TRACING
+    QString finalPath = filePath;
+    if (finalPath.isEmpty()) {
+        finalPath = QString("trace_%1.json")
+                        .arg(QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss"));
+    }
 
-    // 初始化时间戳
-    if (m_lastBitrateTime == 0) {
-        m_lastBitrateTime = currentTime;
-        return;
+    // 各线程环形缓冲中最近的事件，可在 chrome://tracing 或 Perfetto 中打开
+    QString error;
+    if (!Tracing::writeChromeTrace(finalPath, &error)) {
+        emit errorOccurred(QString("Failed to save trace: %1").arg(error));
+        return false;
     }
+    return true;
+#else
+    Q_UNUSED(filePath)
+    emit errorOccurred("Tracing is disabled in this build (ARDKIT_TRACING=OFF)");
+    return false;
+#endif
+}
 
-    qint64 elapsedMs = currentTime - m_lastBitrateTime;
+void VideoHandler::onFrameReady(qint64 pts)
+{
+    TRACE_SCOPE_FRAME("VideoHandler::onFrameReady", Tracing::kNoValue, pts);
 
-    // 每秒更新一次码率
-    if (elapsedMs >= 1000) {
-        // 计算比特率（bps = bytes * 8 / seconds）
-        m_bitrate = (m_totalBytes * 8 * 1000) / elapsedMs;
-        emit bitrateChanged();
+    // 解码端合并了通知，这里最多只有一个待处理；帧本身由渲染线程直接读取
+    if (m_renderer) {
+        m_renderer->frameAvailable();
+    }
+
+    if (m_timeToFirstFrameMs < 0 && m_startTimer.isValid()) {
+        m_timeToFirstFrameMs = static_cast<int>(m_startTimer.elapsed());
+        qDebug() << "Time to first frame:" << m_timeToFirstFrameMs << "ms, ingest profile:"
+                 << m_decoder->ingestProfile();
+        emit statisticsChanged();
+    }
+
+    // 发送信号
+    emit frameReady();
+}
 
-        // 重置统计
-        m_totalBytes = 0;
-        m_lastBitrateTime = currentTime;
+void VideoHandler::updateStatistics()
+{
+    m_packetQueueDepth = m_decoder->packetQueueDepth();
+    m_packetQueueHighWaterMark = m_decoder->packetQueueHighWaterMark();
+    m_droppedPackets = static_cast<qint64>(m_decoder->droppedPackets());
+    m_decoderDelayFrames = m_decoder->decoderDelayFrames();
+    m_framePoolAvailable = m_decoder->framePoolAvailable();
+    m_framePoolExhausted = static_cast<qint64>(m_decoder->framePoolExhausted());
+    m_droppedFrames = static_cast<qint64>(m_decoder->droppedFrames());
+    m_reconnectCount = m_decoder->reconnectCount();
+    m_reconnectTimeMs = m_decoder->lastReconnectTimeMs();
+    m_transport = m_decoder->activeTransport();
+    m_rtpLostPackets = static_cast<qint64>(m_decoder->rtpLostPackets());
+    m_rtpReorderedPackets = static_cast<qint64>(m_decoder->rtpReorderedPackets());
+    m_rtpLossRate = m_decoder->rtpLossRate();
+    m_latency = m_decoder->latencyStats();
+    m_replayBufferBytes = m_decoder->replayBufferBytes();
+    m_replayBufferMemory = m_decoder->replayBufferMemory();
+    m_replayBufferDurationMs = m_decoder->replayBufferDurationMs();
+    m_recordingBytes = m_decoder->recorder()->bytesWritten();
+    m_recordingDurationMs = m_decoder->recorder()->durationMs();
+
+    // 流水线指标每周期只采样一次，码率取本周期收到的字节数
+    m_metrics = m_decoder->metrics()->snapshot();
+    const qint64 bitrate = m_metrics.value("bitrate").toLongLong();
+    if (bitrate != m_bitrate) {
+        m_bitrate = bitrate;
+        emit bitrateChanged();
     }
+
+    emit statisticsChanged();
 }
 
 void VideoHandler::onDecoderError(const QString &error)
@@ -286,8 +532,24 @@ void VideoHandler::onDecoderError(const QString &error)
     stopVideo();
 }
 
+void VideoHandler::onRecordingError(const QString &error)
+{
+    // 录像失败不影响视频播放
+    emit errorOccurred(error);
+
+    if (m_isRecording) {
+        m_isRecording = false;
+        emit isRecordingChanged();
+    }
+}
+
 void VideoHandler::onStreamOpened(int width, int height, double fps)
 {
+    // 打开完成前已停止，忽略排队中的通知
+    if (!m_isPlaying) {
+        return;
+    }
+
     qDebug() << "Stream opened:" << width << "x" << height << "@" << fps << "fps";
 
     m_videoSize = QSize(width, height);
@@ -296,10 +558,8 @@ void VideoHandler::onStreamOpened(int width, int height, double fps)
     m_frameRate = fps;
     emit frameRateChanged();
 
-    // 重置码率统计
-    m_totalBytes = 0;
+    // 重置码率统计（下一个统计周期起按新流计算）
     m_bitrate = 0;
-    m_lastBitrateTime = QDateTime::currentMSecsSinceEpoch();
     emit bitrateChanged();
 }
 
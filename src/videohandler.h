@@ -4,6 +4,10 @@
 #include <QObject>
 #include <QString>
 #include <QImage>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QVariantMap>
+#include "screenshotwriter.h"
 #include "videodecoder.h"
 #include "videorenderer.h"
 
@@ -15,12 +19,42 @@ class VideoHandler : public QObject
 {
     Q_OBJECT
     Q_PROPERTY(bool isPlaying READ isPlaying NOTIFY isPlayingChanged)
+    Q_PROPERTY(int streamState READ streamState NOTIFY streamStateChanged)
     Q_PROPERTY(bool isRecording READ isRecording NOTIFY isRecordingChanged)
+    Q_PROPERTY(bool isBursting READ isBursting NOTIFY isBurstingChanged)
     Q_PROPERTY(bool isPaused READ isPaused NOTIFY isPausedChanged)
     Q_PROPERTY(QString videoSource READ videoSource WRITE setVideoSource NOTIFY videoSourceChanged)
     Q_PROPERTY(QSize videoSize READ videoSize NOTIFY videoSizeChanged)
     Q_PROPERTY(double frameRate READ frameRate NOTIFY frameRateChanged)
     Q_PROPERTY(qint64 bitrate READ bitrate NOTIFY bitrateChanged)
+    Q_PROPERTY(int presentationMode READ presentationMode WRITE setPresentationMode NOTIFY presentationModeChanged)
+    Q_PROPERTY(int decoderThreadCount READ decoderThreadCount WRITE setDecoderThreadCount NOTIFY decoderThreadingChanged)
+    Q_PROPERTY(int decoderThreadType READ decoderThreadType WRITE setDecoderThreadType NOTIFY decoderThreadingChanged)
+    Q_PROPERTY(int packetQueueCapacity READ packetQueueCapacity WRITE setPacketQueueCapacity NOTIFY packetQueueCapacityChanged)
+    Q_PROPERTY(int packetQueueDepth READ packetQueueDepth NOTIFY statisticsChanged)
+    Q_PROPERTY(int packetQueueHighWaterMark READ packetQueueHighWaterMark NOTIFY statisticsChanged)
+    Q_PROPERTY(qint64 droppedPackets READ droppedPackets NOTIFY statisticsChanged)
+    Q_PROPERTY(int decoderDelayFrames READ decoderDelayFrames NOTIFY statisticsChanged)
+    Q_PROPERTY(int framePoolSize READ framePoolSize WRITE setFramePoolSize NOTIFY framePoolSizeChanged)
+    Q_PROPERTY(int framePoolAvailable READ framePoolAvailable NOTIFY statisticsChanged)
+    Q_PROPERTY(qint64 framePoolExhausted READ framePoolExhausted NOTIFY statisticsChanged)
+    Q_PROPERTY(qint64 droppedFrames READ droppedFrames NOTIFY statisticsChanged)
+    Q_PROPERTY(int reconnectCount READ reconnectCount NOTIFY statisticsChanged)
+    Q_PROPERTY(int reconnectTimeMs READ reconnectTimeMs NOTIFY statisticsChanged)
+    Q_PROPERTY(int timeToFirstFrameMs READ timeToFirstFrameMs NOTIFY statisticsChanged)
+    Q_PROPERTY(QString transport READ transport NOTIFY statisticsChanged)
+    Q_PROPERTY(qint64 rtpLostPackets READ rtpLostPackets NOTIFY statisticsChanged)
+    Q_PROPERTY(qint64 rtpReorderedPackets READ rtpReorderedPackets NOTIFY statisticsChanged)
+    Q_PROPERTY(double rtpLossRate READ rtpLossRate NOTIFY statisticsChanged)
+    Q_PROPERTY(QVariantMap latency READ latency NOTIFY statisticsChanged)
+    Q_PROPERTY(QVariantMap metrics READ metrics NOTIFY statisticsChanged)
+    Q_PROPERTY(int replayBufferSeconds READ replayBufferSeconds WRITE setReplayBufferSeconds NOTIFY replayBufferChanged)
+    Q_PROPERTY(int replayBufferBudgetMB READ replayBufferBudgetMB WRITE setReplayBufferBudgetMB NOTIFY replayBufferChanged)
+    Q_PROPERTY(qint64 replayBufferBytes READ replayBufferBytes NOTIFY statisticsChanged)
+    Q_PROPERTY(qint64 replayBufferMemory READ replayBufferMemory NOTIFY statisticsChanged)
+    Q_PROPERTY(int replayBufferDurationMs READ replayBufferDurationMs NOTIFY statisticsChanged)
+    Q_PROPERTY(qint64 recordingBytes READ recordingBytes NOTIFY statisticsChanged)
+    Q_PROPERTY(qint64 recordingDurationMs READ recordingDurationMs NOTIFY statisticsChanged)
     Q_PROPERTY(VideoRenderer* renderer READ renderer CONSTANT)
 
 public:
@@ -29,14 +63,60 @@ public:
 
     bool isPlaying() const { return m_isPlaying; }
     bool isRecording() const { return m_isRecording; }
+    bool isBursting() const { return m_isBursting; }
     bool isPaused() const { return m_isPaused; }
+    int streamState() const { return m_decoder->streamState(); }  // VideoDecoder::StreamState
     QString videoSource() const { return m_videoSource; }
     QSize videoSize() const { return m_videoSize; }
     double frameRate() const { return m_frameRate; }
     qint64 bitrate() const { return m_bitrate; }
     VideoRenderer* renderer() const { return m_renderer; }
+    int presentationMode() const { return m_decoder->presentationMode(); }
+    int decoderThreadCount() const { return m_decoder->decoderThreadCount(); }
+    int decoderThreadType() const { return m_decoder->decoderThreadType(); }
+    int packetQueueCapacity() const { return m_decoder->packetQueueCapacity(); }
+    int packetQueueDepth() const { return m_packetQueueDepth; }
+    int packetQueueHighWaterMark() const { return m_packetQueueHighWaterMark; }
+    qint64 droppedPackets() const { return m_droppedPackets; }
+    int decoderDelayFrames() const { return m_decoderDelayFrames; }
+    int framePoolSize() const { return m_decoder->framePoolSize(); }
+    int framePoolAvailable() const { return m_framePoolAvailable; }
+    qint64 framePoolExhausted() const { return m_framePoolExhausted; }
+    qint64 droppedFrames() const { return m_droppedFrames; }
+    int reconnectCount() const { return m_reconnectCount; }
+    int reconnectTimeMs() const { return m_reconnectTimeMs; }
+    int timeToFirstFrameMs() const { return m_timeToFirstFrameMs; }  // 启动到首帧交给渲染器的耗时，-1表示尚无
+    QString transport() const { return m_transport; }
+    qint64 rtpLostPackets() const { return m_rtpLostPackets; }
+    qint64 rtpReorderedPackets() const { return m_rtpReorderedPackets; }
+    double rtpLossRate() const { return m_rtpLossRate; }
+    QVariantMap latency() const { return m_latency; }  // 端到端延迟分位数，见 LatencyTracker::snapshot
+    QVariantMap metrics() const { return m_metrics; }  // 流水线指标快照，见 PipelineMetrics::snapshot
+    int replayBufferSeconds() const { return m_decoder->replayBufferSeconds(); }
+    int replayBufferBudgetMB() const { return m_decoder->replayBufferBudgetMB(); }
+    qint64 replayBufferBytes() const { return m_replayBufferBytes; }
+    qint64 replayBufferMemory() const { return m_replayBufferMemory; }
+    int replayBufferDurationMs() const { return m_replayBufferDurationMs; }
+    qint64 recordingBytes() const { return m_recordingBytes; }
+    qint64 recordingDurationMs() const { return m_recordingDurationMs; }
 
     void setVideoSource(const QString &source);
+    void setPresentationMode(int mode);
+    void setDecoderThreadCount(int count);
+    void setDecoderThreadType(int type);
+    void setPacketQueueCapacity(int capacity);
+    void setFramePoolSize(int size);
+    void setReplayBufferSeconds(int seconds);
+    void setReplayBufferBudgetMB(int budgetMB);
+
+    // 当前视频源的接入配置（名称见 IngestProfile），在 startVideo 之前设置
+    void setIngestProfile(const QString &name);
+
+    // 当前视频源缓存的流参数（由配置管理器提供），在 startVideo 之前设置
+    void setCachedStreamInfo(const QVariantMap &info);
+
+    // 录像分段时长（秒，0表示不分段）和同步策略（见 AsyncFileWriter::SyncPolicy），下一次录像时生效
+    void setRecordingOptions(int segmentSeconds, int syncPolicy);
 
 public slots:
     void setRenderer(VideoRenderer *renderer);
@@ -46,29 +126,47 @@ public slots:
     void resumeVideo();
     void startRecording(const QString &filePath);
     void stopRecording();
+    void saveReplay(const QString &filePath);
     void takeScreenshot(const QString &filePath);
+    void startBurst(int seconds, const QString &filePath);
+    bool saveTrace(const QString &filePath);
 
 signals:
     void isPlayingChanged();
+    void streamStateChanged();
     void isRecordingChanged();
+    void isBurstingChanged();
     void isPausedChanged();
     void videoSourceChanged();
     void videoSizeChanged();
     void frameRateChanged();
     void bitrateChanged();
-    void frameReady(const QImage &frame);
+    void presentationModeChanged();
+    void decoderThreadingChanged();
+    void packetQueueCapacityChanged();
+    void framePoolSizeChanged();
+    void replayBufferChanged();
+    void statisticsChanged();
+    void frameReady();
     void errorOccurred(const QString &error);
+    void streamInfoProbed(const QString &url, const QVariantMap &info);
+    void streamInfoRejected(const QString &url);
+    void screenshotSaved(const QString &filePath);
+    void burstSaved(const QString &filePath, int frames);
 
 private slots:
-    void onFrameReady();
+    void onFrameReady(qint64 pts);
     void onDecoderError(const QString &error);
     void onStreamOpened(int width, int height, double fps);
     void onStreamClosed();
-    void onPacketReceived(int packetSize);
+    void onRecordingError(const QString &error);
+    void onBurstSaved(const QString &filePath, int frames);
+    void updateStatistics();
 
 private:
     bool m_isPlaying;
     bool m_isRecording;
+    bool m_isBursting;
     bool m_isPaused;
     QString m_videoSource;
     QSize m_videoSize;
@@ -78,15 +176,48 @@ private:
     // 视频解码器
     VideoDecoder *m_decoder;
 
+    // 截图编码（线程池）
+    ScreenshotWriter *m_screenshotWriter;
+
     // 视频渲染器
     VideoRenderer *m_renderer;
 
-    // 当前帧（用于截图和录制）
-    QImage m_currentFrame;
+    // 流水线统计（定时采样，避免逐包跨线程通知）
+    QTimer *m_statsTimer;
+    int m_packetQueueDepth;
+    int m_packetQueueHighWaterMark;
+    qint64 m_droppedPackets;
+    int m_decoderDelayFrames;
+    int m_framePoolAvailable;
+    qint64 m_framePoolExhausted;
+    qint64 m_droppedFrames;
+    int m_reconnectCount;
+    int m_reconnectTimeMs;
+
+    // RTSP传输统计
+    QString m_transport;
+    qint64 m_rtpLostPackets;
+    qint64 m_rtpReorderedPackets;
+    double m_rtpLossRate;
+
+    // 端到端延迟（发送端嵌入时间戳SEI时有效）
+    QVariantMap m_latency;
+
+    // 流水线指标（每个统计周期采样一次，码率也由此得出）
+    QVariantMap m_metrics;
+
+    // 回放缓冲（最近N秒的压缩数据）
+    qint64 m_replayBufferBytes;
+    qint64 m_replayBufferMemory;
+    int m_replayBufferDurationMs;
+
+    // 当前录像已写入的数据量和时长
+    qint64 m_recordingBytes;
+    qint64 m_recordingDurationMs;
 
-    // 码率统计
-    qint64 m_totalBytes;
-    qint64 m_lastBitrateTime;
+    // 启动到首帧的耗时
+    QElapsedTimer m_startTimer;
+    int m_timeToFirstFrameMs;
 };
 
 #endif // VIDEOHANDLER_H
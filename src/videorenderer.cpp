@@ -1,13 +1,38 @@
 #include "videorenderer.h"
 #include <QDebug>
+#include <QQuickWindow>
+#include <QSGImageNode>
+#include <QSGRectangleNode>
+#include <QSGRendererInterface>
+#include "rgbvideotexture.h"
+#include "tracing.h"
+#include "yuvvideonode.h"
+
+namespace {
+// 尺寸稳定该时长后才通知解码端
+const int kResizeDebounceMs = 200;
+
+// 渲染统计输出间隔
+const qint64 kRenderStatsIntervalMs = 5000;
+}
 
 VideoRenderer::VideoRenderer(QQuickItem *parent)
-    : QQuickPaintedItem(parent)
+    : QQuickItem(parent)
+    , m_frameSlot(nullptr)
+    , m_metrics(nullptr)
     , m_playing(false)
     , m_hasFrame(false)
+    , m_contentYuv(false)
+    , m_yuvRendering(false)
+    , m_statsSyncTimeNs(0)
+    , m_statsUploads(0)
+    , m_statsUpdates(0)
 {
-    setRenderTarget(QQuickPaintedItem::FramebufferObject);
-    setAntialiasing(true);
+    setFlag(ItemHasContents, true);
+
+    m_resizeTimer.setSingleShot(true);
+    m_resizeTimer.setInterval(kResizeDebounceMs);
+    connect(&m_resizeTimer, &QTimer::timeout, this, &VideoRenderer::updateTargetSize);
 
     qDebug() << "VideoRenderer created";
 }
@@ -17,46 +42,170 @@ VideoRenderer::~VideoRenderer()
     qDebug() << "VideoRenderer destroyed";
 }
 
-void VideoRenderer::paint(QPainter *painter)
+QSGNode *VideoRenderer::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data)
 {
-    QMutexLocker locker(&m_frameMutex);
+    Q_UNUSED(data)
+    TRACE_SCOPE_VAR(paintTrace, "VideoRenderer::updatePaintNode");
 
-    if (!m_hasFrame || m_currentFrame.isNull()) {
-        // 绘制黑色背景
-        painter->fillRect(boundingRect(), Qt::black);
-        return;
+    QElapsedTimer syncTimer;
+    syncTimer.start();
+
+    // 根节点为黑色背景，视频纹理节点作为其子节点，黑边即背景露出的部分
+    QSGRectangleNode *background = static_cast<QSGRectangleNode *>(oldNode);
+    if (!background) {
+        background = window()->createRectangleNode();
+        background->setColor(Qt::black);
+    }
+    background->setRect(boundingRect());
+
+    // 子节点为RGB纹理节点（QSGImageNode）或YUV着色器节点（YuvVideoNode）
+    QSGNode *content = background->firstChild();
+
+    // 从交接缓冲取最新帧，不加锁；中间被覆盖的帧已计入丢帧
+    bool newFrame = false;
+    if (m_frameSlot && m_playing) {
+        VideoFrame latest;
+        if (m_frameSlot->acquire(latest)) {
+            m_displayFrame = latest;
+            m_hasFrame = true;
+            newFrame = true;
+            TRACE_SET_FRAME(paintTrace, latest.frameId(), latest.pts());
+
+            if (m_metrics) {
+                m_metrics->add(PipelineMetrics::FramesRendered);
+                if (m_renderIntervalTimer.isValid()) {
+                    m_metrics->record(PipelineMetrics::RenderInterval,
+                                      static_cast<quint64>(m_renderIntervalTimer.nsecsElapsed() / 1000));
+                }
+                m_renderIntervalTimer.start();
+            }
+        }
+    } else {
+        // 停止后重新开始计算间隔，不把停播时间计入
+        m_renderIntervalTimer.invalidate();
+    }
+
+    // 有新帧、帧类型变化或场景图重建（内容节点丢失）时才上传纹理
+    VideoFrame frame;
+    const bool hasFrame = m_hasFrame && !m_displayFrame.isNull();
+    const bool frameYuv = m_displayFrame.isYuv();
+    if (hasFrame && (newFrame || !content || frameYuv != m_contentYuv)) {
+        frame = m_displayFrame;
     }
 
-    // 计算缩放后的矩形（保持宽高比）
-    QRectF targetRect = boundingRect();
-    QSizeF imageSize = m_currentFrame.size();
+    // 着色器不可用时YUV帧无法显示（解码端随后会切换回RGB输出）
+    if (!hasFrame || (frameYuv && !m_yuvRendering)) {
+        if (content) {
+            background->removeChildNode(content);
+            delete content;
+        }
+        m_textureSize = QSize();
+        return background;
+    }
 
-    qreal scaleX = targetRect.width() / imageSize.width();
-    qreal scaleY = targetRect.height() / imageSize.height();
-    qreal scale = qMin(scaleX, scaleY);
+    if (content && frameYuv != m_contentYuv) {
+        background->removeChildNode(content);
+        delete content;
+        content = nullptr;
+    }
 
-    qreal scaledWidth = imageSize.width() * scale;
-    qreal scaledHeight = imageSize.height() * scale;
+    if (!frame.isNull()) {
+        if (frameYuv) {
+#ifdef ARDKIT_YUV_SHADERS
+            // 平面直接作为纹理上传，颜色转换和缩放在着色器中完成
+            YuvVideoNode *yuvNode = static_cast<YuvVideoNode *>(content);
+            if (!yuvNode) {
+                yuvNode = new YuvVideoNode;
+                background->appendChildNode(yuvNode);
+                content = yuvNode;
+            }
+            yuvNode->setFrame(frame);
+            m_textureSize = frame.size();
+            m_statsUploads++;
+#endif
+        } else {
+            QSGImageNode *imageNode = static_cast<QSGImageNode *>(content);
+            if (!imageNode) {
+                imageNode = window()->createImageNode();
+                imageNode->setOwnsTexture(true);
+                imageNode->setFiltering(QSGTexture::Linear);
+                background->appendChildNode(imageNode);
+                content = imageNode;
+            }
+#ifdef ARDKIT_RHI_TEXTURES
+            if (QSGRendererInterface::isApiRhiBased(QQuickWindow::graphicsApi())) {
+                // 节点持有同一个纹理，每帧只上传像素数据（尺寸变化时纹理内部重建）
+                RgbVideoTexture *texture = static_cast<RgbVideoTexture *>(imageNode->texture());
+                if (!texture) {
+                    texture = new RgbVideoTexture;
+                    imageNode->setTexture(texture);
+                }
+                texture->setImage(frame.image());
+                imageNode->markDirty(QSGNode::DirtyMaterial);
+                m_textureSize = frame.size();
+                m_statsUploads++;
+            } else
+#endif
+            {
+                // 软件后端（或无法直接上传的旧版本Qt）：每帧创建纹理，节点拥有纹理，替换时旧纹理随之释放
+                QSGTexture *texture = window()->createTextureFromImage(frame.image(), QQuickWindow::TextureIsOpaque);
+                if (texture) {
+                    imageNode->setTexture(texture);
+                    m_textureSize = frame.size();
+                    m_statsUploads++;
+                }
+            }
+        }
+        m_contentYuv = frameYuv;
+    }
 
-    qreal x = (targetRect.width() - scaledWidth) / 2.0;
-    qreal y = (targetRect.height() - scaledHeight) / 2.0;
+    if (content && !m_textureSize.isEmpty()) {
+        // 保持宽高比，居中显示
+        QSizeF scaled = QSizeF(m_textureSize).scaled(size(), Qt::KeepAspectRatio);
+        QRectF rect((width() - scaled.width()) / 2.0,
+                    (height() - scaled.height()) / 2.0,
+                    scaled.width(), scaled.height());
+        if (m_contentYuv) {
+#ifdef ARDKIT_YUV_SHADERS
+            static_cast<YuvVideoNode *>(content)->setRect(rect);
+#endif
+        } else {
+            QSGImageNode *imageNode = static_cast<QSGImageNode *>(content);
+            imageNode->setRect(rect);
+            imageNode->setSourceRect(QRectF(QPointF(0, 0), QSizeF(m_textureSize)));
+        }
+    }
 
-    QRectF drawRect(x, y, scaledWidth, scaledHeight);
+    m_statsSyncTimeNs += syncTimer.nsecsElapsed();
+    m_statsUpdates++;
+    if (!m_statsTimer.isValid()) {
+        m_statsTimer.start();
+    } else if (m_statsTimer.elapsed() >= kRenderStatsIntervalMs) {
+        qDebug() << "Render stats:"
+                 << m_statsUpdates << "updates,"
+                 << m_statsUploads << "uploads,"
+                 << m_statsSyncTimeNs / 1000000.0 / m_statsUpdates << "ms/update sync,"
+                 << "texture" << m_textureSize << (m_contentYuv ? "(yuv)" : "(rgb)");
+        m_statsTimer.restart();
+        m_statsSyncTimeNs = 0;
+        m_statsUploads = 0;
+        m_statsUpdates = 0;
+    }
 
-    // 填充黑色背景
-    painter->fillRect(targetRect, Qt::black);
+    return background;
+}
 
-    // 绘制视频帧（保持宽高比，居中显示）
-    painter->setRenderHint(QPainter::SmoothPixmapTransform, true);
-    painter->drawImage(drawRect, m_currentFrame);
+void VideoRenderer::setFrameSlot(FrameSlot *slot)
+{
+    m_frameSlot = slot;
+    update();
 }
 
-void VideoRenderer::updateFrame(const QImage &frame)
+void VideoRenderer::frameAvailable()
 {
-    {
-        QMutexLocker locker(&m_frameMutex);
-        m_currentFrame = frame;
-        m_hasFrame = true;
+    // 先清除待处理标志，之后发布的帧会再次通知
+    if (m_frameSlot) {
+        m_frameSlot->clearWakePending();
     }
 
     // 触发重绘
@@ -65,11 +214,8 @@ void VideoRenderer::updateFrame(const QImage &frame)
 
 void VideoRenderer::clearFrame()
 {
-    {
-        QMutexLocker locker(&m_frameMutex);
-        m_currentFrame = QImage();
-        m_hasFrame = false;
-    }
+    m_displayFrame = VideoFrame();
+    m_hasFrame = false;
 
     update();
 }
@@ -85,3 +231,68 @@ void VideoRenderer::setPlaying(bool playing)
         }
     }
 }
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+void VideoRenderer::geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry)
+{
+    QQuickItem::geometryChange(newGeometry, oldGeometry);
+#else
+void VideoRenderer::geometryChanged(const QRectF &newGeometry, const QRectF &oldGeometry)
+{
+    QQuickItem::geometryChanged(newGeometry, oldGeometry);
+#endif
+
+    if (newGeometry.size() != oldGeometry.size()) {
+        m_resizeTimer.start();
+        update();
+    }
+}
+
+void VideoRenderer::itemChange(ItemChange change, const ItemChangeData &value)
+{
+    QQuickItem::itemChange(change, value);
+
+    // 移动到其他窗口或屏幕缩放比例变化时，物理像素尺寸也会变化
+    if (change == ItemSceneChange || change == ItemDevicePixelRatioHasChanged) {
+        m_resizeTimer.start();
+    }
+
+    if (change == ItemSceneChange) {
+        updateYuvRendering();
+    }
+}
+
+void VideoRenderer::updateYuvRendering()
+{
+    // 只有基于RHI的场景图后端才能使用自定义着色器，软件后端回退到CPU颜色转换
+    bool available = false;
+#ifdef ARDKIT_YUV_SHADERS
+    available = window() && QSGRendererInterface::isApiRhiBased(QQuickWindow::graphicsApi());
+
+    // ARDKIT_YUV_SHADER=0 强制使用CPU颜色转换，便于对比
+    if (qEnvironmentVariableIsSet("ARDKIT_YUV_SHADER") && qEnvironmentVariableIntValue("ARDKIT_YUV_SHADER") == 0) {
+        available = false;
+    }
+#endif
+
+    if (m_yuvRendering != available) {
+        m_yuvRendering = available;
+        qDebug() << "YUV shader rendering:" << (available ? "available" : "unavailable");
+        emit yuvRenderingChanged(available);
+    }
+}
+
+void VideoRenderer::updateTargetSize()
+{
+    const qreal dpr = window() ? window()->effectiveDevicePixelRatio() : 1.0;
+    QSize size(qRound(width() * dpr), qRound(height() * dpr));
+    if (size.width() <= 0 || size.height() <= 0) {
+        return;
+    }
+
+    if (size != m_targetSize) {
+        m_targetSize = size;
+        qDebug() << "Video target size:" << size << "dpr:" << dpr;
+        emit targetSizeChanged(size);
+    }
+}
@@ -1,40 +1,96 @@
 #ifndef VIDEORENDERER_H
 #define VIDEORENDERER_H
 
-#include <QQuickPaintedItem>
+#include <QQuickItem>
+#include <QElapsedTimer>
 #include <QImage>
-#include <QPainter>
-#include <QMutex>
+#include <QSize>
+#include <QTimer>
+#include "frameslot.h"
+#include "pipelinemetrics.h"
 
-class VideoRenderer : public QQuickPaintedItem
+/**
+ * @brief 视频渲染器
+ * 基于场景图：每帧作为纹理上传一次，由 QSGImageNode 绘制，黑边由矩形节点完成。
+ * 基于RHI的后端复用同一个纹理（尺寸变化时才重建），帧未变化时（仅缩放窗口或叠加层刷新）不上传；
+ * 软件渲染后端每帧创建纹理。
+ * 编译了YUV着色器且后端基于RHI时，YUV帧的各平面直接上传，由着色器完成颜色转换和缩放。
+ */
+class VideoRenderer : public QQuickItem
 {
     Q_OBJECT
     Q_PROPERTY(bool playing READ isPlaying WRITE setPlaying NOTIFY playingChanged)
+    Q_PROPERTY(QSize targetSize READ targetSize NOTIFY targetSizeChanged)
+    Q_PROPERTY(bool yuvRendering READ yuvRendering NOTIFY yuvRenderingChanged)
 
 public:
     explicit VideoRenderer(QQuickItem *parent = nullptr);
     ~VideoRenderer() override;
 
-    void paint(QPainter *painter) override;
-
     bool isPlaying() const { return m_playing; }
     void setPlaying(bool playing);
 
+    // 画面在屏幕上的物理像素尺寸，解码端按此尺寸缩放
+    QSize targetSize() const { return m_targetSize; }
+
+    // 是否可以直接显示YUV帧（运行时根据场景图后端决定）
+    bool yuvRendering() const { return m_yuvRendering; }
+
+    // 解码器的帧交接缓冲，渲染线程在同步阶段从中取最新帧
+    void setFrameSlot(FrameSlot *slot);
+
+    // 流水线指标，渲染线程记录新帧间隔和渲染帧数
+    void setMetrics(PipelineMetrics *metrics) { m_metrics = metrics; }
+
 public slots:
-    // 更新视频帧
-    void updateFrame(const QImage &frame);
+    // 有新帧可用（合并后的通知），请求重绘
+    void frameAvailable();
 
     // 清除画面
     void clearFrame();
 
 signals:
     void playingChanged();
+    void targetSizeChanged(const QSize &size);
+    void yuvRenderingChanged(bool available);
+
+protected:
+    QSGNode *updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data) override;
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    void geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry) override;
+#else
+    void geometryChanged(const QRectF &newGeometry, const QRectF &oldGeometry) override;
+#endif
+    void itemChange(ItemChange change, const ItemChangeData &value) override;
+
+private slots:
+    void updateTargetSize();
 
 private:
-    QMutex m_frameMutex;
-    QImage m_currentFrame;
+    // 场景图同步阶段GUI线程被阻塞，以下成员无需加锁
+    FrameSlot *m_frameSlot;
+    PipelineMetrics *m_metrics;
+    QElapsedTimer m_renderIntervalTimer;
+    VideoFrame m_displayFrame;
     bool m_playing;
     bool m_hasFrame;
+
+    // 当前纹理对应的帧尺寸，用于计算显示区域
+    QSize m_textureSize;
+    bool m_contentYuv;       // 内容节点类型（仅渲染线程在同步阶段访问）
+    bool m_yuvRendering;
+
+    // 尺寸变化去抖，拖动窗口时不会反复重建解码端的缩放器
+    QTimer m_resizeTimer;
+    QSize m_targetSize;
+
+    // 渲染统计（场景图同步阶段耗时）
+    QElapsedTimer m_statsTimer;
+    qint64 m_statsSyncTimeNs;
+    int m_statsUploads;
+    int m_statsUpdates;
+
+    void updateYuvRendering();
 };
 
 #endif // VIDEORENDERER_H
@@ -0,0 +1,365 @@
+#include "yuvconvert.h"
+
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define YUVCONVERT_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64) || (defined(__ARM_NEON) && defined(__arm__))
+#define YUVCONVERT_NEON 1
+#include <arm_neon.h>
+#endif
+
+// GCC/Clang 需要为单个函数打开 AVX2 指令集；MSVC 不需要
+#if defined(YUVCONVERT_X86) && (defined(__GNUC__) || defined(__clang__))
+#define YUVCONVERT_TARGET_AVX2 __attribute__((target("avx2")))
+#define YUVCONVERT_TARGET_SSE2 __attribute__((target("sse2")))
+#else
+#define YUVCONVERT_TARGET_AVX2
+#define YUVCONVERT_TARGET_SSE2
+#endif
+
+namespace YuvConvert {
+
+namespace {
+
+inline int saturate16(int value)
+{
+    return value < -32768 ? -32768 : (value > 32767 ? 32767 : value);
+}
+
+inline uint32_t clamp255(int value)
+{
+    return value < 0 ? 0u : (value > 255 ? 255u : static_cast<uint32_t>(value));
+}
+
+// 单像素转换，与SIMD实现使用完全相同的定点运算
+inline uint32_t convertPixel(int y, int u, int v, const Coefficients &c)
+{
+    int luma = static_cast<int>((static_cast<uint32_t>(y) * 257u * static_cast<uint16_t>(c.yGain)) >> 16);
+    luma = saturate16(luma + c.yBias);
+    u -= 128;
+    v -= 128;
+
+    uint32_t r = clamp255(saturate16(luma + c.vToR * v) >> 6);
+    uint32_t g = clamp255(saturate16(luma - (c.uToG * u + c.vToG * v)) >> 6);
+    uint32_t b = clamp255(saturate16(luma + c.uToB * u) >> 6);
+
+    return 0xFF000000u | (r << 16) | (g << 8) | b;
+}
+
+inline const uint8_t *chromaRow(const Source &src, int plane, int row)
+{
+    int chromaRowIndex = src.layout == LayoutI422 ? row : (row >> 1);
+    return src.data[plane] + static_cast<intptr_t>(chromaRowIndex) * src.linesize[plane];
+}
+
+// 从 x 开始用标量处理一行剩余像素
+inline void convertRowTail(const Source &src, const Coefficients &coeffs,
+                           const uint8_t *yRow, const uint8_t *uRow, const uint8_t *vRow,
+                           uint32_t *dstRow, int x)
+{
+    if (src.layout == LayoutNV12) {
+        for (; x < src.width; ++x) {
+            const uint8_t *uv = uRow + (x >> 1) * 2;
+            dstRow[x] = convertPixel(yRow[x], uv[0], uv[1], coeffs);
+        }
+    } else {
+        for (; x < src.width; ++x) {
+            dstRow[x] = convertPixel(yRow[x], uRow[x >> 1], vRow[x >> 1], coeffs);
+        }
+    }
+}
+
+void convertRowsScalar(const Source &src, const Coefficients &coeffs,
+                       uint8_t *dst, int dstLinesize, int rowStart, int rowEnd)
+{
+    for (int row = rowStart; row < rowEnd; ++row) {
+        const uint8_t *yRow = src.data[0] + static_cast<intptr_t>(row) * src.linesize[0];
+        const uint8_t *uRow = chromaRow(src, 1, row);
+        const uint8_t *vRow = src.layout == LayoutNV12 ? nullptr : chromaRow(src, 2, row);
+        uint32_t *dstRow = reinterpret_cast<uint32_t *>(dst + static_cast<intptr_t>(row) * dstLinesize);
+        convertRowTail(src, coeffs, yRow, uRow, vRow, dstRow, 0);
+    }
+}
+
+#ifdef YUVCONVERT_X86
+
+// 8个像素：Y为 Y*257（16位），U/V 为减去128后的16位有符号数
+YUVCONVERT_TARGET_SSE2
+inline void storePixelsSSE2(__m128i y, __m128i u, __m128i v, const Coefficients &c, uint8_t *dst)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i max = _mm_set1_epi16(255);
+
+    __m128i luma = _mm_mulhi_epu16(y, _mm_set1_epi16(c.yGain));
+    luma = _mm_adds_epi16(luma, _mm_set1_epi16(c.yBias));
+
+    __m128i r = _mm_adds_epi16(luma, _mm_mullo_epi16(v, _mm_set1_epi16(c.vToR)));
+    __m128i g = _mm_subs_epi16(luma, _mm_add_epi16(_mm_mullo_epi16(u, _mm_set1_epi16(c.uToG)),
+                                                   _mm_mullo_epi16(v, _mm_set1_epi16(c.vToG))));
+    __m128i b = _mm_adds_epi16(luma, _mm_mullo_epi16(u, _mm_set1_epi16(c.uToB)));
+
+    r = _mm_min_epi16(_mm_max_epi16(_mm_srai_epi16(r, 6), zero), max);
+    g = _mm_min_epi16(_mm_max_epi16(_mm_srai_epi16(g, 6), zero), max);
+    b = _mm_min_epi16(_mm_max_epi16(_mm_srai_epi16(b, 6), zero), max);
+
+    // 组合为 B G R A 字节序（小端下即 0xAARRGGBB）
+    __m128i bg = _mm_or_si128(b, _mm_slli_epi16(g, 8));
+    __m128i ra = _mm_or_si128(r, _mm_set1_epi16(static_cast<short>(0xFF00)));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), _mm_unpacklo_epi16(bg, ra));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 16), _mm_unpackhi_epi16(bg, ra));
+}
+
+YUVCONVERT_TARGET_SSE2
+void convertRowsSSE2(const Source &src, const Coefficients &coeffs,
+                     uint8_t *dst, int dstLinesize, int rowStart, int rowEnd)
+{
+    const __m128i bias = _mm_set1_epi16(128);
+    const __m128i lowByte = _mm_set1_epi16(0x00FF);
+    const int simdWidth = src.width & ~15;
+
+    for (int row = rowStart; row < rowEnd; ++row) {
+        const uint8_t *yRow = src.data[0] + static_cast<intptr_t>(row) * src.linesize[0];
+        const uint8_t *uRow = chromaRow(src, 1, row);
+        const uint8_t *vRow = src.layout == LayoutNV12 ? nullptr : chromaRow(src, 2, row);
+        uint8_t *dstRow = dst + static_cast<intptr_t>(row) * dstLinesize;
+
+        int x = 0;
+        for (; x < simdWidth; x += 16) {
+            __m128i y8 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(yRow + x));
+            __m128i u16, v16;
+
+            if (src.layout == LayoutNV12) {
+                __m128i uv = _mm_loadu_si128(reinterpret_cast<const __m128i *>(uRow + x));
+                u16 = _mm_and_si128(uv, lowByte);
+                v16 = _mm_srli_epi16(uv, 8);
+            } else {
+                __m128i zero = _mm_setzero_si128();
+                u16 = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(uRow + x / 2)), zero);
+                v16 = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(vRow + x / 2)), zero);
+            }
+
+            u16 = _mm_sub_epi16(u16, bias);
+            v16 = _mm_sub_epi16(v16, bias);
+
+            // 每个色度样本对应两个水平相邻像素；Y与自身交错得到 Y*257
+            storePixelsSSE2(_mm_unpacklo_epi8(y8, y8), _mm_unpacklo_epi16(u16, u16),
+                            _mm_unpacklo_epi16(v16, v16), coeffs, dstRow + x * 4);
+            storePixelsSSE2(_mm_unpackhi_epi8(y8, y8), _mm_unpackhi_epi16(u16, u16),
+                            _mm_unpackhi_epi16(v16, v16), coeffs, dstRow + x * 4 + 32);
+        }
+
+        convertRowTail(src, coeffs, yRow, uRow, vRow, reinterpret_cast<uint32_t *>(dstRow), x);
+    }
+}
+
+// 16个像素，输入含义同 storePixelsSSE2
+YUVCONVERT_TARGET_AVX2
+inline void storePixelsAVX2(__m256i y, __m256i u, __m256i v, const Coefficients &c, uint8_t *dst)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i max = _mm256_set1_epi16(255);
+
+    __m256i luma = _mm256_mulhi_epu16(y, _mm256_set1_epi16(c.yGain));
+    luma = _mm256_adds_epi16(luma, _mm256_set1_epi16(c.yBias));
+
+    __m256i r = _mm256_adds_epi16(luma, _mm256_mullo_epi16(v, _mm256_set1_epi16(c.vToR)));
+    __m256i g = _mm256_subs_epi16(luma, _mm256_add_epi16(_mm256_mullo_epi16(u, _mm256_set1_epi16(c.uToG)),
+                                                         _mm256_mullo_epi16(v, _mm256_set1_epi16(c.vToG))));
+    __m256i b = _mm256_adds_epi16(luma, _mm256_mullo_epi16(u, _mm256_set1_epi16(c.uToB)));
+
+    r = _mm256_min_epi16(_mm256_max_epi16(_mm256_srai_epi16(r, 6), zero), max);
+    g = _mm256_min_epi16(_mm256_max_epi16(_mm256_srai_epi16(g, 6), zero), max);
+    b = _mm256_min_epi16(_mm256_max_epi16(_mm256_srai_epi16(b, 6), zero), max);
+
+    __m256i bg = _mm256_or_si256(b, _mm256_slli_epi16(g, 8));
+    __m256i ra = _mm256_or_si256(r, _mm256_set1_epi16(static_cast<short>(0xFF00)));
+
+    // unpack 按128位通道进行，需要重新排列回像素顺序
+    __m256i lo = _mm256_unpacklo_epi16(bg, ra);
+    __m256i hi = _mm256_unpackhi_epi16(bg, ra);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), _mm256_permute2x128_si256(lo, hi, 0x20));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+}
+
+// 16个色度样本扩展为32个像素（每个样本重复两次），保持像素顺序
+YUVCONVERT_TARGET_AVX2
+inline void duplicateChromaAVX2(__m256i chroma, __m256i &first, __m256i &second)
+{
+    __m256i lo = _mm256_unpacklo_epi16(chroma, chroma);
+    __m256i hi = _mm256_unpackhi_epi16(chroma, chroma);
+    first = _mm256_permute2x128_si256(lo, hi, 0x20);
+    second = _mm256_permute2x128_si256(lo, hi, 0x31);
+}
+
+YUVCONVERT_TARGET_AVX2
+void convertRowsAVX2(const Source &src, const Coefficients &coeffs,
+                     uint8_t *dst, int dstLinesize, int rowStart, int rowEnd)
+{
+    const __m256i bias = _mm256_set1_epi16(128);
+    const __m256i lowByte = _mm256_set1_epi16(0x00FF);
+    const int simdWidth = src.width & ~31;
+
+    for (int row = rowStart; row < rowEnd; ++row) {
+        const uint8_t *yRow = src.data[0] + static_cast<intptr_t>(row) * src.linesize[0];
+        const uint8_t *uRow = chromaRow(src, 1, row);
+        const uint8_t *vRow = src.layout == LayoutNV12 ? nullptr : chromaRow(src, 2, row);
+        uint8_t *dstRow = dst + static_cast<intptr_t>(row) * dstLinesize;
+
+        int x = 0;
+        for (; x < simdWidth; x += 32) {
+            __m256i y0 = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(yRow + x)));
+            __m256i y1 = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(yRow + x + 16)));
+            y0 = _mm256_or_si256(y0, _mm256_slli_epi16(y0, 8));
+            y1 = _mm256_or_si256(y1, _mm256_slli_epi16(y1, 8));
+
+            __m256i u16, v16;
+            if (src.layout == LayoutNV12) {
+                __m256i uv = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(uRow + x));
+                u16 = _mm256_and_si256(uv, lowByte);
+                v16 = _mm256_srli_epi16(uv, 8);
+            } else {
+                u16 = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(uRow + x / 2)));
+                v16 = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(vRow + x / 2)));
+            }
+
+            u16 = _mm256_sub_epi16(u16, bias);
+            v16 = _mm256_sub_epi16(v16, bias);
+
+            __m256i u0, u1, v0, v1;
+            duplicateChromaAVX2(u16, u0, u1);
+            duplicateChromaAVX2(v16, v0, v1);
+
+            storePixelsAVX2(y0, u0, v0, coeffs, dstRow + x * 4);
+            storePixelsAVX2(y1, u1, v1, coeffs, dstRow + x * 4 + 64);
+        }
+
+        convertRowTail(src, coeffs, yRow, uRow, vRow, reinterpret_cast<uint32_t *>(dstRow), x);
+    }
+}
+
+#endif // YUVCONVERT_X86
+
+#ifdef YUVCONVERT_NEON
+
+// 8个像素：Y为原始8位值，U/V为减去128后的16位有符号数（已按像素展开）
+inline uint8x8x4_t convertPixelsNEON(uint8x8_t y, int16x8_t u, int16x8_t v, const Coefficients &c)
+{
+    // 与 _mm_mulhi_epu16(Y*257, gain) 等价
+    uint16x8_t y257 = vmulq_n_u16(vmovl_u8(y), 257);
+    uint32x4_t lumaLo = vmull_n_u16(vget_low_u16(y257), static_cast<uint16_t>(c.yGain));
+    uint32x4_t lumaHi = vmull_n_u16(vget_high_u16(y257), static_cast<uint16_t>(c.yGain));
+    int16x8_t luma = vreinterpretq_s16_u16(vcombine_u16(vshrn_n_u32(lumaLo, 16), vshrn_n_u32(lumaHi, 16)));
+    luma = vqaddq_s16(luma, vdupq_n_s16(c.yBias));
+
+    int16x8_t r = vqaddq_s16(luma, vmulq_n_s16(v, c.vToR));
+    int16x8_t g = vqsubq_s16(luma, vaddq_s16(vmulq_n_s16(u, c.uToG), vmulq_n_s16(v, c.vToG)));
+    int16x8_t b = vqaddq_s16(luma, vmulq_n_s16(u, c.uToB));
+
+    uint8x8x4_t pixels;
+    pixels.val[0] = vqmovun_s16(vshrq_n_s16(b, 6));
+    pixels.val[1] = vqmovun_s16(vshrq_n_s16(g, 6));
+    pixels.val[2] = vqmovun_s16(vshrq_n_s16(r, 6));
+    pixels.val[3] = vdup_n_u8(0xFF);
+    return pixels;
+}
+
+void convertRowsNEON(const Source &src, const Coefficients &coeffs,
+                     uint8_t *dst, int dstLinesize, int rowStart, int rowEnd)
+{
+    const int simdWidth = src.width & ~15;
+    const uint8x8_t bias = vdup_n_u8(128);
+
+    for (int row = rowStart; row < rowEnd; ++row) {
+        const uint8_t *yRow = src.data[0] + static_cast<intptr_t>(row) * src.linesize[0];
+        const uint8_t *uRow = chromaRow(src, 1, row);
+        const uint8_t *vRow = src.layout == LayoutNV12 ? nullptr : chromaRow(src, 2, row);
+        uint8_t *dstRow = dst + static_cast<intptr_t>(row) * dstLinesize;
+
+        int x = 0;
+        for (; x < simdWidth; x += 16) {
+            uint8x16_t y = vld1q_u8(yRow + x);
+            uint8x8_t u8, v8;
+
+            if (src.layout == LayoutNV12) {
+                uint8x8x2_t uv = vld2_u8(uRow + x);
+                u8 = uv.val[0];
+                v8 = uv.val[1];
+            } else {
+                u8 = vld1_u8(uRow + x / 2);
+                v8 = vld1_u8(vRow + x / 2);
+            }
+
+            int16x8_t u16 = vreinterpretq_s16_u16(vsubl_u8(u8, bias));
+            int16x8_t v16 = vreinterpretq_s16_u16(vsubl_u8(v8, bias));
+            int16x8x2_t uu = vzipq_s16(u16, u16);
+            int16x8x2_t vv = vzipq_s16(v16, v16);
+
+            vst4_u8(dstRow + x * 4, convertPixelsNEON(vget_low_u8(y), uu.val[0], vv.val[0], coeffs));
+            vst4_u8(dstRow + x * 4 + 32, convertPixelsNEON(vget_high_u8(y), uu.val[1], vv.val[1], coeffs));
+        }
+
+        convertRowTail(src, coeffs, yRow, uRow, vRow, reinterpret_cast<uint32_t *>(dstRow), x);
+    }
+}
+
+#endif // YUVCONVERT_NEON
+
+} // namespace
+
+Coefficients makeCoefficients(Matrix matrix, bool fullRange)
+{
+    // Kr/Kb 定义颜色矩阵
+    const double kr = matrix == MatrixBT709 ? 0.2126 : 0.299;
+    const double kb = matrix == MatrixBT709 ? 0.0722 : 0.114;
+    const double kg = 1.0 - kr - kb;
+
+    // 有限范围：Y 16-235，UV 16-240；全范围：0-255
+    const double yScale = fullRange ? 1.0 : 255.0 / 219.0;
+    const double cScale = fullRange ? 1.0 : 255.0 / 224.0;
+    const double yOffset = fullRange ? 0.0 : 16.0;
+
+    Coefficients c;
+    c.yGain = static_cast<int16_t>(std::lround(yScale * 64.0 * 65536.0 / 257.0));
+    c.yBias = static_cast<int16_t>(std::lround(-yOffset * yScale * 64.0) + 32);
+    c.vToR = static_cast<int16_t>(std::lround(2.0 * (1.0 - kr) * cScale * 64.0));
+    c.uToG = static_cast<int16_t>(std::lround(2.0 * (1.0 - kb) * kb / kg * cScale * 64.0));
+    c.vToG = static_cast<int16_t>(std::lround(2.0 * (1.0 - kr) * kr / kg * cScale * 64.0));
+    c.uToB = static_cast<int16_t>(std::lround(2.0 * (1.0 - kb) * cScale * 64.0));
+    return c;
+}
+
+ConvertRowsFn kernel(Kernel kernel)
+{
+    switch (kernel) {
+    case KernelScalar:
+        return &convertRowsScalar;
+#ifdef YUVCONVERT_X86
+    case KernelSSE2:
+        return &convertRowsSSE2;
+    case KernelAVX2:
+        return &convertRowsAVX2;
+#endif
+#ifdef YUVCONVERT_NEON
+    case KernelNEON:
+        return &convertRowsNEON;
+#endif
+    default:
+        return nullptr;
+    }
+}
+
+const char *kernelName(Kernel kernel)
+{
+    switch (kernel) {
+    case KernelSSE2: return "sse2";
+    case KernelAVX2: return "avx2";
+    case KernelNEON: return "neon";
+    default: return "c";
+    }
+}
+
+} // namespace YuvConvert
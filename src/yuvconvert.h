@@ -0,0 +1,67 @@
+#ifndef YUVCONVERT_H
+#define YUVCONVERT_H
+
+#include <cstdint>
+
+/**
+ * @brief YUV 到 RGB32 的颜色转换内核
+ * 不依赖 Qt/FFmpeg，输出为本机字节序的 0xFFRRGGBB（与 QImage::Format_RGB32 一致）。
+ * 提供标量、SSE2、AVX2 和 NEON 实现，由调用方在运行时按 CPU 能力选择。
+ */
+namespace YuvConvert {
+
+// 输入平面布局
+enum Layout {
+    LayoutI420 = 0,   // Y + U + V，色度水平和垂直各半（yuv420p / yuvj420p）
+    LayoutNV12 = 1,   // Y + 交错UV，色度水平和垂直各半
+    LayoutI422 = 2    // Y + U + V，色度仅水平减半（yuv422p / yuvj422p）
+};
+
+// 颜色矩阵
+enum Matrix {
+    MatrixBT601 = 0,
+    MatrixBT709 = 1
+};
+
+// 指令集
+enum Kernel {
+    KernelScalar = 0,
+    KernelSSE2 = 1,
+    KernelAVX2 = 2,
+    KernelNEON = 3
+};
+
+// 源图像平面
+struct Source {
+    const uint8_t *data[3];
+    int linesize[3];
+    int width;
+    int height;
+    Layout layout;
+};
+
+// 定点转换系数（Q6），由 makeCoefficients 生成
+struct Coefficients {
+    int16_t yGain;     // 与 Y*257 做无符号高位乘法
+    int16_t yBias;     // 包含黑电平偏移和舍入
+    int16_t vToR;
+    int16_t uToG;
+    int16_t vToG;
+    int16_t uToB;
+};
+
+Coefficients makeCoefficients(Matrix matrix, bool fullRange);
+
+// 转换 [rowStart, rowEnd) 行；对于4:2:0布局 rowStart 必须为偶数
+typedef void (*ConvertRowsFn)(const Source &src, const Coefficients &coeffs,
+                              uint8_t *dst, int dstLinesize,
+                              int rowStart, int rowEnd);
+
+// 返回指定指令集的内核，当前平台不支持时返回 nullptr
+ConvertRowsFn kernel(Kernel kernel);
+
+const char *kernelName(Kernel kernel);
+
+} // namespace YuvConvert
+
+#endif // YUVCONVERT_H
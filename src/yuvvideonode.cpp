@@ -0,0 +1,237 @@
+#include "yuvvideonode.h"
+
+#ifdef ARDKIT_YUV_SHADERS
+
+#include <QDebug>
+
+extern "C" {
+#include <libavutil/common.h>
+#include <libavutil/pixdesc.h>
+}
+
+namespace {
+// uniform 缓冲布局（std140），与 shaders/yuv.vert、yuv.frag 一致
+const int kMatrixOffset = 0;
+const int kColorMatrixOffset = 64;
+const int kOpacityOffset = 128;
+const int kInterleavedChromaOffset = 132;
+
+// (Y, U, V, 1) -> RGB，输入为归一化的采样值
+QMatrix4x4 makeColorMatrix(YuvConvert::Matrix matrix, bool fullRange)
+{
+    const float kr = matrix == YuvConvert::MatrixBT709 ? 0.2126f : 0.299f;
+    const float kb = matrix == YuvConvert::MatrixBT709 ? 0.0722f : 0.114f;
+    const float kg = 1.0f - kr - kb;
+
+    const float yScale = fullRange ? 1.0f : 255.0f / 219.0f;
+    const float cScale = fullRange ? 1.0f : 255.0f / 224.0f;
+    const float yOffset = fullRange ? 0.0f : 16.0f / 255.0f;
+    const float cOffset = 128.0f / 255.0f;
+
+    const float vToR = 2.0f * (1.0f - kr) * cScale;
+    const float uToG = 2.0f * (1.0f - kb) * kb / kg * cScale;
+    const float vToG = 2.0f * (1.0f - kr) * kr / kg * cScale;
+    const float uToB = 2.0f * (1.0f - kb) * cScale;
+    const float yBias = -yScale * yOffset;
+
+    return QMatrix4x4(yScale, 0.0f,  vToR,  yBias - vToR * cOffset,
+                      yScale, -uToG, -vToG, yBias + (uToG + vToG) * cOffset,
+                      yScale, uToB,  0.0f,  yBias - uToB * cOffset,
+                      0.0f,   0.0f,  0.0f,  1.0f);
+}
+}
+
+YuvPlaneTexture::YuvPlaneTexture()
+    : m_texture(nullptr)
+    , m_format(QRhiTexture::R8)
+    , m_plane(0)
+    , m_dirty(false)
+{
+    setFiltering(QSGTexture::Linear);
+    setHorizontalWrapMode(QSGTexture::ClampToEdge);
+    setVerticalWrapMode(QSGTexture::ClampToEdge);
+}
+
+YuvPlaneTexture::~YuvPlaneTexture()
+{
+    if (m_texture) {
+        m_texture->deleteLater();
+    }
+}
+
+void YuvPlaneTexture::setPlane(const VideoFrame &frame, int plane, const QSize &size, QRhiTexture::Format format)
+{
+    m_frame = frame;
+    m_plane = plane;
+    m_size = size;
+    m_format = format;
+    m_dirty = true;
+}
+
+qint64 YuvPlaneTexture::comparisonKey() const
+{
+    return qint64(quintptr(this));
+}
+
+void YuvPlaneTexture::commitTextureOperations(QRhi *rhi, QRhiResourceUpdateBatch *resourceUpdates)
+{
+    if (!m_dirty) {
+        return;
+    }
+    m_dirty = false;
+
+    // 尺寸和格式不变时复用纹理，只上传数据
+    if (!m_texture || m_texture->pixelSize() != m_size || m_texture->format() != m_format) {
+        if (m_texture) {
+            m_texture->deleteLater();
+        }
+        m_texture = rhi->newTexture(m_format, m_size);
+        if (!m_texture->create()) {
+            qWarning() << "Failed to create YUV plane texture:" << m_size;
+            delete m_texture;
+            m_texture = nullptr;
+            return;
+        }
+    }
+
+    const AVFrame *frame = m_frame.avFrame();
+    if (!frame || !frame->data[m_plane] || frame->linesize[m_plane] <= 0) {
+        return;
+    }
+
+    // 直接引用解码帧的平面数据，按行跨度上传，不做中间复制
+    const int bytesPerPixel = m_format == QRhiTexture::RG8 ? 2 : 1;
+    const int linesize = frame->linesize[m_plane];
+    const int dataSize = linesize * (m_size.height() - 1) + m_size.width() * bytesPerPixel;
+    QRhiTextureSubresourceUploadDescription description(
+        QByteArray::fromRawData(reinterpret_cast<const char *>(frame->data[m_plane]), dataSize));
+    description.setDataStride(linesize);
+    description.setSourceSize(m_size);
+    resourceUpdates->uploadTexture(m_texture, QRhiTextureUploadDescription({ 0, 0, description }));
+}
+
+YuvMaterial::YuvMaterial()
+    : m_interleavedChroma(false)
+{
+}
+
+QSGMaterialType *YuvMaterial::type() const
+{
+    static QSGMaterialType type;
+    return &type;
+}
+
+QSGMaterialShader *YuvMaterial::createShader(QSGRendererInterface::RenderMode renderMode) const
+{
+    Q_UNUSED(renderMode)
+    return new YuvMaterialShader;
+}
+
+int YuvMaterial::compare(const QSGMaterial *other) const
+{
+    // 每个节点的纹理都不同，不能合批
+    if (this == other) {
+        return 0;
+    }
+    return this < other ? -1 : 1;
+}
+
+void YuvMaterial::setFrame(const VideoFrame &frame)
+{
+    const AVFrame *avFrame = frame.avFrame();
+    if (!avFrame) {
+        return;
+    }
+
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(avFrame->format));
+    if (!desc) {
+        return;
+    }
+
+    const QSize lumaSize(avFrame->width, avFrame->height);
+    const QSize chromaSize(AV_CEIL_RSHIFT(avFrame->width, desc->log2_chroma_w),
+                           AV_CEIL_RSHIFT(avFrame->height, desc->log2_chroma_h));
+
+    m_interleavedChroma = avFrame->format == AV_PIX_FMT_NV12;
+    m_planes[0].setPlane(frame, 0, lumaSize, QRhiTexture::R8);
+    if (m_interleavedChroma) {
+        m_planes[1].setPlane(frame, 1, chromaSize, QRhiTexture::RG8);
+    } else {
+        m_planes[1].setPlane(frame, 1, chromaSize, QRhiTexture::R8);
+        m_planes[2].setPlane(frame, 2, chromaSize, QRhiTexture::R8);
+    }
+
+    m_colorMatrix = makeColorMatrix(VideoFrame::colorMatrix(avFrame), VideoFrame::isFullRange(avFrame));
+}
+
+YuvMaterialShader::YuvMaterialShader()
+{
+    setShaderFileName(VertexStage, QStringLiteral(":/shaders/yuv.vert.qsb"));
+    setShaderFileName(FragmentStage, QStringLiteral(":/shaders/yuv.frag.qsb"));
+}
+
+bool YuvMaterialShader::updateUniformData(RenderState &state, QSGMaterial *newMaterial, QSGMaterial *oldMaterial)
+{
+    Q_UNUSED(oldMaterial)
+    YuvMaterial *material = static_cast<YuvMaterial *>(newMaterial);
+    QByteArray *buffer = state.uniformData();
+
+    if (state.isMatrixDirty()) {
+        const QMatrix4x4 matrix = state.combinedMatrix();
+        memcpy(buffer->data() + kMatrixOffset, matrix.constData(), 64);
+    }
+
+    if (state.isOpacityDirty()) {
+        const float opacity = state.opacity();
+        memcpy(buffer->data() + kOpacityOffset, &opacity, 4);
+    }
+
+    // 颜色矩阵随帧的色彩空间变化，每次都写入
+    memcpy(buffer->data() + kColorMatrixOffset, material->colorMatrix().constData(), 64);
+    const qint32 interleaved = material->interleavedChroma() ? 1 : 0;
+    memcpy(buffer->data() + kInterleavedChromaOffset, &interleaved, 4);
+
+    return true;
+}
+
+void YuvMaterialShader::updateSampledImage(RenderState &state, int binding, QSGTexture **texture,
+                                           QSGMaterial *newMaterial, QSGMaterial *oldMaterial)
+{
+    Q_UNUSED(oldMaterial)
+    YuvMaterial *material = static_cast<YuvMaterial *>(newMaterial);
+
+    // binding 1-3 对应 Y/U/V；NV12 没有单独的V平面，绑定交错的UV纹理
+    int index = binding - 1;
+    if (index == 2 && material->interleavedChroma()) {
+        index = 1;
+    }
+    if (index < 0 || index > 2) {
+        return;
+    }
+
+    YuvPlaneTexture *plane = material->plane(index);
+    plane->commitTextureOperations(state.rhi(), state.resourceUpdateBatch());
+    *texture = plane;
+}
+
+YuvVideoNode::YuvVideoNode()
+    : m_geometry(QSGGeometry::defaultAttributes_TexturedPoint2D(), 4)
+{
+    m_geometry.setDrawingMode(QSGGeometry::DrawTriangleStrip);
+    setGeometry(&m_geometry);
+    setMaterial(&m_material);
+}
+
+void YuvVideoNode::setFrame(const VideoFrame &frame)
+{
+    m_material.setFrame(frame);
+    markDirty(DirtyMaterial);
+}
+
+void YuvVideoNode::setRect(const QRectF &rect)
+{
+    QSGGeometry::updateTexturedRectGeometry(&m_geometry, rect, QRectF(0, 0, 1, 1));
+    markDirty(DirtyGeometry);
+}
+
+#endif // ARDKIT_YUV_SHADERS
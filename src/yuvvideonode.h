@@ -0,0 +1,95 @@
+#ifndef YUVVIDEONODE_H
+#define YUVVIDEONODE_H
+
+#ifdef ARDKIT_YUV_SHADERS
+
+#include <QMatrix4x4>
+#include <QSGGeometryNode>
+#include <QSGMaterial>
+#include <QSGMaterialShader>
+#include <QSGTexture>
+#include <rhi/qrhi.h>
+#include "videoframe.h"
+
+/**
+ * @brief 单个YUV平面的纹理
+ * 直接从解码帧的平面上传（R8 或 NV12 色度使用 RG8），上传前一直持有该帧的引用。
+ * 尺寸和格式不变时复用同一个 QRhiTexture。
+ */
+class YuvPlaneTexture : public QSGTexture
+{
+public:
+    YuvPlaneTexture();
+    ~YuvPlaneTexture() override;
+
+    void setPlane(const VideoFrame &frame, int plane, const QSize &size, QRhiTexture::Format format);
+
+    qint64 comparisonKey() const override;
+    QRhiTexture *rhiTexture() const override { return m_texture; }
+    QSize textureSize() const override { return m_size; }
+    bool hasAlphaChannel() const override { return false; }
+    bool hasMipmaps() const override { return false; }
+    void commitTextureOperations(QRhi *rhi, QRhiResourceUpdateBatch *resourceUpdates) override;
+
+private:
+    QRhiTexture *m_texture;
+    QSize m_size;
+    QRhiTexture::Format m_format;
+    VideoFrame m_frame;
+    int m_plane;
+    bool m_dirty;
+};
+
+/**
+ * @brief 在片段着色器中完成 YUV 到 RGB 转换的材质
+ */
+class YuvMaterial : public QSGMaterial
+{
+public:
+    YuvMaterial();
+
+    QSGMaterialType *type() const override;
+    QSGMaterialShader *createShader(QSGRendererInterface::RenderMode renderMode) const override;
+    int compare(const QSGMaterial *other) const override;
+
+    YuvPlaneTexture *plane(int index) { return &m_planes[index]; }
+    const QMatrix4x4 &colorMatrix() const { return m_colorMatrix; }
+    bool interleavedChroma() const { return m_interleavedChroma; }
+
+    void setFrame(const VideoFrame &frame);
+
+private:
+    YuvPlaneTexture m_planes[3];
+    QMatrix4x4 m_colorMatrix;
+    bool m_interleavedChroma;
+};
+
+class YuvMaterialShader : public QSGMaterialShader
+{
+public:
+    YuvMaterialShader();
+
+    bool updateUniformData(RenderState &state, QSGMaterial *newMaterial, QSGMaterial *oldMaterial) override;
+    void updateSampledImage(RenderState &state, int binding, QSGTexture **texture,
+                            QSGMaterial *newMaterial, QSGMaterial *oldMaterial) override;
+};
+
+/**
+ * @brief 显示 YUV 帧的场景图节点
+ */
+class YuvVideoNode : public QSGGeometryNode
+{
+public:
+    YuvVideoNode();
+
+    void setFrame(const VideoFrame &frame);
+    void setRect(const QRectF &rect);
+
+private:
+    QSGGeometry m_geometry;
+    YuvMaterial m_material;
+};
+
+#endif // ARDKIT_YUV_SHADERS
+
+#endif // YUVVIDEONODE_H
@@ -0,0 +1,83 @@
+#include <QtTest>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include "videodecoder.h"
+
+namespace {
+// 停止耗时上限（毫秒）
+#if defined(Q_OS_UNIX)
+const qint64 kStopBudgetMs = 50;
+#else
+// 其他平台无法提前唤醒 FFmpeg 的网络等待，最多多出一个100ms轮询周期
+const qint64 kStopBudgetMs = 150;
+#endif
+
+// 连接建立后等待解复用线程进入阻塞读取的时间（毫秒）
+const int kSettleMs = 250;
+
+// 每种地址重复的次数，唤醒时机相对FFmpeg轮询周期各不相同
+const int kRepeats = 5;
+}
+
+/**
+ * @brief VideoDecoder 停止延迟测试
+ * 本地 TCP 服务接受连接后从不回应，模拟已连上但不再发送数据的设备：
+ * 解复用线程阻塞在 avformat_open_input 的网络等待中，stopDecoding 必须在限定时间内返回。
+ */
+class TestVideoDecoder : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void stopWhileStalled_data();
+    void stopWhileStalled();
+};
+
+void TestVideoDecoder::stopWhileStalled_data()
+{
+    QTest::addColumn<QString>("urlPattern");
+
+    // RTSP：阻塞在等待 OPTIONS/DESCRIBE 回应；tcp：阻塞在读取探测数据
+    QTest::newRow("rtsp") << QStringLiteral("rtsp://127.0.0.1:%1/stream");
+    QTest::newRow("tcp") << QStringLiteral("tcp://127.0.0.1:%1");
+}
+
+void TestVideoDecoder::stopWhileStalled()
+{
+    QFETCH(QString, urlPattern);
+
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+
+    // 只接受连接，不读也不写（套接字随服务一起释放）
+    QList<QTcpSocket *> connections;
+    connect(&server, &QTcpServer::newConnection, this, [&server, &connections]() {
+        while (QTcpSocket *socket = server.nextPendingConnection()) {
+            connections.append(socket);
+        }
+    });
+
+    const QString url = urlPattern.arg(server.serverPort());
+    for (int i = 0; i < kRepeats; ++i) {
+        const int accepted = connections.size();
+
+        VideoDecoder decoder;
+        QVERIFY(decoder.openStream(url));
+        QTRY_VERIFY_WITH_TIMEOUT(connections.size() > accepted, 5000);
+        QTest::qWait(kSettleMs + i * 17);
+        QCOMPARE(decoder.streamState(), int(VideoDecoder::StreamConnecting));
+
+        QElapsedTimer timer;
+        timer.start();
+        decoder.stopDecoding();
+        const qint64 elapsedMs = timer.elapsed();
+
+        QVERIFY(decoder.isFinished());
+        QVERIFY2(elapsedMs < kStopBudgetMs,
+                 qPrintable(QString("stopDecoding took %1 ms (budget %2 ms)").arg(elapsedMs).arg(kStopBudgetMs)));
+        qDebug() << url << "stopped in" << elapsedMs << "ms";
+    }
+}
+
+QTEST_GUILESS_MAIN(TestVideoDecoder)
+#include "tst_videodecoder.moc"
@@ -0,0 +1,196 @@
+#include <QtTest>
+#include <vector>
+#include "yuvconvert.h"
+
+using namespace YuvConvert;
+
+namespace {
+// 目标行尾之外的填充字节，用于检查内核没有越界写入
+const uint8_t kDstPadding = 0xAB;
+
+// 固定种子的伪随机数，失败时可以复现
+class Lcg
+{
+public:
+    explicit Lcg(uint32_t seed) : m_state(seed) {}
+    uint8_t next()
+    {
+        m_state = m_state * 1664525u + 1013904223u;
+        return static_cast<uint8_t>(m_state >> 24);
+    }
+
+private:
+    uint32_t m_state;
+};
+
+// 带随机内容的源图像，行宽大于图像宽度且不对齐，填充区也是随机数据
+struct TestImage {
+    std::vector<uint8_t> planes[3];
+    Source source;
+
+    TestImage(Layout layout, int width, int height, uint32_t seed)
+    {
+        const int chromaWidth = (width + 1) / 2;
+        const int chromaHeight = layout == LayoutI422 ? height : (height + 1) / 2;
+        const int planeCount = layout == LayoutNV12 ? 2 : 3;
+        const int linesizes[3] = { width + 37, (layout == LayoutNV12 ? chromaWidth * 2 : chromaWidth) + 29, chromaWidth + 23 };
+
+        Lcg random(seed);
+        for (int i = 0; i < 3; ++i) {
+            if (i >= planeCount) {
+                source.data[i] = nullptr;
+                source.linesize[i] = 0;
+                continue;
+            }
+            planes[i].resize(static_cast<size_t>(linesizes[i]) * (i == 0 ? height : chromaHeight));
+            for (uint8_t &value : planes[i]) {
+                value = random.next();
+            }
+            source.data[i] = planes[i].data();
+            source.linesize[i] = linesizes[i];
+        }
+        source.width = width;
+        source.height = height;
+        source.layout = layout;
+    }
+};
+
+std::vector<uint8_t> convertWith(ConvertRowsFn convertRows, const Source &source, const Coefficients &coeffs,
+                                 int dstLinesize, const QVector<int> &sliceStarts)
+{
+    std::vector<uint8_t> dst(static_cast<size_t>(dstLinesize) * source.height, kDstPadding);
+    for (int i = 0; i < sliceStarts.size(); ++i) {
+        const int rowEnd = i + 1 < sliceStarts.size() ? sliceStarts[i + 1] : source.height;
+        convertRows(source, coeffs, dst.data(), dstLinesize, sliceStarts[i], rowEnd);
+    }
+    return dst;
+}
+
+uint32_t convertPixel(Matrix matrix, bool fullRange, uint8_t y, uint8_t u, uint8_t v)
+{
+    Source source;
+    source.data[0] = &y;
+    source.data[1] = &u;
+    source.data[2] = &v;
+    source.linesize[0] = source.linesize[1] = source.linesize[2] = 1;
+    source.width = 1;
+    source.height = 1;
+    source.layout = LayoutI420;
+
+    uint32_t pixel = 0;
+    kernel(KernelScalar)(source, makeCoefficients(matrix, fullRange), reinterpret_cast<uint8_t *>(&pixel), 4, 0, 1);
+    return pixel;
+}
+}
+
+/**
+ * @brief YuvConvert 内核测试
+ * 各SIMD内核与标量实现逐字节比较：覆盖三种布局、奇数宽高（含向量宽度附近的尾部）、
+ * 两种颜色矩阵和范围，以及分片转换；当前CPU不支持的内核跳过。
+ */
+class TestYuvConvert : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void scalarReferenceLevels();
+    void kernelsMatchScalar_data();
+    void kernelsMatchScalar();
+};
+
+void TestYuvConvert::scalarReferenceLevels()
+{
+    QVERIFY(kernel(KernelScalar) != nullptr);
+
+    // 有限范围：16为黑、235为白，超出部分截断
+    QCOMPARE(convertPixel(MatrixBT601, false, 16, 128, 128), 0xFF000000u);
+    QCOMPARE(convertPixel(MatrixBT601, false, 235, 128, 128), 0xFFFFFFFFu);
+    QCOMPARE(convertPixel(MatrixBT709, false, 0, 128, 128), 0xFF000000u);
+    QCOMPARE(convertPixel(MatrixBT709, false, 255, 128, 128), 0xFFFFFFFFu);
+
+    // 全范围：亮度原样输出
+    QCOMPARE(convertPixel(MatrixBT601, true, 0, 128, 128), 0xFF000000u);
+    QCOMPARE(convertPixel(MatrixBT601, true, 16, 128, 128), 0xFF101010u);
+    QCOMPARE(convertPixel(MatrixBT709, true, 255, 128, 128), 0xFFFFFFFFu);
+}
+
+void TestYuvConvert::kernelsMatchScalar_data()
+{
+    QTest::addColumn<int>("layout");
+    QTest::addColumn<int>("width");
+    QTest::addColumn<int>("height");
+
+    const struct {
+        Layout layout;
+        const char *name;
+    } layouts[] = {
+        { LayoutI420, "i420" },
+        { LayoutNV12, "nv12" },
+        { LayoutI422, "i422" },
+    };
+    // 向量宽度为8/16/32像素，宽度覆盖其前后的尾部处理
+    const int widths[] = { 1, 2, 3, 15, 16, 17, 31, 32, 33, 63, 65, 127, 641 };
+    const int heights[] = { 1, 2, 3, 7, 9 };
+
+    for (const auto &layout : layouts) {
+        for (int width : widths) {
+            for (int height : heights) {
+                QTest::addRow("%s %dx%d", layout.name, width, height) << int(layout.layout) << width << height;
+            }
+        }
+    }
+}
+
+void TestYuvConvert::kernelsMatchScalar()
+{
+    QFETCH(int, layout);
+    QFETCH(int, width);
+    QFETCH(int, height);
+
+    const TestImage image(static_cast<Layout>(layout), width, height, uint32_t(layout * 100003 + width * 101 + height));
+    const int dstLinesize = width * 4 + 48;
+
+    // 整帧和按偶数行分片（与 FrameConverter 的分片方式一致）
+    QVector<QVector<int>> slicings = { { 0 } };
+    if (height >= 4) {
+        slicings.append({ 0, 2 });
+    }
+    if (height >= 6) {
+        slicings.append({ 0, 2, 4 });
+    }
+
+    const Kernel kernels[] = { KernelSSE2, KernelAVX2, KernelNEON };
+    for (int matrix = MatrixBT601; matrix <= MatrixBT709; ++matrix) {
+        for (bool fullRange : { false, true }) {
+            const Coefficients coeffs = makeCoefficients(static_cast<Matrix>(matrix), fullRange);
+            const std::vector<uint8_t> expected = convertWith(kernel(KernelScalar), image.source, coeffs, dstLinesize, { 0 });
+
+            // 行尾填充不被改写
+            for (int row = 0; row < height; ++row) {
+                for (int i = width * 4; i < dstLinesize; ++i) {
+                    QCOMPARE(expected[static_cast<size_t>(row) * dstLinesize + i], kDstPadding);
+                }
+            }
+
+            for (Kernel candidate : kernels) {
+                const ConvertRowsFn convertRows = kernel(candidate);
+                if (!convertRows) {
+                    continue;
+                }
+                for (const QVector<int> &slices : slicings) {
+                    const std::vector<uint8_t> actual = convertWith(convertRows, image.source, coeffs, dstLinesize, slices);
+                    if (actual != expected) {
+                        QFAIL(qPrintable(QString("%1 differs from scalar (matrix %2, %3 range, %4 slices)")
+                                             .arg(kernelName(candidate))
+                                             .arg(matrix == MatrixBT709 ? "BT.709" : "BT.601")
+                                             .arg(fullRange ? "full" : "limited")
+                                             .arg(slices.size())));
+                    }
+                }
+            }
+        }
+    }
+}
+
+QTEST_APPLESS_MAIN(TestYuvConvert)
+#include "tst_yuvconvert.moc"
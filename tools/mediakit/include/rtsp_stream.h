@@ -26,6 +26,7 @@ public:
     bool initialize(const std::string& video_file,
                    const std::string& url,
                    bool loop = true) override;
+    void setTimestampSei(bool enabled) override;
 
     bool start() override;
     void stop() override;
@@ -42,6 +43,7 @@ private:
     std::string m_videoFile;
     std::string m_url;
     bool m_loop;
+    bool m_timestampSei;
     std::atomic<bool> m_running;
     std::thread m_streamThread;
 
@@ -0,0 +1,36 @@
+#ifndef SEI_TIMESTAMP_H
+#define SEI_TIMESTAMP_H
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+#include <cstdint>
+
+/**
+ * @brief 时间戳SEI注入
+ *
+ * 在每个视频帧的第一个VCL NAL之前插入 user_data_unregistered SEI，
+ * 负载为固定UUID加发送时刻的墙上时钟（微秒，大端）。
+ * 接收端（ArdKit-GUI 的 SeiTimestamp）据此计算端到端延迟，两端时钟需同步（同一主机或NTP）。
+ */
+
+/**
+ * @brief 获取NAL长度前缀的字节数
+ * @param codecpar 视频流参数（H.264 或 HEVC）
+ * @return avcC/hvcC 格式返回1~4，Annex B（起始码）格式返回0
+ */
+int seiNalLengthSize(const AVCodecParameters* codecpar);
+
+/**
+ * @brief 在packet中插入时间戳SEI
+ * @param packet 视频packet，成功时被替换为包含SEI的新数据
+ * @param codec_id AV_CODEC_ID_H264 或 AV_CODEC_ID_HEVC
+ * @param nal_length_size NAL长度前缀字节数，0表示Annex B
+ * @param timestamp_us 墙上时钟（av_gettime，微秒）
+ * @return 成功返回true；编码格式不支持或packet无法解析时返回false，packet保持不变
+ */
+bool insertTimestampSei(AVPacket* packet, AVCodecID codec_id,
+                        int nal_length_size, int64_t timestamp_us);
+
+#endif // SEI_TIMESTAMP_H
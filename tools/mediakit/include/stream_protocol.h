@@ -24,6 +24,12 @@ public:
                            const std::string& url,
                            bool loop = true) = 0;
 
+    /**
+     * @brief 设置是否在每帧中注入时间戳SEI（用于接收端测量端到端延迟）
+     * @param enabled 启用时仅对 H.264/HEVC 视频生效，需在 start() 之前调用
+     */
+    virtual void setTimestampSei(bool enabled) = 0;
+
     /**
      * @brief 启动流媒体服务
      * @return 成功返回true，失败返回false
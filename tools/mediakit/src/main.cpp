@@ -30,12 +30,14 @@ void printUsage(const char* program_name) {
     std::cout << "  -u, --url <url>             Stream URL (required)\n";
     std::cout << "  -l, --loop                  Enable loop playback (default: true)\n";
     std::cout << "  -n, --no-loop               Disable loop playback\n";
+    std::cout << "  -t, --timestamp-sei         Embed wall-clock timestamp SEI in each frame (H.264/HEVC)\n";
     std::cout << "  -v, --version               Show version information\n";
     std::cout << "  -h, --help                  Show this help message\n\n";
     std::cout << "Examples:\n";
     std::cout << "  " << program_name << " -p rtsp -f video.mp4 -u rtsp://localhost:8554/stream\n";
     std::cout << "  " << program_name << " -p rtmp -f video.mp4 -u rtmp://localhost:1935/live/stream\n";
     std::cout << "  " << program_name << " --protocol rtsp --file test.mp4 --url rtsp://0.0.0.0:8554/test --no-loop\n";
+    std::cout << "  " << program_name << " -p rtsp -f video.mp4 -u rtsp://localhost:8554/stream --timestamp-sei\n";
 }
 
 void printVersion() {
@@ -49,6 +51,7 @@ int main(int argc, char* argv[]) {
     std::string video_file;
     std::string url;
     bool loop = true;
+    bool timestamp_sei = false;
 
     // Parse command line arguments
     for (int i = 1; i < argc; i++) {
@@ -85,6 +88,8 @@ int main(int argc, char* argv[]) {
             loop = true;
         } else if (arg == "-n" || arg == "--no-loop") {
             loop = false;
+        } else if (arg == "-t" || arg == "--timestamp-sei") {
+            timestamp_sei = true;
         } else {
             std::cerr << "Error: Unknown option: " << arg << "\n";
             printUsage(argv[0]);
@@ -127,13 +132,15 @@ int main(int argc, char* argv[]) {
     std::cout << "Protocol: " << stream->getProtocolName() << "\n";
     std::cout << "Video file: " << video_file << "\n";
     std::cout << "Stream URL: " << url << "\n";
-    std::cout << "Loop mode: " << (loop ? "enabled" : "disabled") << "\n\n";
+    std::cout << "Loop mode: " << (loop ? "enabled" : "disabled") << "\n";
+    std::cout << "Timestamp SEI: " << (timestamp_sei ? "enabled" : "disabled") << "\n\n";
 
     // Initialize stream
     if (!stream->initialize(video_file, url, loop)) {
         std::cerr << "Error: Failed to initialize stream\n";
         return 1;
     }
+    stream->setTimestampSei(timestamp_sei);
 
     // Setup signal handlers
     signal(SIGINT, signalHandler);
@@ -1,4 +1,5 @@
 #include "rtmp_stream.h"
+#include "sei_timestamp.h"
 #include <iostream>
 #include <sstream>
 #include <chrono>
@@ -6,6 +7,7 @@
 
 RTMPStream::RTMPStream()
     : m_loop(true)
+    , m_timestampSei(false)
     , m_running(false)
     , m_inputFormatCtx(nullptr)
     , m_outputFormatCtx(nullptr)
@@ -35,6 +37,11 @@ bool RTMPStream::initialize(const std::string& video_file,
     return true;
 }
 
+void RTMPStream::setTimestampSei(bool enabled) {
+    m_timestampSei = enabled;
+    std::cout << "[RTMP] Timestamp SEI: " << (m_timestampSei ? "enabled" : "disabled") << std::endl;
+}
+
 bool RTMPStream::start() {
     if (m_running) {
         std::cerr << "[RTMP] Already running" << std::endl;
@@ -197,6 +204,15 @@ void RTMPStream::streamingLoop() {
         int64_t start_time = av_gettime();
         int64_t pts_offset = 0;
 
+        // 时间戳SEI：按输入流的封装格式（avcC/hvcC 或 Annex B）插入
+        AVCodecID codec_id = in_stream->codecpar->codec_id;
+        int nal_length_size = seiNalLengthSize(in_stream->codecpar);
+        bool inject_sei = m_timestampSei;
+        if (inject_sei && codec_id != AV_CODEC_ID_H264 && codec_id != AV_CODEC_ID_HEVC) {
+            std::cerr << "[RTMP] Timestamp SEI requires H.264 or HEVC, disabled for this stream" << std::endl;
+            inject_sei = false;
+        }
+
         // Streaming loop
         while (m_running) {
             int ret = av_read_frame(m_inputFormatCtx, packet);
@@ -244,6 +260,11 @@ void RTMPStream::streamingLoop() {
             packet->pos = -1;
             packet->stream_index = 0;
 
+            // 发送时刻的墙上时钟，接收端据此计算端到端延迟
+            if (inject_sei) {
+                insertTimestampSei(packet, codec_id, nal_length_size, av_gettime());
+            }
+
             // Write packet
             ret = av_interleaved_write_frame(m_outputFormatCtx, packet);
             if (ret < 0) {
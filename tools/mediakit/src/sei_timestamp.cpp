@@ -0,0 +1,161 @@
+#include "sei_timestamp.h"
+
+#include <cstring>
+#include <vector>
+
+namespace {
+
+// 与 ArdKit-GUI src/seitimestamp.cpp 中的UUID保持一致
+const uint8_t kTimestampUuid[16] = {
+    0x6a, 0x1f, 0x3c, 0x2e, 0x8b, 0x4d, 0x4e, 0x57,
+    0x9c, 0x0a, 0x1d, 0x2b, 0x3e, 0x4f, 0x5a, 0x60
+};
+
+const int kSeiPayloadTypeUserDataUnregistered = 5;
+const int kSeiPayloadSize = 16 + 8;
+
+bool isVclNal(AVCodecID codec_id, const uint8_t* nal) {
+    if (codec_id == AV_CODEC_ID_H264) {
+        int type = nal[0] & 0x1f;
+        return type >= 1 && type <= 5;
+    }
+    int type = (nal[0] >> 1) & 0x3f;
+    return type <= 31;
+}
+
+// 查找第一个VCL NAL的起始位置（含长度前缀或起始码），SEI插入在它之前
+int findFirstVcl(const uint8_t* data, int size, AVCodecID codec_id, int nal_length_size) {
+    if (nal_length_size > 0) {
+        int pos = 0;
+        while (pos + nal_length_size < size) {
+            uint32_t length = 0;
+            for (int i = 0; i < nal_length_size; i++) {
+                length = (length << 8) | data[pos + i];
+            }
+            const uint8_t* nal = data + pos + nal_length_size;
+            if (length == 0 || length > static_cast<uint32_t>(size - pos - nal_length_size)) {
+                return -1;
+            }
+            if (isVclNal(codec_id, nal)) {
+                return pos;
+            }
+            pos += nal_length_size + static_cast<int>(length);
+        }
+        return -1;
+    }
+
+    for (int i = 0; i + 3 < size; i++) {
+        if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1) {
+            if (isVclNal(codec_id, data + i + 3)) {
+                return (i > 0 && data[i - 1] == 0) ? i - 1 : i;
+            }
+            i += 2;
+        }
+    }
+    return -1;
+}
+
+// 构造带防竞争字节的SEI NAL（不含长度前缀或起始码）
+std::vector<uint8_t> buildSeiNal(AVCodecID codec_id, int64_t timestamp_us) {
+    std::vector<uint8_t> rbsp;
+    rbsp.push_back(kSeiPayloadTypeUserDataUnregistered);
+    rbsp.push_back(kSeiPayloadSize);
+    rbsp.insert(rbsp.end(), kTimestampUuid, kTimestampUuid + sizeof(kTimestampUuid));
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        rbsp.push_back(static_cast<uint8_t>(static_cast<uint64_t>(timestamp_us) >> shift));
+    }
+    rbsp.push_back(0x80);  // rbsp_trailing_bits
+
+    std::vector<uint8_t> nal;
+    if (codec_id == AV_CODEC_ID_H264) {
+        nal.push_back(0x06);         // nal_ref_idc=0, type=6 (SEI)
+    } else {
+        nal.push_back(39 << 1);      // type=39 (PREFIX_SEI)
+        nal.push_back(0x01);         // layer_id=0, temporal_id_plus1=1
+    }
+
+    int zeros = 0;
+    for (uint8_t byte : rbsp) {
+        if (zeros >= 2 && byte <= 3) {
+            nal.push_back(0x03);
+            zeros = 0;
+        }
+        nal.push_back(byte);
+        zeros = byte == 0 ? zeros + 1 : 0;
+    }
+    return nal;
+}
+
+} // namespace
+
+int seiNalLengthSize(const AVCodecParameters* codecpar) {
+    const uint8_t* extradata = codecpar->extradata;
+    const int size = codecpar->extradata_size;
+    if (!extradata || size < 7) {
+        return 0;
+    }
+
+    // 以起始码开头的extradata表示Annex B
+    if (extradata[0] == 0 && extradata[1] == 0
+        && (extradata[2] == 1 || (extradata[2] == 0 && extradata[3] == 1))) {
+        return 0;
+    }
+
+    if (codecpar->codec_id == AV_CODEC_ID_H264) {
+        return (extradata[4] & 0x03) + 1;
+    }
+    if (codecpar->codec_id == AV_CODEC_ID_HEVC && size >= 23) {
+        return (extradata[21] & 0x03) + 1;
+    }
+    return 0;
+}
+
+bool insertTimestampSei(AVPacket* packet, AVCodecID codec_id,
+                        int nal_length_size, int64_t timestamp_us) {
+    if (codec_id != AV_CODEC_ID_H264 && codec_id != AV_CODEC_ID_HEVC) {
+        return false;
+    }
+    if (!packet->data || packet->size <= 0) {
+        return false;
+    }
+
+    const int offset = findFirstVcl(packet->data, packet->size, codec_id, nal_length_size);
+    if (offset < 0) {
+        return false;
+    }
+
+    const std::vector<uint8_t> nal = buildSeiNal(codec_id, timestamp_us);
+    const int prefix_size = nal_length_size > 0 ? nal_length_size : 4;
+    const int sei_size = prefix_size + static_cast<int>(nal.size());
+
+    AVPacket* out = av_packet_alloc();
+    if (!out) {
+        return false;
+    }
+    if (av_new_packet(out, packet->size + sei_size) < 0 || av_packet_copy_props(out, packet) < 0) {
+        av_packet_free(&out);
+        return false;
+    }
+
+    uint8_t* dst = out->data;
+    memcpy(dst, packet->data, offset);
+    dst += offset;
+
+    if (nal_length_size > 0) {
+        for (int i = nal_length_size - 1; i >= 0; i--) {
+            *dst++ = static_cast<uint8_t>(nal.size() >> (8 * i));
+        }
+    } else {
+        const uint8_t start_code[4] = { 0, 0, 0, 1 };
+        memcpy(dst, start_code, sizeof(start_code));
+        dst += sizeof(start_code);
+    }
+    memcpy(dst, nal.data(), nal.size());
+    dst += nal.size();
+    memcpy(dst, packet->data + offset, packet->size - offset);
+
+    av_packet_unref(packet);
+    av_packet_move_ref(packet, out);
+    av_packet_free(&out);
+    return true;
+}